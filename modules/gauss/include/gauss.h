@@ -10,13 +10,17 @@
 #include <gauss/dimensionality.h>
 #include <gauss/distances.h>
 #include <gauss/features.h>
+#include <gauss/featureset.h>
 #include <gauss/fft.h>
 #include <gauss/filters.h>
 #include <gauss/linalg.h>
 #include <gauss/matrix.h>
+#include <gauss/metric_index.h>
 #include <gauss/normalization.h>
 #include <gauss/polynomial.h>
+#include <gauss/ragged.h>
 #include <gauss/regression.h>
 #include <gauss/regularization.h>
+#include <gauss/rolling.h>
 #include <gauss/statistics.h>
 #include <gauss/random.h>
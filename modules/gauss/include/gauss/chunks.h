@@ -0,0 +1,52 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_CHUNKS_H
+#define GAUSS_CHUNKS_H
+
+#include <arrayfire.h>
+#include <gauss/defines.h>
+
+#include <vector>
+
+namespace gauss::features {
+
+/**
+ * @brief Functions used to summarise the values of a chunk.
+ *
+ * SUM, MEAN, MINIMUM and MAXIMUM: as their names say.
+ *
+ * VARIANCE: population variance (ddof = 0) of the values.
+ *
+ * ENERGY: sum of the squares of the values.
+ *
+ * LINEAR_TREND: slope of the least-squares line fitted to the values against their position in the chunk; it is
+ * not defined for chunks holding a single value.
+ */
+enum class Aggregation { SUM, MEAN, MINIMUM, MAXIMUM, VARIANCE, ENERGY, LINEAR_TREND };
+
+/**
+ * @brief Splits every time series into consecutive chunks and summarises each chunk with the given aggregations.
+ *
+ * The aggregations are computed on the device with one reduction over the full chunks of all the series, laid
+ * out as columns, plus one over the trailing values: the series are not padded, so when the length of the series
+ * is not a multiple of chunkSize, the last chunk just holds the remaining values.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param chunkSize Number of values in each chunk.
+ * @param aggregations Aggregations to compute.
+ *
+ * @return af::array A (chunks, series, aggregations) array, where the i-th chunk of each series starts at position
+ * i * chunkSize.  It is f64 if tss is f64, or f32 otherwise.
+ */
+GAUSSAPI af::array aggregateOnChunks(const af::array &tss, dim_t chunkSize,
+                                     const std::vector<Aggregation> &aggregations);
+
+}  // namespace gauss::features
+
+#endif
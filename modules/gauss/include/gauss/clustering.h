@@ -10,27 +10,268 @@
 
 #include <arrayfire.h>
 #include <gauss/defines.h>
+#include <gauss/distances.h>
 
+#include <optional>
 #include <vector>
 
 namespace gauss::clustering {
 
+/**
+ * @brief Chooses k initial centroids among the columns of tss as per k-means++.
+ *
+ * [1] David Arthur and Sergei Vassilvitskii. 2007. k-means++: the advantages of careful seeding. In Proceedings
+ * of the eighteenth annual ACM-SIAM symposium on Discrete algorithms (SODA '07), 1027-1035.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of centroids to be chosen.
+ * @param engine Configured engine for seeding the generation.  Defaults to empty option.
+ * @return A (series length, k) matrix with the initial centroids.
+ */
+GAUSSAPI af::array kMeansPlusPlus(const af::array &tss, int k,
+                                  const std::optional<af::randomEngine> &engine = std::nullopt);
+
 /**
  * @brief Calculates the k-means algorithm.
  *
  * [1] S. Lloyd. 1982. Least squares quantization in PCM. IEEE Transactions on Information Theory, 28, 2,
  * Pages 129-137.
  *
+ * Distances are computed in blocks of series through the expansion ||x||^2 + ||c||^2 - 2 c'x, which reduces
+ * to a matrix product, and the means are updated with a segmented reduction over the labels.
+ *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
  * dimension one indicates the number of time series.
  * @param k The number of means to be computed.
- * @param centroids The resulting means or centroids.
- * @param labels The resulting labels of each time series which is the closest centroid.
+ * @param centroids (in-out) The resulting means or centroids.  When empty, the initial centroids are chosen
+ * with kMeansPlusPlus.
+ * @param labels (out) The resulting labels of each time series which is the closest centroid.
  * @param tolerance The error tolerance to stop the computation of the centroids.
  * @param maxIterations The maximum number of iterations allowed.
+ * @param engine Configured engine for seeding the initial centroids.  Defaults to empty option.
  */
 GAUSSAPI void kMeans(const af::array &tss, int k, af::array &centroids, af::array &labels,
-                     float tolerance = 0.0000000001, int maxIterations = 100);
+                     float tolerance = 0.0000000001, int maxIterations = 100,
+                     const std::optional<af::randomEngine> &engine = std::nullopt);
+
+/**
+ * @brief Calculates the k-means algorithm, using the triangle inequality to skip distance computations.
+ *
+ * [1] Greg Hamerly. 2010. Making k-means even faster. In Proceedings of the 2010 SIAM International Conference
+ * on Data Mining (SDM), 130-140.
+ *
+ * Every time series keeps an upper bound of the distance to its mean and a lower bound of the distance to any
+ * other mean; only those series whose bounds overlap are compared against all the means.  The memory overhead
+ * is two values per series, regardless of k, and the labels and centroids are the ones computed by kMeans
+ * given the same initial centroids.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of means to be computed.
+ * @param centroids (in-out) The resulting means or centroids.  When empty, the initial centroids are chosen
+ * with kMeansPlusPlus.
+ * @param labels (out) The resulting labels of each time series which is the closest centroid.
+ * @param tolerance The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ * @param engine Configured engine for seeding the initial centroids.  Defaults to empty option.
+ */
+GAUSSAPI void kMeansHamerly(const af::array &tss, int k, af::array &centroids, af::array &labels,
+                            float tolerance = 0.0000000001, int maxIterations = 100,
+                            const std::optional<af::randomEngine> &engine = std::nullopt);
+
+/**
+ * @brief Runs k-means from several k-means++ seedings, concurrently using the host threads, and keeps the model
+ * with the lowest inertia.
+ *
+ * Restart r draws its initial centroids from an engine seeded with seed + r, so results are reproducible and do
+ * not depend on the number of threads.  The norms of the time series are computed once for all the restarts.
+ *
+ * @param tss Columnar matrix with the time series.
+ * @param k The number of means to be computed.
+ * @param centroids (out) The centroids of the best restart.
+ * @param labels (out) The labels of the best restart.
+ * @param nInit The number of restarts.
+ * @param seed Seed of the first restart.
+ * @param tolerance The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ * @param useHamerly Whether the restarts run kMeansHamerly instead of kMeans.
+ * @return The inertia (sum of squared distances of the series to their centroids) of the best restart.
+ */
+GAUSSAPI double kMeansRestarts(const af::array &tss, int k, af::array &centroids, af::array &labels, int nInit,
+                               unsigned long long seed = 0, float tolerance = 0.0000000001, int maxIterations = 100,
+                               bool useHamerly = false);
+
+/**
+ * State of a mini-batch k-means model, which can be kept around to continue the training as new data arrives.
+ */
+typedef struct minibatch_kmeans_state {
+    // (series length, k) centroids; empty until the first chunk is seen
+    af::array centroids;
+
+    // (1, k) f64 number of series absorbed by each centroid
+    af::array counts;
+
+    // total number of series processed
+    dim_t seen = 0;
+
+} minibatch_kmeans_state_t;
+
+/**
+ * @brief Updates a mini-batch k-means model with a chunk of time series.
+ *
+ * [1] D. Sculley. 2010. Web-scale k-means clustering. In Proceedings of the 19th international conference on
+ * World Wide Web (WWW '10), 1177-1178.
+ *
+ * The series of the chunk are assigned to their closest centroid, which then moves towards them with a per
+ * centroid learning rate of one over the number of series it has absorbed.  Feeding the chunks of a dataset,
+ * one at a time, clusters it without ever holding all of it in memory.
+ *
+ * @param state (in-out) The model.  When it has no centroids, they are chosen from the chunk with
+ * kMeansPlusPlus, so the first chunk must hold at least k series.
+ * @param chunk Columnar matrix with the time series of this update.
+ * @param k The number of means.
+ * @param labels (out) The labels of the series in the chunk, as assigned before the update.
+ * @param engine Configured engine for seeding the initial centroids.  Defaults to empty option.
+ */
+GAUSSAPI void miniBatchKMeans(minibatch_kmeans_state_t &state, const af::array &chunk, int k, af::array &labels,
+                              const std::optional<af::randomEngine> &engine = std::nullopt);
+
+/**
+ * @brief Labels each time series with the column of its closest centroid.
+ *
+ * @param tss Input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param centroids Input (columnar) array with the centroids computed by kMeans.
+ * @return A u32 column vector with the labels.
+ */
+GAUSSAPI af::array kMeansClassify(const af::array &tss, const af::array &centroids);
+
+/**
+ * @brief Criteria used by hierarchical clustering to measure the distance between two clusters.
+ *
+ * SINGLE: closest pair of members.
+ * COMPLETE: furthest pair of members.
+ * AVERAGE: mean distance over all the pairs of members (UPGMA).
+ * WARD: increase of the within cluster variance; distances are interpreted as euclidean.
+ */
+enum class Linkage { SINGLE, COMPLETE, AVERAGE, WARD };
+
+/**
+ * @brief Hierarchical agglomerative clustering of a precomputed dissimilarity matrix with the nearest neighbour
+ * chain algorithm, in O(n^2) time.
+ *
+ * [1] Daniel Müllner. 2011. Modern hierarchical, agglomerative clustering algorithms. arXiv:1109.2378.
+ *
+ * The distances are copied once to a condensed host buffer, which is updated in place with the Lance-Williams
+ * formulas as clusters are merged, so no memory beyond n(n-1)/2 values is required.
+ *
+ * @param dist Either a square (n, n) matrix, as returned by distances::compute, or a condensed vector with the
+ * n(n-1)/2 entries of its upper triangle, in row order.
+ * @param method The linkage criterion.
+ * @return A (n-1, 4) f64 matrix, in the format used by SciPy: row i merges the clusters in columns 0 and 1 (ids
+ * below n are the original series, id n+j is the cluster formed in row j), at the distance in column 2, forming a
+ * cluster whose number of series is given in column 3.
+ */
+GAUSSAPI af::array linkage(const af::array &dist, Linkage method);
+
+/**
+ * @brief Hierarchical agglomerative clustering of a set of time series with the nearest neighbour chain algorithm.
+ *
+ * The condensed dissimilarity buffer is filled directly from the distance algorithm, in blocks of rows, so the
+ * square matrix is never materialised.
+ *
+ * @param algo The distance algorithm, which must be symmetric.
+ * @param tss Columnar matrix with the time series.
+ * @param method The linkage criterion.
+ * @return A (n-1, 4) f64 linkage matrix in the format used by SciPy.
+ */
+GAUSSAPI af::array linkage(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, Linkage method);
+
+/**
+ * @brief Density based clustering (DBSCAN).
+ *
+ * [1] Martin Ester, Hans-Peter Kriegel, Jörg Sander, and Xiaowei Xu. 1996. A density-based algorithm for
+ * discovering clusters in large spatial databases with noise. In Proceedings of the Second International
+ * Conference on Knowledge Discovery and Data Mining (KDD'96), 226-231.
+ *
+ * The eps-neighbourhoods are found with a metric_index when the algorithm is flagged as a metric, or by
+ * computing the distances in blocks of rows otherwise, so the n x n matrix is never materialised.  Core series
+ * are detected concurrently and clusters are the connected components of the core series; border series join
+ * the cluster of their first core neighbour.
+ *
+ * @param algo The distance algorithm.
+ * @param tss Columnar matrix with the time series.
+ * @param eps Radius of the neighbourhoods.
+ * @param minSamples Number of series in the neighbourhood of a core series, including itself.
+ * @param labels (out) s32 vector with the cluster of each series, or -1 for noise.
+ * @param core (out) b8 vector flagging the core series.
+ */
+GAUSSAPI void dbscan(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, double eps,
+                     int minSamples, af::array &labels, af::array &core);
+
+/**
+ * @brief Hierarchical density based clustering (HDBSCAN).
+ *
+ * [1] Ricardo J. G. B. Campello, Davoud Moulavi, and Joerg Sander. 2013. Density-based clustering based on
+ * hierarchical density estimates. In Advances in Knowledge Discovery and Data Mining (PAKDD 2013), 160-172.
+ *
+ * Core distances are found with k nearest neighbour queries (through a metric_index for metric algorithms, or
+ * blocked otherwise).  The minimum spanning tree of the mutual reachability graph is built with Prim's
+ * algorithm, computing a single row of distances per step, and the clusters are extracted from the condensed
+ * tree by excess of mass.
+ *
+ * @param algo The distance algorithm, which must be symmetric.
+ * @param tss Columnar matrix with the time series.
+ * @param minClusterSize Smallest number of series considered a cluster.
+ * @param minSamples Number of neighbours, including the series itself, that defines the core distance.
+ * @return s32 vector with the cluster of each series, or -1 for noise.
+ */
+GAUSSAPI af::array hdbscan(const gauss::distances::distance_algorithm_t &algo, const af::array &tss,
+                           int minClusterSize, int minSamples);
+
+/**
+ * @brief Calculates the k-medoids of a precomputed dissimilarity matrix with FasterPAM.
+ *
+ * [1] Erich Schubert and Peter J. Rousseeuw. 2021. Fast and eager k-medoids clustering: O(k) runtime improvement
+ * of the PAM, CLARA, and CLARANS algorithms. Information Systems, 101, 101804.
+ *
+ * Swap candidates are evaluated in fixed size groups, concurrently using the host threads, and the best
+ * improving swap of each group is applied eagerly; results do not depend on the number of threads.
+ *
+ * @param dist Either a square (n, n) matrix, as returned by distances::compute, or a condensed vector with the
+ * n(n-1)/2 entries of its upper triangle, in row order.
+ * @param k The number of medoids.
+ * @param medoids (in-out) u32 vector with the column indices of the medoids.  When empty, the initial medoids
+ * are drawn at random.
+ * @param labels (out) u32 vector with the position, in medoids, of the closest medoid of each series.
+ * @param maxIterations The maximum number of passes over the swap candidates.
+ * @param seed Seed used to draw the initial medoids.
+ */
+GAUSSAPI void kMedoids(const af::array &dist, int k, af::array &medoids, af::array &labels, int maxIterations = 100,
+                       unsigned int seed = 0);
+
+/**
+ * @brief Calculates the k-medoids of a set of time series with FasterPAM, evaluating the distance algorithm
+ * lazily.
+ *
+ * The distances from a series to all the others are only computed when the series is considered as a medoid
+ * or as a swap candidate, and up to cacheRows of those rows are kept in a least recently used cache, so the
+ * n x n matrix is never materialised.
+ *
+ * @param algo The distance algorithm.
+ * @param tss Columnar matrix with the time series.
+ * @param k The number of medoids.
+ * @param medoids (in-out) u32 vector with the column indices of the medoids.  When empty, the initial medoids
+ * are drawn at random.
+ * @param labels (out) u32 vector with the position, in medoids, of the closest medoid of each series.
+ * @param maxIterations The maximum number of passes over the swap candidates.
+ * @param seed Seed used to draw the initial medoids.
+ * @param cacheRows Maximum number of rows of distances kept in memory.
+ */
+GAUSSAPI void kMedoids(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, int k,
+                       af::array &medoids, af::array &labels, int maxIterations = 100, unsigned int seed = 0,
+                       dim_t cacheRows = 4096);
 
 /**
  * @brief Calculates the k-shape algorithm.
@@ -52,9 +293,32 @@ GAUSSAPI void kMeans(const af::array &tss, int k, af::array &centroids, af::arra
  * 
  * @param rnd_labels When no labels are given, this parameter controls if the initial labels are to be generated 
  * from draws of a uniform distribution; when set to false, the initial labels will be assigned sequentially.
+ *
+ * @param engine Configured engine for drawing the random labels.  Defaults to empty option.
  */
 GAUSSAPI void kshape_calibrate(const af::array &tss, int k, af::array &labels, af::array &centroids, 
-    const int maxIterations = 100, const bool rnd_labels = false);
+    const int maxIterations = 100, const bool rnd_labels = false,
+    const std::optional<af::randomEngine> &engine = std::nullopt);
+
+/**
+ * @brief Runs the k-shape algorithm from several random labelings, concurrently using the host threads, and keeps
+ * the model with the lowest inertia.
+ *
+ * Restart r draws its initial labels from an engine seeded with seed + r, so results are reproducible and do not
+ * depend on the number of threads.  The normalised series and their spectra are computed once for all the
+ * restarts.
+ *
+ * @param tss Columnar matrix with the time series.
+ * @param k The number of centroids.
+ * @param centroids (out) The centroids of the best restart.
+ * @param labels (out) The labels of the best restart.
+ * @param nInit The number of restarts.
+ * @param seed Seed of the first restart.
+ * @param maxIterations The maximum number of iterations allowed.
+ * @return The inertia (sum of shape based distances of the series to their centroids) of the best restart.
+ */
+GAUSSAPI double kshape_restarts(const af::array &tss, int k, af::array &centroids, af::array &labels, int nInit,
+                                unsigned long long seed = 0, int maxIterations = 100);
 
 /**
  * @brief Classifies the time series as per the centroids computed in the calibration phase.
@@ -69,6 +333,71 @@ GAUSSAPI void kshape_calibrate(const af::array &tss, int k, af::array &labels, a
  */
 GAUSSAPI af::array kshape_classify(const af::array &tss, const af::array &centroids);
 
+/**
+ * @brief Classifier that assigns new time series to fixed k-shape centroids, tuned for low latency scoring of
+ * small batches.
+ *
+ * The spectra and norms of the centroids, replicated for a full batch, and the indices of the valid lags are
+ * computed once.  Series are scored in batches of batchSize columns (the last one is padded) so every call
+ * issues transforms and products of the same shape, whose buffers are recycled by the ArrayFire memory manager
+ * and whose kernels are compiled once.
+ */
+class GAUSSAPI kshape_classifier {
+public:
+    /**
+     * @brief Compiles the classifier.
+     *
+     * @param centroids Columnar matrix with the (znorm) centroids, as computed by kshape_calibrate.
+     * @param batchSize Number of series scored together.
+     */
+    explicit kshape_classifier(const af::array &centroids, dim_t batchSize = 64);
+
+    /**
+     * @brief Finds the centroid with the largest normalised cross correlation to each series.
+     *
+     * @param tss Columnar matrix with the series to classify, of the same length as the centroids.
+     * @return u32 column vector with the labels.
+     */
+    af::array classify(const af::array &tss) const;
+
+    /**
+     * @brief Finds the centroid with the largest normalised cross correlation to each series.
+     *
+     * @param tss Columnar matrix with the series to classify, of the same length as the centroids.
+     * @param similarity (out) Column vector with the normalised cross correlation to the chosen centroid.
+     * @return u32 column vector with the labels.
+     */
+    af::array classify(const af::array &tss, af::array &similarity) const;
+
+    /**
+     * @brief Length of the centroids.
+     */
+    dim_t length() const { return _length; }
+
+    /**
+     * @brief Number of centroids.
+     */
+    dim_t clusters() const { return _clusters; }
+
+    /**
+     * @brief Number of series scored together.
+     */
+    dim_t batchSize() const { return _batchSize; }
+
+private:
+    dim_t _length;
+    dim_t _clusters;
+    dim_t _batchSize;
+    dim_t _fftLength;
+
+    // (bins, k, batch) conjugated spectra of the centroids
+    af::array _spectra;
+    // (1, k, batch) norms of the centroids
+    af::array _norms;
+    // positions of the 2m - 1 valid lags in the circular cross correlation
+    af::array _lags;
+};
+
 }  // namespace gauss
 
 #endif
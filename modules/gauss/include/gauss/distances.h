@@ -12,6 +12,8 @@
 #include <gauss/defines.h>
 #include <optional>
 #include <functional>
+#include <limits>
+#include <tuple>
 
 namespace gauss::distances {
 
@@ -36,6 +38,25 @@ typedef struct distance_algorithm {
     // second argument.
     std::function<af::array(const af::array&, const af::array&)> compute;
 
+    // Flags those algorithms that satisfy the properties of a 
+    // metric (identity, symmetry and triangle inequality), 
+    // which enables the use of metric indices.
+    bool is_metric = false;
+
+    // Optionally computes the full (xa_len, xb_len) matrix in a 
+    // single call.  Algorithms that can share work across columns 
+    // (for instance, by transforming every series only once) 
+    // provide it, and compute (see below) uses it instead of 
+    // running the algorithm column by column.
+    std::optional<std::function<af::array(const af::array&, const af::array&)>> compute_all = std::nullopt;
+
+    // Optionally computes the distance between two series held
+    // in host buffers, which may have different lengths.  The
+    // algorithms evaluated on the host (the elastic family)
+    // provide it, so ragged collections (see gauss/ragged.h)
+    // are compared without moving every pair to the device.
+    std::optional<std::function<double(const double*, dim_t, const double*, dim_t)>> compute_pair = std::nullopt;
+
 } distance_algorithm_t;
 
 /**
@@ -49,6 +70,78 @@ af::array compute(const distance_algorithm_t& algo, const af::array& xa);
  */ 
 af::array compute(const distance_algorithm_t& algo, const af::array& xa, const af::array &xb);
 
+/**
+ * @brief Finds, for every column in xa, the k nearest columns in xb as per algo.
+ * 
+ * xb is consumed in blocks of block_size columns; after each block only the k best 
+ * candidates per column of xa are retained, so the memory footprint is bounded by 
+ * (xa_len, k + block_size) regardless of the number of columns in xb.
+ * 
+ * @return A tuple whose first element is a (xa_len, k) matrix with the distances, sorted 
+ * in ascending order by row, and whose second element is a (xa_len, k) matrix of u32 
+ * values with the column indices in xb of those neighbours.
+ */ 
+std::tuple<af::array, af::array> knn(const distance_algorithm_t& algo, const af::array& xa, const af::array &xb, 
+                                     int k, dim_t block_size = 1024);
+
+
+/**
+ * Spectra of a set of time series, as required by the shape based distance.
+ */ 
+typedef struct sbd_spectra {
+    // number of points of the series
+    dim_t length;
+
+    // length of the zero padded transforms
+    dim_t fft_length;
+
+    // one sided spectra, laid out as (fft_length / 2 + 1, n)
+    af::array spectra;
+
+    // euclidean norm of every series, laid out as (1, n)
+    af::array norms;
+
+} sbd_spectra_t;
+
+/**
+ * @brief Transforms the columns of tss so they can be repeatedly used in sbd_ncc.
+ * 
+ * @param tss Columnar matrix with the time series.
+ * @param fft_length Length of the transforms; use sbd_fft_length to compute it, as both 
+ * operands of sbd_ncc must share it.
+ */ 
+sbd_spectra_t sbd_prepare(const af::array &tss, dim_t fft_length);
+
+/**
+ * @brief Smallest efficient transform length that holds the full cross correlation of two 
+ * series of xa_rows and xb_rows points.
+ */ 
+dim_t sbd_fft_length(dim_t xa_rows, dim_t xb_rows);
+
+/**
+ * @brief Maximum normalised cross correlation of every series in xa against every series in xb.
+ * 
+ * The products of the spectra are evaluated in blocks of at most block_pairs pairs, each block 
+ * being brought back to the time domain with a single batched inverse transform.
+ * 
+ * @return A (xa_len, xb_len) matrix; the shape based distance is one minus this value.
+ */ 
+af::array sbd_ncc(const sbd_spectra_t &xa, const sbd_spectra_t &xb, dim_t block_pairs = 16384);
+
+/**
+ * Options shared by the elastic distances (dtw, ddtw, wdtw, erp, lcss, msm and twe)
+ */
+typedef struct elastic_options {
+    // Width of the Sakoe-Chiba band, as a fraction of the length 
+    // of the longest series; 1.0 leaves the warping path unconstrained.
+    double window = 1.0;
+
+    // Early abandoning threshold; as soon as a distance is known to 
+    // be greater than this value, its computation stops and +inf is 
+    // reported instead.  It has no effect on lcss.
+    double cutoff = std::numeric_limits<double>::infinity();
+
+} elastic_options_t;
 
 /////////////////
 // Built-in Algos
@@ -65,7 +158,9 @@ distance_algorithm_t cosine();
 distance_algorithm_t czekanowski();
 distance_algorithm_t dice();
 distance_algorithm_t divergence();
-distance_algorithm_t dtw();
+distance_algorithm_t dtw(const elastic_options_t &opts = {});
+distance_algorithm_t ddtw(const elastic_options_t &opts = {});
+distance_algorithm_t erp(double g = 0.0, const elastic_options_t &opts = {});
 distance_algorithm_t euclidean();
 distance_algorithm_t fidelity();
 distance_algorithm_t gower();
@@ -83,6 +178,7 @@ distance_algorithm_t kulczynski();
 distance_algorithm_t kullback();
 distance_algorithm_t kumar_johnson();
 distance_algorithm_t kumarhassebrook();
+distance_algorithm_t lcss(double epsilon, const elastic_options_t &opts = {});
 distance_algorithm_t lorentzian();
 distance_algorithm_t manhattan();
 distance_algorithm_t matusita();
@@ -90,6 +186,7 @@ distance_algorithm_t max_symmetric_chi();
 distance_algorithm_t min_symmetric_chi();
 distance_algorithm_t minkowski(double p);
 distance_algorithm_t mpdist(int32_t w, double threshold = 0.05);
+distance_algorithm_t msm(double c = 1.0, const elastic_options_t &opts = {});
 distance_algorithm_t neyman();
 distance_algorithm_t pearson();
 distance_algorithm_t prob_symmetric_chi();
@@ -101,8 +198,10 @@ distance_algorithm_t squared_chi();
 distance_algorithm_t squared_euclidean();
 distance_algorithm_t taneja();
 distance_algorithm_t topsoe();
+distance_algorithm_t twe(double nu = 0.001, double lambda = 1.0, const elastic_options_t &opts = {});
 distance_algorithm_t vicis_wave_hedges();
 distance_algorithm_t wavehedges();
+distance_algorithm_t wdtw(double g = 0.05, const elastic_options_t &opts = {});
 distance_algorithm_t tanimoto();
 distance_algorithm_t ruzicka();
 distance_algorithm_t motyka();
@@ -9,8 +9,11 @@
 #define GAUSS_FEATURES_H
 
 #include <arrayfire.h>
+#include <gauss/chunks.h>
 #include <gauss/defines.h>
 
+#include <vector>
+
 namespace gauss::features {
 
 
@@ -44,41 +47,36 @@ GAUSSAPI af::array absoluteSumOfChanges(const af::array &tss);
 
 
 
-// /**
-//  * @brief Calculates a linear least-squares regression for values of the time series that were aggregated over chunks
-//  * versus the sequence from 0 up to the number of chunks minus one.
-//  *
-//  * @param t The time series to calculate the features of.
-//  * @param chunkSize The chunkSize used to aggregate the data.
-//  * @param aggregationFunction Function to be used in the aggregation.
-//  * @param slope Slope of the regression line.
-//  * @param intercept Intercept of the regression line.
-//  * @param rvalue Correlation coefficient.
-//  * @param pvalue Two-sided p-value for a hypothesis test whose null hypothesis is that the slope is zero, using
-//  * Wald Test with t-distribution of the test statistic.
-//  * @param stderrest Standard error of the estimated gradient.
-//  */
-// GAUSSAPI void aggregatedLinearTrend(const af::array &t, long chunkSize, AggregationFuncDimT aggregationFunction,
-//                                     af::array &slope, af::array &intercept, af::array &rvalue, af::array &pvalue,
-//                                     af::array &stderrest);
-
-// /**
-//  * @brief Calculates a linear least-squares regression for values of the time series that were aggregated over chunks
-//  * versus the sequence from 0 up to the number of chunks minus one.
-//  *
-//  * @param t The time series to calculate the features of.
-//  * @param chunkSize The chunkSize used to aggregate the data.
-//  * @param aggregationFunction Function to be used in the aggregation.
-//  * @param slope Slope of the regression line.
-//  * @param intercept Intercept of the regression line.
-//  * @param rvalue Correlation coefficient.
-//  * @param pvalue Two-sided p-value for a hypothesis test whose null hypothesis is that the slope is zero, using
-//  * Wald Test with t-distribution of the test statistic.
-//  * @param stderrest Standard error of the estimated gradient.
-//  */
-// GAUSSAPI void aggregatedLinearTrend(const af::array &t, long chunkSize, AggregationFuncInt aggregationFunction,
-//                                     af::array &slope, af::array &intercept, af::array &rvalue, af::array &pvalue,
-//                                     af::array &stderrest);
+/**
+ * @brief Calculates a linear least-squares regression for values of the time series that were aggregated over chunks
+ * versus the sequence from 0 up to the number of chunks minus one.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param chunkSize The chunkSize used to aggregate the data; the last chunk holds the remaining values when the
+ * length of the time series is not a multiple of it.
+ * @param aggregation Aggregation used to summarise the chunks.
+ * @param slope Slope of the regression line.
+ * @param intercept Intercept of the regression line.
+ * @param rvalue Correlation coefficient.
+ * @param pvalue Two-sided p-value for a hypothesis test whose null hypothesis is that the slope is zero, using
+ * Wald Test with t-distribution of the test statistic.
+ * @param stderrest Standard error of the estimated gradient.
+ */
+GAUSSAPI void aggregatedLinearTrend(const af::array &tss, long chunkSize, Aggregation aggregation, af::array &slope,
+                                    af::array &intercept, af::array &rvalue, af::array &pvalue,
+                                    af::array &stderrest);
+
+/**
+ * @brief Calculates the linear least-squares regressions of the time series aggregated over chunks with several
+ * aggregations at once.  The chunks are summarised with all the aggregations in a single sweep over the data, and
+ * the regressions of all the aggregations and time series are computed together.
+ *
+ * The results are (aggregations, series) arrays, whose i-th row holds the regression of the i-th aggregation.
+ */
+GAUSSAPI void aggregatedLinearTrend(const af::array &tss, long chunkSize, const std::vector<Aggregation> &aggregations,
+                                    af::array &slope, af::array &intercept, af::array &rvalue, af::array &pvalue,
+                                    af::array &stderrest);
 
 /**
  * @brief Calculates a vectorized Approximate entropy algorithm (https://en.wikipedia.org/wiki/Approximate_entropy).
@@ -89,9 +87,13 @@ GAUSSAPI af::array absoluteSumOfChanges(const af::array &tss);
  * Other shortcomings and alternatives discussed in:
  * Richman & Moorman, Physiological time-series analysis using approximate entropy and sample entropy, (2000).
  *
+ * Templates of length one are matched with binary searches over the sorted values, in O(n log n).  Longer ones are
+ * bucketed in a grid of cells of side r times the standard deviation, so only templates in neighbouring cells are
+ * compared, and the time series are processed concurrently on the host threads.
+ *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
  * dimension one indicates the number of time series.
- * @param m Length of compared run of data.
+ * @param m Length of compared run of data, must be greater than zero.
  * @param r Filtering level, must be positive.
  *
  * @return af::array An array with the same dimensions as tss, whose values (time series in dimension 0) contains
@@ -201,7 +203,8 @@ GAUSSAPI af::array cwtCoefficients(const af::array &tss, const af::array &widths
 
 /**
  * @brief Calculates the sum of squares of chunk i out of N chunks expressed as a ratio with the sum of squares over
- * the whole series. segmentFocus should be lower than the number of segments.
+ * the whole series. segmentFocus should be lower than the number of segments.  The energies of all the segments are
+ * computed in one sweep with aggregateOnChunks.
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and dimension
  * one indicates the number of time series.
@@ -541,7 +544,8 @@ GAUSSAPI af::array numberCrossingM(const af::array &tss, int m);
 /**
  * @brief This feature calculator searches for different peaks. To do so, the time series is smoothed by a ricker
  * wavelet and for widths ranging from 1 to maxW. This feature calculator returns the number of peaks that occur at
- * enough width scales and with sufficiently high Signal-to-Noise-Ratio (SNR).
+ * enough width scales and with sufficiently high Signal-to-Noise-Ratio (SNR), as scipy.signal.find_peaks_cwt does
+ * (see gauss/peaks.h).
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and dimension
  * one indicates the number of time series.
@@ -549,7 +553,7 @@ GAUSSAPI af::array numberCrossingM(const af::array &tss, int m);
  *
  * @return af::array The number of peaks for each time series.
  */
-//GAUSSAPI af::array numberCwtPeaks(const af::array &tss, int maxW);
+GAUSSAPI af::array numberCwtPeaks(const af::array &tss, int maxW);
 
 /**
  * @brief Calculates the number of peaks of at least support \f$n\f$ in the time series \f$tss\f$. A peak of support
@@ -664,6 +668,9 @@ GAUSSAPI af::array ratioValueNumberToTimeSeriesLength(const af::array &tss);
  *
  * [4] https://www.ncbi.nlm.nih.gov/pubmed/10843903?dopt=Abstract
  *
+ * Values are sorted and the pairs within the tolerance are counted with a sliding window, in O(n log n), and the
+ * time series are processed concurrently on the host threads.
+ *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and dimension
  * one indicates the number of time series.
  *
@@ -687,7 +694,8 @@ GAUSSAPI af::array skewness(const af::array &tss);
  * @brief Estimates the cross power spectral density of the time series tss at different frequencies. To do so, the
  * time series is first shifted from the time domain to the frequency domain. Welch's method computes an estimate of the
  * power spectral density by dividing the data into overlapping segments, computing a modified periodogram for each
- * segment and averaging the periodograms.
+ * segment and averaging the periodograms.  Segments are min(n, 256) points long, overlap by half their length and
+ * are tapered with a Hann window (see gauss::fft::welch).
  *
  * [1] P. Welch, "The use of the fast Fourier transform for the estimation of power spectra: A method based on time
  * averaging over short, modified periodograms", IEEE Trans. Audio Electroacoust. vol. 15, pp. 70-73, 1967.
@@ -699,14 +707,15 @@ GAUSSAPI af::array skewness(const af::array &tss);
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and dimension
  * one indicates the number of time series.
- * @param coeff The coefficient to be returned.
+ * @param coeff The coefficient to be returned, between zero and half the length of the segments.
  *
  * @return af::array Containing the power spectrum of the different frequencies for each time series in tss.
  */
 GAUSSAPI af::array spktWelchDensity(const af::array &tss, int coeff);
 
 /**
- * @brief Calculates the standard deviation of each time series within tss.
+ * @brief Calculates the standard deviation of each time series within tss.  It is the population standard deviation,
+ * whose variance is divided by the length of the time series.
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and dimension
  * one indicates the number of time series.
@@ -796,7 +805,8 @@ GAUSSAPI af::array timeReversalAsymmetryStatistic(const af::array &tss, int lag)
 GAUSSAPI af::array valueCount(const af::array &tss, float v);
 
 /**
- * @brief Computes the variance for the time series tss.
+ * @brief Computes the variance for the time series tss.  It is the population variance, the mean of the squared
+ * deviations from the mean.
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and dimension
  * one indicates the number of time series.
@@ -807,7 +817,8 @@ GAUSSAPI af::array variance(const af::array &tss);
 
 /**
  * @brief Calculates if the variance of tss is greater than the standard deviation. In other words, if the variance of
- * tss is larger than 1.
+ * tss is larger than 1.  The variance is the sample one (ddof = 1), whereas the standard deviation is the population
+ * one, as computed by standardDeviation.
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and dimension
  * one indicates the number of time series.
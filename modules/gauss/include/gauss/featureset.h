@@ -0,0 +1,162 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_FEATURESET_H
+#define GAUSS_FEATURESET_H
+
+#include <arrayfire.h>
+#include <gauss/defines.h>
+
+#include <vector>
+
+namespace gauss::features {
+
+/**
+ * @brief Features that can be requested from a FeatureSet.  Each one yields a single value per time series and
+ * mirrors the function of the same name in gauss/features.h; the parameters they expect, in order, are listed
+ * next to them.  Features with several outputs (fftCoefficient, fftAggregated and linearTrend) are split in one
+ * entry per output.
+ */
+enum class Feature {
+    ABS_ENERGY,
+    ABSOLUTE_SUM_OF_CHANGES,
+    APPROXIMATE_ENTROPY,                         // m, r
+    BINNED_ENTROPY,                              // max_bins
+    C3,                                          // lag
+    CID_CE,                                      // zNormalize (0 or 1)
+    COUNT_ABOVE_MEAN,
+    COUNT_BELOW_MEAN,
+    ENERGY_RATIO_BY_CHUNKS,                      // numSegments, segmentFocus
+    FFT_AGGREGATED_CENTROID,
+    FFT_AGGREGATED_VARIANCE,
+    FFT_AGGREGATED_SKEW,
+    FFT_AGGREGATED_KURTOSIS,
+    FFT_COEFFICIENT_REAL,                        // coefficient
+    FFT_COEFFICIENT_IMAG,                        // coefficient
+    FFT_COEFFICIENT_ABS,                         // coefficient
+    FFT_COEFFICIENT_ANGLE,                       // coefficient
+    FIRST_LOCATION_OF_MAXIMUM,
+    FIRST_LOCATION_OF_MINIMUM,
+    HAS_DUPLICATES,
+    HAS_DUPLICATE_MAX,
+    HAS_DUPLICATE_MIN,
+    INDEX_MASS_QUANTILE,                         // q
+    KURTOSIS,
+    LARGE_STANDARD_DEVIATION,                    // r
+    LAST_LOCATION_OF_MAXIMUM,
+    LAST_LOCATION_OF_MINIMUM,
+    LENGTH,
+    LINEAR_TREND_PVALUE,
+    LINEAR_TREND_RVALUE,
+    LINEAR_TREND_INTERCEPT,
+    LINEAR_TREND_SLOPE,
+    LINEAR_TREND_STDERR,
+    LONGEST_STRIKE_ABOVE_MEAN,
+    LONGEST_STRIKE_BELOW_MEAN,
+    MAXIMUM,
+    MEAN,
+    MEAN_ABSOLUTE_CHANGE,
+    MEAN_CHANGE,
+    MEAN_SECOND_DERIVATIVE_CENTRAL,
+    MEDIAN,
+    MINIMUM,
+    NUMBER_CROSSING_M,                           // m
+    NUMBER_CWT_PEAKS,                            // maxW
+    NUMBER_PEAKS,                                // n
+    PERCENTAGE_OF_REOCCURRING_DATAPOINTS_TO_ALL_DATAPOINTS,
+    PERCENTAGE_OF_REOCCURRING_VALUES_TO_ALL_VALUES,
+    RANGE_COUNT,                                 // min, max
+    RATIO_BEYOND_R_SIGMA,                        // r
+    RATIO_VALUE_NUMBER_TO_TIME_SERIES_LENGTH,
+    SAMPLE_ENTROPY,
+    SKEWNESS,
+    SPKT_WELCH_DENSITY,                          // coeff
+    STANDARD_DEVIATION,
+    SUM_OF_REOCCURRING_DATAPOINTS,
+    SUM_OF_REOCCURRING_VALUES,
+    SUM_VALUES,
+    SYMMETRY_LOOKING,                            // r
+    TIME_REVERSAL_ASYMMETRY_STATISTIC,           // lag
+    VALUE_COUNT,                                 // v
+    VARIANCE,
+    VARIANCE_LARGER_THAN_STANDARD_DEVIATION
+};
+
+/**
+ * @brief A feature together with its parameters.
+ */
+typedef struct feature_spec {
+    Feature feature;
+    std::vector<double> params;
+} feature_spec_t;
+
+/**
+ * @brief Computes a single feature straight from its function in gauss/features.h, without sharing any
+ * intermediate result; it serves as the reference of the values computed by a FeatureSet.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param spec Feature to compute, together with its parameters.
+ *
+ * @return af::array A (1, series) row, with the same type as tss.
+ */
+GAUSSAPI af::array computeFeature(const af::array &tss, const feature_spec_t &spec);
+
+/**
+ * @brief Computes a list of features over many time series in one go.
+ *
+ * Most features are derived from a small number of intermediate results (the mean, the centred series, the
+ * variance, a sorted copy, the differences, the spectrum...).  When the set is built, the intermediates required
+ * by each feature are resolved, transitively, into a dependency graph; during the evaluation every intermediate
+ * is computed once, right before its first consumer, and released right after its last one.
+ *
+ * The time series are processed in blocks of columns, so the memory required by the intermediates is bounded by
+ * the size of a block regardless of the number of series.
+ */
+class GAUSSAPI FeatureSet {
+public:
+    /**
+     * @brief Builds the evaluation plan for the given features.
+     *
+     * @param specs Features to compute, in the order they will be found in the result.
+     */
+    explicit FeatureSet(std::vector<feature_spec_t> specs);
+
+    /**
+     * @brief Computes all the features.
+     *
+     * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+     * dimension one indicates the number of time series.
+     * @param blockSize Maximum number of time series evaluated at once.
+     *
+     * @return af::array A (features, series) matrix, with the same type as tss, whose i-th row holds the values of
+     * the i-th feature spec.
+     */
+    af::array compute(const af::array &tss, dim_t blockSize = 1024) const;
+
+    /**
+     * @brief Number of features in the set.
+     */
+    size_t size() const { return _specs.size(); }
+
+    /**
+     * @brief Features in the set, in the order they are computed.
+     */
+    const std::vector<feature_spec_t> &specs() const { return _specs; }
+
+private:
+    af::array computeBlock(const af::array &block) const;
+
+    std::vector<feature_spec_t> _specs;
+
+    // intermediates that are no longer needed once the i-th feature has been computed
+    std::vector<std::vector<int>> _releases;
+};
+
+}  // namespace gauss::features
+
+#endif
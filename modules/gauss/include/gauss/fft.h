@@ -17,6 +17,10 @@ namespace gauss::fft {
 
     enum class Norm { Backward, Orthonormal, Forward };
 
+    enum class Wavelet { Ricker, Morlet };
+
+    enum class SpectralWindow { Hann, Hamming, Boxcar };
+
     /**
      * @brief Computes the spectral derivative of a signal
      * 
@@ -118,6 +122,50 @@ namespace gauss::fft {
      */ 
     GAUSSAPI af::array irfft(const af::array& coef, const std::variant<Norm, double> norm, const af::dim4& outDims);
 
+    /**
+     * @brief Smallest length, greater or equal to n, whose only prime factors are 2, 3, 5 and 7; 
+     * transforms of these lengths are the ones FFT backends compute most efficiently.
+     */ 
+    GAUSSAPI dim_t nextFastLength(dim_t n);
+
+    /**
+     * @brief Continuous wavelet transform of a set of signals, computed for all the widths and signals with a
+     * single batched multiplication in the frequency domain.
+     *
+     * For each width w, the signals are convolved (same mode) with the wavelet sampled on min(10w, n) points, as
+     * scipy.signal.cwt does.  The Ricker (mexican hat) wavelet is real; the Morlet wavelet is the complex
+     * morlet2 of scipy, scaled so the energy is the same for every width.
+     *
+     * @param tss Column vector or columnar matrix with the signals, all of length n.
+     * @param widths Vector with the widths (scales) of the wavelet, all of them greater than zero.
+     * @param wavelet Mother wavelet.
+     * @param omega0 Central frequency of the Morlet wavelet; ignored by the Ricker wavelet.
+     * @return af::array A (widths, n, signals) array with the scalogram of each signal, complex for the Morlet
+     * wavelet.
+     */
+    GAUSSAPI af::array cwt(const af::array& tss, const af::array& widths, Wavelet wavelet = Wavelet::Ricker,
+                           double omega0 = 5.0);
+
+    /**
+     * @brief Estimates the power spectral density of a set of signals with Welch's method: the signals are split
+     * in overlapping segments, each segment is detrended (mean removed) and tapered with the window, and the
+     * periodograms of all the segments are averaged.
+     *
+     * The segments of all the signals are framed at once and transformed with a single batched real FFT, so the
+     * cost is one pass over the data regardless of the number of signals.  The result matches the default
+     * density scaling of scipy.signal.welch.
+     *
+     * @param tss Column vector or columnar matrix with the signals, all of length n.
+     * @param segmentLength Length of the segments, between one and n.
+     * @param overlap Points shared by consecutive segments; defaults to half the segment length.
+     * @param window Periodic window applied to every segment.
+     * @param fs Sampling frequency.
+     * @return af::array A (segmentLength / 2 + 1, signals) array with the one sided density of each signal at the
+     * frequencies given by rfftfreq(segmentLength, 1 / fs).
+     */
+    GAUSSAPI af::array welch(const af::array& tss, dim_t segmentLength, std::optional<dim_t> overlap = std::nullopt,
+                             SpectralWindow window = SpectralWindow::Hann, double fs = 1.0);
+
 }
 
 #endif  //GAUSS_FFT_H
\ No newline at end of file
@@ -0,0 +1,144 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_ELASTIC_H
+#define GAUSS_ELASTIC_H
+
+#ifndef BUILDING_GAUSS
+#error Internal headers cannot be included from user code
+#endif
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace gauss::distances::internal {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+/**
+ * @brief Computes the radius of a Sakoe-Chiba band, as a number of cells, for two series of lengths n and m.
+ * Windows greater or equal to one leave the warping path unconstrained.  The radius is never allowed to be
+ * smaller than the slope of the diagonal, so a valid path always exists.
+ */
+inline double bandRadius(dim_t n, dim_t m, double window) {
+    auto longest = static_cast<double>(std::max(n, m));
+    if (window >= 1.0) return longest;
+
+    auto slope = n > 1 ? static_cast<double>(m - 1) / static_cast<double>(n - 1) : static_cast<double>(m);
+    return std::max({std::ceil(std::max(window, 0.0) * longest), 1.0, slope});
+}
+
+/**
+ * @brief Shared dynamic programming engine for elastic distances.
+ *
+ * Evaluates the recurrence
+ *
+ *      D(i,j) = min(D(i-1,j-1) + match(i,j), D(i-1,j) + up(i,j), D(i,j-1) + left(i,j))
+ *
+ * for 1 <= i <= n and 1 <= j <= m (indices are 1-based; element i of a is a[i-1]) with boundaries D(0,j) and
+ * D(i,0) given by the cost model.  Only two rows are kept in memory (prev and curr, each of m+1 elements),
+ * which are reused across calls when possible.
+ *
+ * Cells outside the band are considered unreachable.  When the cost model is monotone (all costs are
+ * non-negative), +inf is returned for any distance greater than cutoff, and the computation is abandoned as
+ * soon as every cell of a row exceeds it.
+ *
+ * The cost model must provide:
+ *  - double row0(j) and col0(i): boundary values.
+ *  - double match(i, j), up(i, j), left(i, j): transition costs.
+ *  - double result(D(n,m)): final transformation of the accumulated cost.
+ *  - static constexpr bool monotone: whether early abandoning is allowed.
+ */
+template <typename Cost>
+double elastic(const Cost &cost, dim_t n, dim_t m, double window, double cutoff, std::vector<double> &prev,
+               std::vector<double> &curr) {
+    prev.resize(static_cast<size_t>(m + 1));
+    curr.resize(static_cast<size_t>(m + 1));
+
+    auto radius = bandRadius(n, m, window);
+    auto slope = n > 1 ? static_cast<double>(m - 1) / static_cast<double>(n - 1) : 0.0;
+    auto bounds = [&](dim_t i, dim_t &lo, dim_t &hi) {
+        auto center = 1.0 + static_cast<double>(i - 1) * slope;
+        lo = std::max<dim_t>(1, static_cast<dim_t>(std::ceil(center - radius)));
+        hi = std::min<dim_t>(m, static_cast<dim_t>(std::floor(center + radius)));
+    };
+
+    for (dim_t j = 0; j <= m; j++) prev[j] = cost.row0(j);
+
+    for (dim_t i = 1; i <= n; i++) {
+        dim_t lo, hi;
+        bounds(i, lo, hi);
+
+        // the boundary cell is part of the row, as paths may still run through column zero
+        curr[lo - 1] = lo == 1 ? cost.col0(i) : INF;
+        auto rowMin = curr[lo - 1];
+        for (dim_t j = lo; j <= hi; j++) {
+            auto best = std::min({prev[j - 1] + cost.match(i, j),
+                                  prev[j] + cost.up(i, j),
+                                  curr[j - 1] + cost.left(i, j)});
+            curr[j] = best;
+            rowMin = std::min(rowMin, best);
+        }
+
+        // cells beyond the band of this row may be read by the next one
+        if (i < n) {
+            dim_t nlo, nhi;
+            bounds(i + 1, nlo, nhi);
+            for (dim_t j = hi + 1; j <= nhi; j++) curr[j] = INF;
+        }
+
+        if constexpr (Cost::monotone) {
+            if (rowMin > cutoff) return INF;
+        }
+
+        std::swap(prev, curr);
+    }
+
+    if constexpr (Cost::monotone) {
+        if (prev[m] > cutoff) return INF;
+    }
+
+    return cost.result(prev[m]);
+}
+
+/**
+ * @brief Weights of WDTW for every possible phase difference between two series whose longest length is len.
+ *
+ * [1] Young-Seon Jeong, Myong K. Jeong, Olufemi A. Omitaomu. 2011. Weighted dynamic time warping for time series
+ * classification. Pattern Recognition, 44, 9, 2231-2240.
+ */
+inline std::vector<double> wdtwWeights(dim_t len, double g) {
+    std::vector<double> weights(static_cast<size_t>(len));
+    auto half = static_cast<double>(len) / 2.0;
+    for (dim_t k = 0; k < len; k++) weights[k] = 1.0 / (1.0 + std::exp(-g * (static_cast<double>(k) - half)));
+    return weights;
+}
+
+/**
+ * @brief Derivative estimate of a series as proposed for Derivative DTW; the first and last points replicate
+ * the estimates of their neighbours.
+ *
+ * [1] Eamonn J. Keogh and Michael J. Pazzani. 2001. Derivative Dynamic Time Warping. In Proceedings of the 2001
+ * SIAM International Conference on Data Mining, 1-11.
+ */
+inline std::vector<double> derivative(const double *x, dim_t n) {
+    std::vector<double> result(static_cast<size_t>(n), 0.0);
+    if (n < 3) return result;
+
+    for (dim_t i = 1; i < n - 1; i++) result[i] = ((x[i] - x[i - 1]) + (x[i + 1] - x[i - 1]) / 2.0) / 2.0;
+    result[0] = result[1];
+    result[n - 1] = result[n - 2];
+    return result;
+}
+
+}  // namespace gauss::distances::internal
+
+#endif
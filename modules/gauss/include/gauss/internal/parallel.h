@@ -0,0 +1,96 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_PARALLEL_H
+#define GAUSS_PARALLEL_H
+
+#ifndef BUILDING_GAUSS
+#error Internal headers cannot be included from user code
+#endif
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gauss::parallel {
+
+/**
+ * @brief Returns the number of host threads available for parallel work.
+ */
+inline unsigned int hostConcurrency() {
+    auto n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * @brief Whether the current thread is running iterations of a parallelFor.
+ */
+inline thread_local bool insideParallelFor = false;
+
+/**
+ * @brief Runs fn(i) for every i in [begin, end) using up to nThreads host threads (zero selects
+ * hostConcurrency()).  Iterations are handed out dynamically, so uneven workloads are balanced
+ * across workers.  Calls nested within the iterations of another parallelFor run serially in
+ * the calling worker, so the number of threads never exceeds the one of the outermost loop.
+ *
+ * Workers inherit the active ArrayFire device of the calling thread, so fn may freely issue
+ * ArrayFire operations.  The first exception thrown by fn stops the distribution of new
+ * iterations and it is rethrown in the calling thread once all workers have finished.
+ */
+template <typename Fn>
+void parallelFor(dim_t begin, dim_t end, Fn &&fn, unsigned int nThreads = 0) {
+    if (end <= begin) return;
+
+    auto total = static_cast<unsigned int>(std::min<dim_t>(end - begin, hostConcurrency()));
+    auto workers = nThreads == 0 ? total : std::min(nThreads, total);
+    if (workers <= 1 || insideParallelFor) {
+        for (auto i = begin; i < end; i++) fn(i);
+        return;
+    }
+
+    auto device = af::getDevice();
+    std::atomic<dim_t> next(begin);
+    std::exception_ptr error;
+    std::mutex errorLock;
+
+    auto worker = [&]() {
+        insideParallelFor = true;
+        for (auto i = next++; i < end; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!error) error = std::current_exception();
+                next = end;
+            }
+        }
+        insideParallelFor = false;
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (unsigned int t = 1; t < workers; t++) {
+        threads.emplace_back([&, device]() {
+            af::setDevice(device);
+            worker();
+        });
+    }
+
+    worker();
+    for (auto &t : threads) t.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+}  // namespace gauss
+
+#endif
@@ -0,0 +1,124 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_METRIC_INDEX_H
+#define GAUSS_METRIC_INDEX_H
+
+#include <arrayfire.h>
+#include <gauss/defines.h>
+#include <gauss/distances.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace gauss::distances {
+
+/**
+ * @brief Vantage point tree over the columns of a matrix, which answers k nearest neighbours and range
+ * queries with sublinear expected cost for any distance algorithm flagged as a metric.
+ *
+ * [1] Peter N. Yianilos. 1993. Data structures and algorithms for nearest neighbor search in general metric
+ * spaces. In Proceedings of the fourth annual ACM-SIAM Symposium on Discrete algorithms (SODA '93), 311-321.
+ *
+ * Each internal node holds a vantage point and the median distance from it to the rest of the columns in
+ * the node, which splits them into an inner and an outer ball; leaves keep up to leaf_size columns that are
+ * evaluated in a single batched call to the distance algorithm.  Queries are answered concurrently using
+ * the host threads.
+ */
+class GAUSSAPI metric_index {
+public:
+    /**
+     * @brief Builds the index.
+     *
+     * @param algo Distance algorithm, which must be flagged as a metric.
+     * @param data Columnar matrix whose columns are the indexed time series.
+     * @param leaf_size Maximum number of columns kept in a leaf.
+     * @param seed Seed used to pick the vantage points, so builds are reproducible.
+     */
+    metric_index(const distance_algorithm_t &algo, const af::array &data, dim_t leaf_size = 64,
+                 unsigned int seed = 0);
+
+    /**
+     * @brief Finds the k nearest indexed columns for each column in queries.
+     *
+     * @return A tuple of two (queries_len, k) matrices; the first one holds the distances, sorted in ascending
+     * order by row, and the second one the u32 column indices in the indexed data.
+     */
+    std::tuple<af::array, af::array> knn(const af::array &queries, int k) const;
+
+    /**
+     * @brief Finds all the indexed columns whose distance to each column in queries is less or equal to radius.
+     *
+     * @return A tuple with the results in compressed row layout: the distances, sorted in ascending order per
+     * query, the u32 column indices in the indexed data and a (queries_len + 1) u32 vector of offsets, so the
+     * results of the i-th query are found in the range [offsets[i], offsets[i+1]).
+     */
+    std::tuple<af::array, af::array, af::array> range(const af::array &queries, double radius) const;
+
+    /**
+     * @brief Writes the structure of the index to a binary stream.  The indexed data is not written, as it
+     * is expected to be persisted independently.
+     */
+    void save(std::ostream &out) const;
+
+    /**
+     * @brief Restores an index previously written with save, binding it to the given algorithm and data, which
+     * must be the same used when the index was built.
+     */
+    static metric_index load(std::istream &in, const distance_algorithm_t &algo, const af::array &data);
+
+    /**
+     * @brief Number of indexed columns.
+     */
+    dim_t size() const { return static_cast<dim_t>(_items.size()); }
+
+private:
+    typedef struct node {
+        // position, in _items, of the vantage point; -1 for leaves
+        dim_t vantage;
+        // median distance from the vantage point to the columns below it
+        double mu;
+        // children (inner: d <= mu, outer: d >= mu); -1 when empty
+        int32_t inside;
+        int32_t outside;
+        // range of positions, in _items, covered by a leaf
+        dim_t begin;
+        dim_t end;
+    } node_t;
+
+    // selects the constructor that only binds algo and data, leaving the tree to be filled by load
+    struct unbuilt_t {};
+
+    metric_index(const distance_algorithm_t &algo, const af::array &data, unbuilt_t);
+
+    int32_t build(dim_t begin, dim_t end, std::mt19937 &rng);
+
+    std::vector<double> distancesTo(const af::array &query, dim_t begin, dim_t end) const;
+
+    af::array checkedQueries(const af::array &queries) const;
+
+    template <typename Visitor>
+    void search(int32_t node, const af::array &query, Visitor &visitor) const;
+
+    distance_algorithm_t _algo;
+    af::array _data;
+    dim_t _leaf_size;
+
+    // permutation of the indexed columns; the tree addresses positions in this vector
+    std::vector<dim_t> _items;
+    std::vector<node_t> _nodes;
+
+    // data columns laid out in the order given by _items
+    af::array _ordered;
+};
+
+}  // namespace gauss
+
+#endif
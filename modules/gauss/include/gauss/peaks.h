@@ -0,0 +1,76 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_PEAKS_H
+#define GAUSS_PEAKS_H
+
+#include <arrayfire.h>
+#include <gauss/defines.h>
+
+namespace gauss::features {
+
+/**
+ * @brief Criteria used to find peaks.
+ *
+ * SUPPORT: values strictly greater than their support neighbours on both sides, as in numberPeaks.
+ *
+ * PROMINENCE: local maxima, with flat peaks reported at their middle, whose prominence is at least the given one;
+ * peaks and prominences follow scipy.signal.find_peaks and scipy.signal.peak_prominences.
+ *
+ * CWT_RIDGE: the ridge lines of the continuous wavelet transform computed with the Ricker wavelet for widths from
+ * 1 to maxWidth, filtered by length and signal to noise ratio as in scipy.signal.find_peaks_cwt with its default
+ * settings.
+ */
+enum class PeakMode { SUPPORT, PROMINENCE, CWT_RIDGE };
+
+/**
+ * @brief Settings of the peak search; only the ones of the selected mode are considered.
+ */
+typedef struct peak_options {
+    PeakMode mode = PeakMode::SUPPORT;
+    // SUPPORT: neighbours on each side a peak must be greater than
+    int support = 1;
+    // PROMINENCE: minimum prominence of a peak
+    double prominence = 0.0;
+    // CWT_RIDGE: widths of the wavelet range from 1 to maxWidth
+    int maxWidth = 5;
+    // Whether the positions of the peaks are returned or just their number
+    bool locations = false;
+} peak_options_t;
+
+/**
+ * @brief Peaks found in a set of time series.
+ */
+typedef struct peaks {
+    // (1, series) u32 number of peaks of each series
+    af::array counts;
+    // u32 positions of the peaks, in ascending order by series; empty unless requested
+    af::array locations;
+    // (series + 1) u32 offsets, so the peaks of the i-th series are found in the range
+    // [offsets[i], offsets[i+1]) of locations; empty unless requested
+    af::array offsets;
+} peaks_t;
+
+/**
+ * @brief Finds the peaks of all the time series at once.
+ *
+ * The support mode runs on the device: the maxima of the neighbourhoods at both sides of every value are built
+ * with O(log support) strided comparisons over the whole matrix.  The prominence and ridge modes need to walk
+ * from each candidate, which is done on the host threads, one series per task; the wavelet transforms of the
+ * ridge mode are computed for all the series in a single batch.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param options Settings of the search.
+ *
+ * @return peaks_t The number of peaks and, when requested, their positions in compressed layout.
+ */
+GAUSSAPI peaks_t findPeaks(const af::array &tss, const peak_options_t &options = peak_options_t());
+
+}  // namespace gauss::features
+
+#endif
@@ -0,0 +1,168 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_RAGGED_H
+#define GAUSS_RAGGED_H
+
+#include <arrayfire.h>
+#include <gauss/defines.h>
+#include <gauss/distances.h>
+
+#include <vector>
+
+namespace gauss {
+
+/**
+ * @brief Collection of time series of different lengths, stored in compressed layout: a single column vector
+ * with the values of all the series, one after the other, and a (series + 1) u32 vector of offsets, so the i-th
+ * series is found in the range [offsets[i], offsets[i+1]).
+ *
+ * The kernels declared below operate on all the series at once by reducing the values by segment, thus
+ * variable length data is processed without padding it into a matrix.  Every series must hold at least one
+ * value.
+ */
+class GAUSSAPI ragged_array {
+public:
+    /**
+     * @brief Builds a collection from its values and offsets.
+     *
+     * @param values Column vector with the values of all the series.
+     * @param offsets Vector of series + 1 non decreasing offsets, starting at zero and ending at the number of
+     * values.
+     */
+    ragged_array(const af::array &values, const af::array &offsets);
+
+    /**
+     * @brief Builds a collection by concatenating the given column vectors.
+     */
+    static ragged_array fromSeries(const std::vector<af::array> &series);
+
+    /**
+     * @brief Values of all the series, one after the other.
+     */
+    const af::array &values() const { return _values; }
+
+    /**
+     * @brief u32 offsets of the series in values.
+     */
+    const af::array &offsets() const { return _offsets; }
+
+    /**
+     * @brief s32 vector, as long as values, with the position of the series each value belongs to.
+     */
+    const af::array &keys() const { return _keys; }
+
+    /**
+     * @brief Number of series.
+     */
+    dim_t size() const { return static_cast<dim_t>(_bounds.size()) - 1; }
+
+    /**
+     * @brief Number of values in all the series.
+     */
+    dim_t elements() const { return _values.elements(); }
+
+    /**
+     * @brief Length of the i-th series.
+     */
+    dim_t length(dim_t i) const { return _bounds[i + 1] - _bounds[i]; }
+
+    /**
+     * @brief The i-th series, as a column vector.
+     */
+    af::array series(dim_t i) const;
+
+    /**
+     * @brief A collection with the same offsets and the given values, which must be as many as in this one.
+     */
+    ragged_array withValues(const af::array &values) const;
+
+private:
+    ragged_array(const af::array &values, const af::array &offsets, const af::array &keys,
+                 std::vector<dim_t> bounds);
+
+    af::array _values;
+    af::array _offsets;
+    af::array _keys;
+
+    // host copy of the offsets
+    std::vector<dim_t> _bounds;
+};
+
+namespace features {
+
+/**
+ * @brief Features of a ragged collection.  They follow the definition of the function of the same name in
+ * gauss/features.h applied to each series, and return a (1, series) row vector with the type of the values,
+ * except length, which is s32, and the counts, which are u32.
+ */
+GAUSSAPI af::array absEnergy(const ragged_array &tss);
+
+GAUSSAPI af::array absoluteSumOfChanges(const ragged_array &tss);
+
+GAUSSAPI af::array countAboveMean(const ragged_array &tss);
+
+GAUSSAPI af::array countBelowMean(const ragged_array &tss);
+
+GAUSSAPI af::array length(const ragged_array &tss);
+
+GAUSSAPI af::array maximum(const ragged_array &tss);
+
+GAUSSAPI af::array mean(const ragged_array &tss);
+
+GAUSSAPI af::array meanAbsoluteChange(const ragged_array &tss);
+
+GAUSSAPI af::array minimum(const ragged_array &tss);
+
+GAUSSAPI af::array standardDeviation(const ragged_array &tss);
+
+GAUSSAPI af::array sumValues(const ragged_array &tss);
+
+GAUSSAPI af::array variance(const ragged_array &tss);
+
+}  // namespace features
+
+namespace normalization {
+
+/**
+ * @brief Adjusts every series of a ragged collection for zero mean and one as standard deviation.
+ *
+ * @param tss Collection to normalize.
+ * @param ddof Degrees of freedom for stdev.
+ *
+ * @return ragged_array A collection with the same offsets as tss.
+ */
+GAUSSAPI ragged_array znorm(const ragged_array &tss, const int ddof = 0);
+
+}  // namespace normalization
+
+namespace distances {
+
+/**
+ * @brief Runs algo for every series in xa against all the others; if the algorithm is symmetric, only half of
+ * the pairs are evaluated.
+ *
+ * Only algorithms accepting series of different lengths are supported.  Those providing compute_pair are
+ * evaluated on the host threads, straight from the values of the collection; for the rest, series are grouped
+ * by length and the dense compute runs once per pair of groups.
+ *
+ * @return af::array A (xa_len, xa_len) matrix.
+ */
+GAUSSAPI af::array compute(const distance_algorithm_t &algo, const ragged_array &xa);
+
+/**
+ * @brief Runs algo for every series in xa against all the series in xb.
+ *
+ * @return af::array A (xa_len, xb_len) matrix.
+ */
+GAUSSAPI af::array compute(const distance_algorithm_t &algo, const ragged_array &xa, const ragged_array &xb);
+
+}  // namespace distances
+
+}  // namespace gauss
+
+#endif
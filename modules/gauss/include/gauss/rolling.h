@@ -0,0 +1,44 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef GAUSS_ROLLING_H
+#define GAUSS_ROLLING_H
+
+#include <arrayfire.h>
+#include <gauss/defines.h>
+#include <gauss/featureset.h>
+
+#include <vector>
+
+namespace gauss::features {
+
+/**
+ * @brief Computes features over sliding windows of every time series, without materialising the windows.
+ *
+ * Windows are visited in order and updated incrementally as values enter and leave them: moment based features
+ * (MEAN, VARIANCE, STANDARD_DEVIATION, SKEWNESS, KURTOSIS, SUM_VALUES and ABS_ENERGY) keep running power sums,
+ * MAXIMUM, MINIMUM and the FIRST/LAST_LOCATION features keep monotonic deques of candidates, and
+ * COUNT_ABOVE_MEAN and COUNT_BELOW_MEAN keep a Fenwick tree over the ranks of the values, so each step costs O(1)
+ * or O(log n).  LONGEST_STRIKE_ABOVE_MEAN and LONGEST_STRIKE_BELOW_MEAN depend on the mean of the whole window and
+ * are computed with one scan of it.  Every feature follows the definition of the function of the same name in
+ * gauss/features.h, applied to the window, and time series are processed concurrently on the host threads.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param window Length of the windows.
+ * @param step Distance between the starts of consecutive windows.
+ * @param features Features to compute; any other feature raises an std::invalid_argument.
+ *
+ * @return af::array A (windows, features, series) array, with the same type as tss, where the i-th window of each
+ * series starts at position i * step.
+ */
+GAUSSAPI af::array rollingFeatures(const af::array &tss, dim_t window, dim_t step,
+                                   const std::vector<Feature> &features);
+
+}  // namespace gauss::features
+
+#endif
@@ -17,6 +17,45 @@ namespace gauss::statistics {
 
 enum class XCorrScale { BIASED, UNBIASED, COEFF, NONE };
 
+/**
+ * @brief Moments of a set of time series: the number of values, the mean and the sums of the second, third and
+ * fourth powers of the deviations from the mean.  Every array holds one entry per series, laid out as the result
+ * of af::mean along the reduced dimension.
+ */
+typedef struct moments {
+    af::array count;
+    af::array mean;
+    af::array m2;
+    af::array m3;
+    af::array m4;
+} moments_t;
+
+/**
+ * @brief Computes the moments of the series found along dim.
+ *
+ * Everything stays on the device: series are cut in chunks, the power sums of every chunk, shifted by its first
+ * value, are reduced for all the chunks at once, and the partial moments are then merged pairwise with
+ * mergeMoments.  No centred copy of the input is built.
+ *
+ * @param tss Real input array.
+ * @param dim Dimension along which the series are laid out.
+ *
+ * @return moments_t With f64 arrays when tss is f64 and f32 arrays otherwise.
+ */
+GAUSSAPI moments_t moments(const af::array &tss, const unsigned int dim = 0);
+
+/**
+ * @brief Combines the moments computed over two disjoint chunks of the same series, as if they had been computed
+ * over the union of both chunks, with the pairwise updates of Pébay; useful when the values arrive in batches.
+ */
+GAUSSAPI moments_t mergeMoments(const moments_t &a, const moments_t &b);
+
+GAUSSAPI af::array stdev(const moments_t &m, const unsigned int ddof = 1);
+GAUSSAPI af::array var(const moments_t &m, const unsigned int ddof = 1);
+GAUSSAPI af::array skewness(const moments_t &m);
+GAUSSAPI af::array kurtosis(const moments_t &m);
+
+// stdev, var, skewness and kurtosis are evaluated from the moments of tss
 af::array stdev(const af::array &tss, const unsigned int ddof = 1, const unsigned int dim = 0);
 af::array var(const af::array &tss, const unsigned int ddof = 1, const unsigned int dim = 0);
 af::array moment(const af::array &tss, unsigned int k, const unsigned int dim = 0);
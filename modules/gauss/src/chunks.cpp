@@ -0,0 +1,92 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/chunks.h>
+
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using gauss::features::Aggregation;
+
+/**
+ * Summarises every column of values, which holds a whole chunk of k values, into a (1, columns) row.
+ */
+af::array aggregateColumns(const af::array &values, Aggregation aggregation) {
+    auto k = values.dims(0);
+    switch (aggregation) {
+        case Aggregation::SUM:
+            return af::sum(values, 0);
+        case Aggregation::MEAN:
+            return af::mean(values, 0);
+        case Aggregation::MINIMUM:
+            return af::min(values, 0);
+        case Aggregation::MAXIMUM:
+            return af::max(values, 0);
+        case Aggregation::VARIANCE: {
+            auto centred = values - af::tile(af::mean(values, 0), static_cast<unsigned int>(k));
+            return af::sum(centred * centred, 0) / static_cast<double>(k);
+        }
+        case Aggregation::ENERGY:
+            return af::sum(values * values, 0);
+        case Aggregation::LINEAR_TREND: {
+            if (k < 2)
+                return af::constant(std::numeric_limits<double>::quiet_NaN(), 1, values.dims(1), values.type());
+            // least-squares slope against the positions 0..k-1: (Σtx - Σt·Σx / k) / (Σt² - (Σt)² / k), with the
+            // positions centred so that Σt = 0 and Σt² = k (k² - 1) / 12
+            auto kd = static_cast<double>(k);
+            auto t = af::range(af::dim4(k), 0, values.type()) - (kd - 1.0) / 2.0;
+            auto sxy = af::sum(values * af::tile(t, 1, static_cast<unsigned int>(values.dims(1))), 0);
+            return sxy / (kd * (kd * kd - 1.0) / 12.0);
+        }
+    }
+    throw std::invalid_argument("Unknown aggregation");
+}
+
+}  // namespace
+
+namespace gauss::features {
+
+af::array aggregateOnChunks(const af::array &tss, dim_t chunkSize, const std::vector<Aggregation> &aggregations) {
+    if (chunkSize < 1)
+        throw std::invalid_argument("The chunk size must be greater than zero");
+
+    if (aggregations.empty())
+        throw std::invalid_argument("At least one aggregation is required");
+
+    if (tss.iscomplex())
+        throw std::invalid_argument("Aggregations on chunks require a real input array");
+
+    auto type = tss.type() == af::dtype::f64 ? af::dtype::f64 : af::dtype::f32;
+    auto x = tss.as(type);
+    auto n = x.dims(0);
+    auto series = x.dims(1);
+    auto full = n / chunkSize;
+    auto remainder = n % chunkSize;
+
+    // the full chunks of every series laid out as columns, plus one block with the trailing values, if any
+    af::array chunks, last;
+    if (full > 0) chunks = af::moddims(x(af::seq(static_cast<double>(full * chunkSize)), af::span), chunkSize,
+                                       full * series);
+    if (remainder > 0) last = x(af::seq(static_cast<double>(full * chunkSize), static_cast<double>(n - 1)), af::span);
+
+    af::array result;
+    for (auto aggregation : aggregations) {
+        af::array values;
+        if (full > 0) values = af::moddims(aggregateColumns(chunks, aggregation), full, series);
+        if (remainder > 0) {
+            auto tail = aggregateColumns(last, aggregation);
+            values = values.isempty() ? tail : af::join(0, values, tail);
+        }
+        result = result.isempty() ? values : af::join(2, result, values);
+    }
+    return result;
+}
+
+}  // namespace gauss::features
@@ -7,106 +7,116 @@
 
 #include <arrayfire.h>
 #include <gauss/clustering.h>
+#include <gauss/distances.h>
+#include <gauss/internal/parallel.h>
 #include <gauss/internal/scopedHostPtr.h>
+#include <gauss/internal/vectorUtil.h>
 #include <gauss/normalization.h>
-#include <gauss/linalg.h>
 #include <gauss/random.h>
 
 #include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <random>
 #include <tuple>
+#include <vector>
 #include <iostream>
 #include <chrono>
+#include <stdexcept>
+
+namespace {
+    // upper bound on the number of (centroid, series) distances evaluated at once
+    constexpr dim_t KMEANS_BLOCK_CELLS = 1 << 24;
+} // namespace
 
 namespace gauss::clustering
 {
     /**
-     * Computes initial k means or centroids.
+     * Computes the squared euclidean distance of every mean against every time series, using the expansion
+     * ||x||^2 + ||c||^2 - 2 c'x so the bulk of the work is a single matrix product.
      *
-     * @param tts       The time series.
-     * @param k         The number of centroids.
-     * @return          The new centroids.
-     */
-    af::array calculateInitialMeans(const af::array &tss, int k)
-    {
-        return af::constant(0, tss.dims(0), k, tss.type());
-    }
-
-    /**
-     * Computes The euclidean distance for a tiled time series agains k-means.
-     *
-     * @param tts       The tiled time series.
-     * @param means     The centroids.
-     * @return          The distance from a time series to all k-means.
+     * @param tss       The time series.
+     * @param tssNorms  The squared norms of the time series, as a row vector.
+     * @param means     The k-means.
+     * @return          A (k, nSeries) matrix with the distances.
      */
-    af::array kEuclideanDistance(const af::array &tts, const af::array &means)
+    af::array squaredDistances(const af::array &tss, const af::array &tssNorms, const af::array &means)
     {
-        return af::reorder(af::sqrt(af::sum(af::pow((tts - means), 2), 0)), 1, 0);
+        auto k = means.dims(1);
+        auto meansNorms = af::sum(af::pow(means, 2.0), 0).T();
+        auto d = af::tile(meansNorms, 1, tss.dims(1)) + af::tile(tssNorms, k) - 2.0 * af::matmulTN(means, tss);
+        // cancellation may produce tiny negative values
+        return af::max(d, 0.0);
     }
 
     /**
-     * Computes the euclidean distance of each time series w.r.t. all k-means.
+     * Computes the squared euclidean distance of each time series to its closest mean.  Series are processed
+     * in blocks so the distance matrix never exceeds KMEANS_BLOCK_CELLS elements.
      *
      * @param tss           The time series.
+     * @param tssNorms      The squared norms of the time series, as a row vector.
      * @param means         The k-means.
-     * @param minDistance   The resulting distance for each time series to all k-means.
-     * @param labels        The ids of the closes mean for all time series.
+     * @param minDistance   The resulting (squared) distance for each time series to its closest mean.
+     * @param idxs          The ids of the closest mean for all time series.
      */
-    void euclideanDistance(const af::array &tss, const af::array &means, af::array &minDistance, af::array &idxs)
+    void closestMeans(const af::array &tss, const af::array &tssNorms, const af::array &means, af::array &minDistance,
+                      af::array &idxs)
     {
         auto nSeries = tss.dims(1);
-        af::array kDistances = af::constant(0.0, means.dims(1), nSeries, tss.type());
+        auto block = std::max<dim_t>(1, KMEANS_BLOCK_CELLS / means.dims(1));
 
-        // This for loop could be parallel, not parallelized to keep memory footprint low
-        for (int i = 0; i < nSeries; i++)
-        {
-            af::array tiledSeries = af::tile(tss.col(i), 1, means.dims(1));
-            kDistances(af::span, i) = kEuclideanDistance(tiledSeries, means);
+        if (nSeries <= block) {
+            af::min(minDistance, idxs, squaredDistances(tss, tssNorms, means), 0);
+            return;
+        }
+
+        minDistance = af::array(1, nSeries, tss.type());
+        idxs = af::array(1, nSeries, af::dtype::u32);
+        for (dim_t start = 0; start < nSeries; start += block) {
+            auto cols = af::seq(static_cast<double>(start), static_cast<double>(std::min(start + block, nSeries) - 1));
+            af::array blockMin, blockIdxs;
+            af::min(blockMin, blockIdxs, squaredDistances(tss(af::span, cols), tssNorms(0, cols), means), 0);
+            minDistance(0, cols) = blockMin;
+            idxs(0, cols) = blockIdxs;
         }
-        af::min(minDistance, idxs, kDistances, 0);
     }
 
     /**
-     * Compute the new means for the i-th iteration.
+     * Sums the time series sharing the same label as a segmented reduction: series are sorted by label
+     * and summed by key, so every series is visited once regardless of k.
      *
      * @param tss       The time series.
      * @param labels    The ids for each time series which indicates the closest mean.
-     * @param k         Number of means.
-     * @return          The new means.
+     * @param keys      The labels present in labels.
+     * @param sums      The sum of the series of each label in keys, in columns.
+     * @param counts    The number of series of each label in keys, as a row vector.
      */
-    af::array computeNewMeans(const af::array &tss, const af::array &labels, int k)
+    void sumByLabel(const af::array &tss, const af::array &labels, af::array &keys, af::array &sums, af::array &counts)
     {
-        af::array labelsTiled = af::tile(labels, tss.dims(0));
-        af::array newMeans = af::constant(0.0, tss.dims(0), k, tss.type());
+        af::array sortedLabels, perm;
+        af::sort(sortedLabels, perm, af::flat(labels));
 
-        gfor(af::seq ii, k)
-        {
-            newMeans(af::span, ii) = af::sum(tss * (labelsTiled == ii), 1) / (af::sum(af::sum((labels == ii), 3), 1));
-        }
-        return newMeans;
+        af::sumByKey(keys, sums, sortedLabels, af::lookup(tss, perm, 1), 1);
+        af::sumByKey(keys, counts, sortedLabels, af::constant(1.0, 1, tss.dims(1), tss.type()), 1);
     }
 
     /**
-     *  This function generates random labels for n time series.
+     * Compute the new means for the i-th iteration.
      *
-     * @param nTimeSeries   Number of time series to be labeled.
-     * @param k             The number of groups.
-     * @return              The random labels.
+     * @param tss       The time series.
+     * @param labels    The ids for each time series which indicates the closest mean.
+     * @param means     The means of the previous iteration, which are kept for empty clusters.
+     * @return          The new means.
      */
-    af::array generateRandomLabels(int nTimeSeries, int k)
+    af::array computeNewMeans(const af::array &tss, const af::array &labels, const af::array &means)
     {
-        std::vector<int> idx(nTimeSeries, 0);
-
-        // Fill with sequential data
-        for (int i = 0; i < nTimeSeries; i++)
-        {
-            idx[i] = i % k;
-        }
+        af::array keys, sums, counts;
+        sumByLabel(tss, labels, keys, sums, counts);
 
-        // Randomize
-        std::shuffle(idx.begin(), idx.end(), std::mt19937(std::random_device()()));
-        return af::array(nTimeSeries, 1, idx.data());
+        af::array newMeans = means;
+        newMeans(af::span, keys) = sums / af::tile(counts, tss.dims(0));
+        return newMeans;
     }
 
     /**
@@ -124,24 +134,133 @@ namespace gauss::clustering
         return err.scalar<float>();
     }
 
+    /**
+     * k-means++ seeding over time series whose squared norms are already known.
+     *
+     * @param tss       The time series.
+     * @param tssNorms  The squared norms of the time series, as a row vector.
+     * @param k         The number of means.
+     * @param engine    Random engine for the draws.
+     * @return          The initial means.
+     */
+    af::array seedMeans(const af::array &tss, const af::array &tssNorms, int k, af::randomEngine &engine)
+    {
+        auto nSeries = tss.dims(1);
+        auto draws = af::randu(af::dim4(k), tss.type(), engine);
+        auto last = static_cast<double>(nSeries - 1);
+
+        af::array centroids = af::array(tss.dims(0), k, tss.type());
+
+        // the first centroid is chosen uniformly at random...
+        auto idx = af::min((draws(0) * static_cast<double>(nSeries)).as(af::dtype::u32), last);
+        centroids(af::span, 0) = tss(af::span, idx);
+        auto closest = squaredDistances(tss, tssNorms, centroids(af::span, 0));
+
+        // ... and the rest with probability proportional to their squared distance to the closest 
+        // centroid chosen so far.  Draws are resolved on the device to avoid synchronisations.
+        for (int c = 1; c < k; c++) {
+            auto cdf = af::accum(closest, 1);
+            auto target = af::tile(draws(c) * cdf(0, af::end), 1, nSeries);
+            idx = af::min(af::count(cdf <= target, 1), last);
+            centroids(af::span, c) = tss(af::span, idx);
+            closest = af::min(closest, squaredDistances(tss, tssNorms, centroids(af::span, c)));
+        }
+
+        return centroids;
+    }
+
+    af::array kMeansPlusPlus(const af::array &tss, int k, const std::optional<af::randomEngine> &engine)
+    {
+        if (k < 1 || k > tss.dims(1))
+            throw std::invalid_argument("The number of clusters must be between one and the number of time series");
+
+        auto re = engine.value_or(af::getDefaultRandomEngine());
+        return seedMeans(tss, af::sum(af::pow(tss, 2.0), 0), k, re);
+    }
 
-    void kMeans(const af::array &tss, int k, af::array &centroids, af::array &labels, float tolerance, int maxIterations)
+    /**
+     * Validates the initial centroids given to k-means or, when empty, chooses them with k-means++.
+     *
+     * @param tss       The time series.
+     * @param tssNorms  The squared norms of the time series, as a row vector.
+     * @param k         The number of means.
+     * @param centroids The initial centroids.
+     * @param engine    Random engine for k-means++.
+     */
+    void initialMeans(const af::array &tss, const af::array &tssNorms, int k, af::array &centroids,
+                      af::randomEngine &engine)
     {
-        float error = std::numeric_limits<float>::max();
+        if (k < 1 || k > tss.dims(1))
+            throw std::invalid_argument("The number of clusters must be between one and the number of time series");
 
         if (centroids.isempty())
         {
-            // initial guess of means, select k random time series
-            centroids = calculateInitialMeans(tss, k);
+            // initial guess of means, as per k-means++
+            centroids = seedMeans(tss, tssNorms, k, engine);
         }
-
-        if (labels.isempty())
+        else if (centroids.dims(0) != tss.dims(0) || centroids.dims(1) != k)
         {
-            // assigns a random centroid to every time series
-            labels = generateRandomLabels(tss.dims(1), k);
+            throw std::invalid_argument("The initial centroids must have as many rows as the time series and k columns");
+        }
+    }
+
+    /**
+     * Computes, for each time series, the distance to its closest and second closest means.
+     *
+     * @param tss       The time series.
+     * @param tssNorms  The squared norms of the time series, as a row vector.
+     * @param means     The k-means.
+     * @param best      The resulting distance to the closest mean, as a column vector.
+     * @param idxs      The ids of the closest mean, as a column vector.
+     * @param second    The resulting distance to the second closest mean (+inf when k is one).
+     */
+    void closestTwoMeans(const af::array &tss, const af::array &tssNorms, const af::array &means, af::array &best,
+                         af::array &idxs, af::array &second)
+    {
+        auto nSeries = tss.dims(1);
+        auto k = means.dims(1);
+        auto block = std::max<dim_t>(1, KMEANS_BLOCK_CELLS / k);
+
+        best = af::array(nSeries, tss.type());
+        second = af::array(nSeries, tss.type());
+        idxs = af::array(nSeries, af::dtype::u32);
+        for (dim_t start = 0; start < nSeries; start += block) {
+            auto cols = af::seq(static_cast<double>(start), static_cast<double>(std::min(start + block, nSeries) - 1));
+            auto d = squaredDistances(tss(af::span, cols), tssNorms(0, cols), means);
+
+            af::array blockMin, blockIdxs;
+            af::min(blockMin, blockIdxs, d, 0);
+
+            // hide the closest mean of every series to find the second one
+            auto offsets = af::iota(af::dim4(1, d.dims(1)), af::dim4(1), af::dtype::u32) * static_cast<unsigned int>(k);
+            d(blockIdxs + offsets) = std::numeric_limits<double>::infinity();
+
+            best(cols) = af::flat(af::sqrt(blockMin));
+            idxs(cols) = af::flat(blockIdxs);
+            second(cols) = af::flat(af::sqrt(af::min(d, 0)));
         }
+    }
 
-        af::array distances = af::constant(0, tss.dims(1), tss.type());
+    /**
+     * Lloyd's iterations.
+     *
+     * @param tss           The time series.
+     * @param tssNorms      The squared norms of the time series, as a row vector.
+     * @param k             The number of means.
+     * @param centroids     (in-out) The means; chosen with k-means++ when empty.
+     * @param labels        (out) The closest mean of every series, as a column vector.
+     * @param tolerance     Convergence threshold on the displacement of the means.
+     * @param maxIterations Maximum number of iterations.
+     * @param engine        Random engine for k-means++.
+     * @return              The inertia, the sum of squared distances to the closest mean.
+     */
+    double lloyd(const af::array &tss, const af::array &tssNorms, int k, af::array &centroids, af::array &labels,
+                 float tolerance, int maxIterations, af::randomEngine &engine)
+    {
+        initialMeans(tss, tssNorms, k, centroids, engine);
+
+        float error = std::numeric_limits<float>::max();
+        af::array distances;
         af::array newMeans;
         int iter = 0;
 
@@ -149,10 +268,10 @@ namespace gauss::clustering
         while ((error > tolerance) && (iter < maxIterations))
         {
             // 1. Compute distances to current means
-            euclideanDistance(tss, centroids, distances, labels);
+            closestMeans(tss, tssNorms, centroids, distances, labels);
 
             // 2. Compute new means
-            newMeans = computeNewMeans(tss, labels, k);
+            newMeans = computeNewMeans(tss, labels, centroids);
 
             // 3. Compute convergence
             error = computeError(centroids, newMeans);
@@ -161,6 +280,167 @@ namespace gauss::clustering
             centroids = newMeans;
             iter++;
         }
+
+        // labels consistent with the final centroids
+        closestMeans(tss, tssNorms, centroids, distances, labels);
+        labels = af::flat(labels);
+        return af::sum<double>(distances);
+    }
+
+    /**
+     * Hamerly's iterations; see lloyd for the parameters.
+     */
+    double hamerly(const af::array &tss, const af::array &tssNorms, int k, af::array &centroids, af::array &labels,
+                   float tolerance, int maxIterations, af::randomEngine &engine)
+    {
+        initialMeans(tss, tssNorms, k, centroids, engine);
+
+        auto nSeries = tss.dims(1);
+
+        // upper bound of the distance to the assigned mean and lower bound of 
+        // the distance to any other mean, kept for every series.
+        af::array upper, lower;
+        closestTwoMeans(tss, tssNorms, centroids, upper, labels, lower);
+
+        float error = std::numeric_limits<float>::max();
+        int iter = 0;
+
+        while ((error > tolerance) && (iter < maxIterations))
+        {
+            // 1. Compute new means and convergence
+            auto newMeans = computeNewMeans(tss, labels, centroids);
+            auto shift = af::sqrt(af::sum(af::pow(newMeans - centroids, 2.0), 0));
+            error = computeError(centroids, newMeans);
+            centroids = newMeans;
+            iter++;
+
+            // 2. Bounds remain valid once relaxed by the movement of the means
+            upper += shift(labels);
+            lower -= af::tile(af::max(shift, 1), nSeries);
+
+            // 3. Series can only change their mean when the upper bound exceeds both the 
+            // lower bound and half the distance from the assigned mean to its closest one.
+            auto meanDistances = af::sqrt(squaredDistances(centroids, af::sum(af::pow(centroids, 2.0), 0), centroids));
+            meanDistances = af::select(af::identity(k, k) > 0, std::numeric_limits<double>::infinity(), meanDistances);
+            auto half = 0.5 * af::min(meanDistances, 0);
+            auto bound = af::max(half(labels), lower);
+
+            auto candidates = af::where(upper > bound);
+            if (candidates.isempty()) continue;
+
+            // 4. Tighten the upper bound of the candidates with their exact distance...
+            auto assigned = af::lookup(centroids, labels(candidates), 1);
+            upper(candidates) = af::flat(af::sqrt(af::sum(af::pow(af::lookup(tss, candidates, 1) - assigned, 2.0), 0)));
+
+            auto remaining = candidates(af::where(upper(candidates) > bound(candidates)));
+            if (remaining.isempty()) continue;
+
+            // 5. ... and only those still in doubt are compared against all the means
+            af::array best, idxs, second;
+            closestTwoMeans(af::lookup(tss, remaining, 1), af::moddims(tssNorms(remaining), 1, remaining.elements()),
+                            centroids, best, idxs, second);
+            upper(remaining) = best;
+            labels(remaining) = idxs;
+            lower(remaining) = second;
+        }
+
+        // the inertia is accumulated per cluster, expanding the squared distances as ||x||^2 - 2 x.c + ||c||^2
+        // over the sums of the series of every cluster, which are reduced by label in O(d n)
+        af::array keys, sums, counts;
+        sumByLabel(tss, labels, keys, sums, counts);
+        auto used = af::lookup(centroids, keys, 1);
+        auto inertia = af::sum<double>(tssNorms) - 2.0 * af::sum<double>(used * sums) +
+                       af::sum<double>(counts * af::sum(used * used, 0));
+        return std::max(inertia, 0.0);
+    }
+
+    void kMeans(const af::array &tss, int k, af::array &centroids, af::array &labels, float tolerance, int maxIterations,
+                const std::optional<af::randomEngine> &engine)
+    {
+        auto re = engine.value_or(af::getDefaultRandomEngine());
+        lloyd(tss, af::sum(af::pow(tss, 2.0), 0), k, centroids, labels, tolerance, maxIterations, re);
+    }
+
+    void kMeansHamerly(const af::array &tss, int k, af::array &centroids, af::array &labels, float tolerance,
+                       int maxIterations, const std::optional<af::randomEngine> &engine)
+    {
+        auto re = engine.value_or(af::getDefaultRandomEngine());
+        hamerly(tss, af::sum(af::pow(tss, 2.0), 0), k, centroids, labels, tolerance, maxIterations, re);
+    }
+
+    double kMeansRestarts(const af::array &tss, int k, af::array &centroids, af::array &labels, int nInit,
+                          unsigned long long seed, float tolerance, int maxIterations, bool useHamerly)
+    {
+        if (nInit < 1)
+            throw std::invalid_argument("The number of restarts must be greater than zero");
+
+        if (k < 1 || k > tss.dims(1))
+            throw std::invalid_argument("The number of clusters must be between one and the number of time series");
+
+        // shared by all the restarts
+        auto tssNorms = af::sum(af::pow(tss, 2.0), 0);
+        tssNorms.eval();
+
+        std::vector<af::array> allCentroids(static_cast<size_t>(nInit));
+        std::vector<af::array> allLabels(static_cast<size_t>(nInit));
+        std::vector<double> inertia(static_cast<size_t>(nInit));
+
+        gauss::parallel::parallelFor(0, nInit, [&](dim_t r) {
+            af::randomEngine engine(AF_RANDOM_ENGINE_DEFAULT, seed + static_cast<unsigned long long>(r));
+            auto run = useHamerly ? hamerly : lloyd;
+            inertia[r] = run(tss, tssNorms, k, allCentroids[r], allLabels[r], tolerance, maxIterations, engine);
+        });
+
+        // lowest inertia; ties go to the first restart
+        auto best = std::min_element(inertia.begin(), inertia.end()) - inertia.begin();
+        centroids = allCentroids[best];
+        labels = allLabels[best];
+        return inertia[best];
+    }
+
+    void miniBatchKMeans(minibatch_kmeans_state_t &state, const af::array &chunk, int k, af::array &labels,
+                         const std::optional<af::randomEngine> &engine)
+    {
+        if (state.centroids.isempty())
+        {
+            // the first chunk seeds the centroids
+            state.centroids = kMeansPlusPlus(chunk, k, engine);
+            state.counts = af::constant(0.0, 1, k, af::dtype::f64);
+        }
+        else if (state.centroids.dims(0) != chunk.dims(0) || state.centroids.dims(1) != k)
+        {
+            throw std::invalid_argument("The chunk must have as many rows as the centroids and k must not change");
+        }
+
+        af::array distances;
+        closestMeans(chunk, af::sum(af::pow(chunk, 2.0), 0), state.centroids, distances, labels);
+        labels = af::flat(labels);
+
+        af::array keys, sums, counts;
+        sumByLabel(chunk, labels, keys, sums, counts);
+
+        // every centroid moves towards the mean of its new series with a learning rate 
+        // of one over the number of series it has absorbed, so it is always the running 
+        // mean of all the series ever assigned to it.
+        auto previous = state.counts(0, keys);
+        auto updated = previous + counts.as(af::dtype::f64);
+        auto rows = chunk.dims(0);
+        auto weights = af::tile(previous / updated, rows).as(chunk.type());
+        auto rates = af::tile(1.0 / updated, rows).as(chunk.type());
+
+        state.centroids(af::span, keys) = state.centroids(af::span, keys) * weights + sums * rates;
+        state.counts(0, keys) = updated;
+        state.seen += chunk.dims(1);
+    }
+
+    af::array kMeansClassify(const af::array &tss, const af::array &centroids)
+    {
+        if (centroids.dims(0) != tss.dims(0))
+            throw std::invalid_argument("The centroids must have as many rows as the time series");
+
+        af::array distances, labels;
+        closestMeans(tss, af::sum(af::pow(tss, 2.0), 0), centroids, distances, labels);
+        return af::flat(labels);
     }
 
 
@@ -169,40 +449,138 @@ namespace gauss::clustering
     //////////////////
 
     /**
-     * Computes the normalized crosscorrelation for all time series and all centroids.
+     * This function computes the assignment step. It is the update of time series labels w.r.t. the dinamics of the
+     * centroids.
+     *
+     * The normalized cross correlations are evaluated in the frequency domain by the shape based distance engine,
+     * which works on blocks of (centroid, series) pairs and only keeps the maximum over the lags, so no
+     * (k, n, 2m-1) intermediate is ever built.
+     *
+     * @param tssSpectra    The spectra of the set of time series, which are reused across iterations.
+     * @param centroids     The set of centroids in columnar mode.
+     * @param best          (out) The normalized cross correlation of every series with its centroid, as a row.
+     * @return              The new set of labels.
+     */
+    af::array assignmentStep(const gauss::distances::sbd_spectra_t &tssSpectra, const af::array &centroids,
+                             af::array &best)
+    {
+        auto centroidSpectra = gauss::distances::sbd_prepare(centroids, tssSpectra.fft_length);
+        auto ncc = gauss::distances::sbd_ncc(centroidSpectra, tssSpectra);
+        af::array labels;
+        af::max(best, labels, ncc, 0);
+        return labels.T();
+    }
+
+    af::array assignmentStep(const gauss::distances::sbd_spectra_t &tssSpectra, const af::array &centroids)
+    {
+        af::array best;
+        return assignmentStep(tssSpectra, centroids, best);
+    }
+
+    /**
+     * Transforms the (znorm) time series once, so their spectra can be reused by every assignment step.
      *
-     * @param tss       The set of time series.
-     * @param centroids The set of centroids.
-     * @return          The computed normalized CrossCorrelation.
+     * @param tss   The set of time series in columnar manner.
+     * @return      The spectra, padded to hold the cross correlation against series of the same length.
      */
-    af::array ncc3Dim(const af::array &tss, const af::array &centroids) {
-        auto normtss = af::sqrt(af::sum(af::pow(tss, 2.0), 0));
-        auto normcen = af::sqrt(af::sum(af::pow(centroids, 2.0), 0));
-        auto den = af::matmulTN(normcen, normtss);
-        auto den_tiled = af::tile(den, 1, 1, (centroids.dims(0)*2)-1);
-
-        auto inv_centroids = af::flip(centroids, 0);
-        auto batched = af::reorder(inv_centroids, 0, 2, 1, 3);
-        auto convolution = af::convolve1(tss, batched, AF_CONV_EXPAND);
-        auto shaped = af::reorder(convolution, 2, 1, 0);
-        return shaped / den_tiled;
+    gauss::distances::sbd_spectra_t seriesSpectra(const af::array &tss)
+    {
+        return gauss::distances::sbd_prepare(tss, gauss::distances::sbd_fft_length(tss.dims(0), tss.dims(0)));
     }
 
     /**
-     * This function computes the assignment step. It is the update of time series labels w.r.t. the dinamics of the
-     * centroids.
+     * Computes p * (tss * tss') * p * v, where p = I - 1/m is the centering matrix, without building any 
+     * m x m matrix.
      *
-     * @param tss       The set of time series in columnar manner.
-     * @param centroids The set of centroids in columnar mode.
-     * @return          The new set of labels.
+     * @param tss   The time series, in columns.
+     * @param v     The column vector to multiply.
+     * @return      The product.
      */
-    af::array assignmentStep(const af::array &tss, const af::array &centroids)
+    af::array centredGramProduct(const af::array &tss, const af::array &v)
     {
-        auto distances = 1.0 - af::max(ncc3Dim(tss, centroids), 2);
-        af::array min;
-        af::array labels;
-        af::min(min, labels, distances, 0);
-        return labels.T();
+        auto m = v.dims(0);
+        auto pv = v - af::tile(af::mean(v, 0), m);
+        auto y = af::matmul(tss, af::matmulTN(tss, pv));
+        return y - af::tile(af::mean(y, 0), m);
+    }
+
+    /**
+     * Computes the eigenvector associated to the largest eigenvalue of p * (tss * tss') * p with the Lanczos
+     * method, using full reorthogonalisation and explicit restarts from the current Ritz vector.
+     *
+     * [1] C. Lanczos. 1950. An iteration method for the solution of the eigenvalue problem of linear differential
+     * and integral operators. Journal of Research of the National Bureau of Standards, 45, 4, 255-282.
+     *
+     * The operator is only applied through centredGramProduct, so its cost per step is O(m * n) and the m x m
+     * matrix is never materialised; only the small tridiagonal problem is solved on the host.
+     *
+     * @param tss           The time series, in columns.
+     * @param start         Initial guess (for instance, the previous centroid).
+     * @param maxSteps      Maximum dimension of the Krylov subspace before restarting.
+     * @param maxRestarts   Maximum number of restarts.
+     * @param tolerance     Relative residual to consider the eigenvector converged.
+     * @return              The unit norm eigenvector.
+     */
+    af::array topEigenvector(const af::array &tss, const af::array &start, dim_t maxSteps = 32, int maxRestarts = 10,
+                             double tolerance = 1e-6)
+    {
+        auto m = tss.dims(0);
+        auto steps = std::min(m, maxSteps);
+        auto type = tss.type();
+
+        // the operator annihilates constant vectors, so centre the guess and, when 
+        // nothing is left, fall back to a ramp.
+        af::array v = start - af::tile(af::mean(start, 0), m);
+        auto norm = af::norm(v);
+        if (norm <= std::numeric_limits<float>::epsilon()) {
+            v = af::range(af::dim4(m), 0, type);
+            v = v - af::tile(af::mean(v, 0), m);
+            norm = af::norm(v);
+            if (norm <= 0.0) return start;
+        }
+        v = v / norm;
+
+        for (int restart = 0; restart <= maxRestarts; restart++) {
+            af::array basis = af::constant(0.0, m, steps, type);
+            std::vector<double> alpha, beta;
+            basis(af::span, 0) = v;
+
+            for (dim_t j = 0; j < steps; j++) {
+                auto q = basis(af::span, j);
+                auto w = centredGramProduct(tss, q);
+                alpha.push_back(af::dot<double>(w, q));
+
+                // full reorthogonalisation, twice is enough
+                auto previous = basis(af::span, af::seq(0.0, static_cast<double>(j)));
+                w = w - af::matmul(previous, af::matmulTN(previous, w));
+                w = w - af::matmul(previous, af::matmulTN(previous, w));
+                beta.push_back(af::norm(w));
+
+                if (j + 1 == steps || beta.back() <= std::numeric_limits<float>::epsilon() * std::abs(alpha.back()))
+                    break;
+
+                basis(af::span, j + 1) = w / beta.back();
+            }
+
+            // largest eigenpair of the tridiagonal projection
+            auto used = static_cast<Eigen::Index>(alpha.size());
+            Eigen::VectorXd diagonal = Eigen::Map<Eigen::VectorXd>(alpha.data(), used);
+            Eigen::VectorXd subdiagonal = Eigen::Map<Eigen::VectorXd>(beta.data(), used).head(std::max<Eigen::Index>(used - 1, 0));
+            Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver;
+            solver.computeFromTridiagonal(diagonal, subdiagonal);
+            Eigen::VectorXd y = solver.eigenvectors().col(used - 1);
+            auto theta = solver.eigenvalues()(used - 1);
+
+            auto ritz = af::matmul(basis(af::span, af::seq(0.0, static_cast<double>(used - 1))),
+                                   af::array(used, y.data()).as(type));
+            v = ritz / af::norm(ritz);
+
+            auto residual = std::abs(beta.back() * y(used - 1));
+            if (residual <= tolerance * std::max(std::abs(theta), std::numeric_limits<double>::min()) || used == m)
+                break;
+        }
+
+        return v;
     }
 
     /**
@@ -213,17 +591,14 @@ namespace gauss::clustering
      *                  znorm centroid in further iterations).
      * @return          The updated shape of the centroid znorm.
      */
-    af::array shapeExtraction(const af::array &tss, const af::array &centroid, const af::array &p)
+    af::array shapeExtraction(const af::array &tss, const af::array &centroid)
     {
         // since data is always znorm and so are the centroids,
         // it is not necessary to invoke sbd, ever!
-        auto s = af::matmulNT(tss, tss);
-        auto m = af::matmul(p, s, p);
-        af::array eigvec;
-        std::tie (std::ignore, eigvec) = gauss::linalg::eigh(m);
-        // last column, per eigh, is the eigenvector whose 
-        // eigenval is max.
-        auto c = eigvec.col(af::end);
+        // The shape is the eigenvector whose eigenval is max of p * S * p,
+        // where S = tss * tss'; the previous centroid is a good guess for it.
+        auto hasCentroid = af::anyTrue<bool>(centroid != 0.0);
+        auto c = topEigenvector(tss, hasCentroid ? centroid : tss.col(0));
         auto z_c = gauss::normalization::znorm(c, 0, 1);
 
         auto findDistance1 = af::sqrt(af::sum(af::pow((tss.col(0) - c), 2.0)));
@@ -236,41 +611,98 @@ namespace gauss::clustering
     }
 
     /**
-     * This function performs the refinement step.
+     * This function performs the refinement step.  Series are grouped by label with a single sort and
+     * the shape of every centroid is extracted concurrently using the host threads.
      *
      * @param tss       The set of time series in columnar manner.
      * @param centroids The set of centroids in columnar mode.
      * @param labels    The set of labels.
+     * @param nThreads  Maximum number of host threads; zero selects all of them.
      * @return          The new centroids.
      */
-    af::array refinementStep(const af::array &tss, const af::array &centroids, const af::array &labels)
+    af::array refinementStep(const af::array &tss, const af::array &centroids, const af::array &labels,
+                             unsigned int nThreads = 0)
     {
         auto ncentroids = centroids.dims(1);
-        af::array result = centroids;
 
-        // prepare p array
-        // this used to be @ shapeExtraction method but it is a constant throughout 
-        // the entire process...
-        auto nelements = tss.dims(0);
-        auto scale = 1.0 / static_cast<double>(nelements);
-        auto scale_tiled = af::constant(scale, nelements, nelements, tss.type());
-        auto p = af::identity(nelements, nelements, tss.type()) - scale_tiled;
+        // make the series of every cluster a contiguous range of columns
+        af::array sortedLabels, perm, keys, counts;
+        af::sort(sortedLabels, perm, af::flat(labels).as(af::dtype::u32));
+        af::sumByKey(keys, counts, sortedLabels, af::constant(1, labels.elements(), af::dtype::u32));
+        auto grouped = af::lookup(tss, perm, 1);
+
+        auto hostKeys = gauss::vectorutil::get<unsigned int>(keys);
+        auto hostCounts = gauss::vectorutil::get<unsigned int>(counts);
+        std::vector<dim_t> first(static_cast<size_t>(ncentroids), 0);
+        std::vector<dim_t> size(static_cast<size_t>(ncentroids), 0);
+        dim_t offset = 0;
+        for (size_t i = 0; i < hostKeys.size(); i++) {
+            if (hostKeys[i] < ncentroids) {
+                first[hostKeys[i]] = offset;
+                size[hostKeys[i]] = hostCounts[i];
+            }
+            offset += hostCounts[i];
+        }
 
-        for (dim_t j = 0; j < ncentroids; j++) {
-            // current centroid
-            auto centroid = centroids.col(j);
-            // select those tss assigned to the centroid j
-            auto subset = af::lookup(tss, af::where((labels == j)), 1);
+        std::vector<af::array> shapes(static_cast<size_t>(ncentroids));
+        gauss::parallel::parallelFor(0, ncentroids, [&](dim_t j) {
             // if centroid j has at least one labeled time series.
-            if (!subset.isempty()) {
-                result(af::span, j) = shapeExtraction(subset, centroid, p);
-            }
+            if (size[j] == 0) return;
+            auto subset = grouped(af::span, af::seq(static_cast<double>(first[j]), static_cast<double>(first[j] + size[j] - 1)));
+            shapes[j] = shapeExtraction(subset, centroids.col(j));
+        }, nThreads);
+
+        af::array result = centroids;
+        for (dim_t j = 0; j < ncentroids; j++) {
+            if (!shapes[j].isempty()) result(af::span, j) = shapes[j];
         }
 
         return result;
     }
 
-    void kshape_calibrate(const af::array &tss, int k, af::array &centroids, af::array &labels, const int maxIterations, const bool rnd_labels)
+    /**
+     * Alternates refinement and assignment steps until the labels do not change.
+     *
+     * @param normTSS       The znorm time series.
+     * @param spectra       The spectra of normTSS, shared by all the iterations.
+     * @param centroids     (in-out) The centroids.
+     * @param labels        (in-out) The labels.
+     * @param maxIterations Maximum number of iterations.
+     * @param nThreads      Maximum number of host threads used by the refinement; zero selects all of them.
+     * @return              The inertia, the sum of shape based distances of the series to their centroids.
+     */
+    double kshapeIterations(const af::array &normTSS, const gauss::distances::sbd_spectra_t &spectra,
+                            af::array &centroids, af::array &labels, int maxIterations, unsigned int nThreads = 0)
+    {
+        auto terminate = false;
+        int iter = 0;
+        af::array best;
+
+        while (!terminate)
+        {
+            // 1. Refinement step. New centroids computation.
+            auto newCentroids = refinementStep(normTSS, centroids, labels, nThreads);
+
+            // 2. Assignment step. New labels computation.
+            auto new_labels = assignmentStep(spectra, newCentroids, best);
+
+            // 3. Update centroids
+            centroids = newCentroids;
+
+            // 4. Check if no movement in labels or max iterations reached            
+            terminate = iter++ == maxIterations || af::allTrue<bool>(new_labels == labels);
+
+            // 5. Update labels.
+            labels = new_labels;
+        }
+
+        auto inertia = af::sum<double>(1.0 - best);
+        // empty clusters may leave centroids without a shape
+        return std::isnan(inertia) ? std::numeric_limits<double>::infinity() : inertia;
+    }
+
+    void kshape_calibrate(const af::array &tss, int k, af::array &centroids, af::array &labels, const int maxIterations,
+                          const bool rnd_labels, const std::optional<af::randomEngine> &engine)
     {
         auto nTimeseries = static_cast<unsigned int>(tss.dims(1));
         auto nElements = static_cast<unsigned int>(tss.dims(0));
@@ -281,7 +713,7 @@ namespace gauss::clustering
 
         if (labels.isempty()) {
             labels = rnd_labels 
-                ? gauss::random::randint(0, k, af::dim4(nTimeseries), af::dtype::u32)
+                ? gauss::random::randint(0, k, af::dim4(nTimeseries), af::dtype::u32, engine)
                 : af::iota(af::dim4(nTimeseries), af::dim4(1), af::dtype::u32) % k;
         } 
         else {
@@ -299,33 +731,119 @@ namespace gauss::clustering
                 throw std::invalid_argument("The labels should be identified with values ranging from 0 up to the number of clusters");
         }
 
-        auto terminate = false;
-        int iter = 0;
+        // Ensure tss is normalized
+        auto normTSS = gauss::normalization::znorm(tss, 0, 1);
+        kshapeIterations(normTSS, seriesSpectra(normTSS), centroids, labels, maxIterations);
+    }
+
+    double kshape_restarts(const af::array &tss, int k, af::array &centroids, af::array &labels, int nInit,
+                           unsigned long long seed, int maxIterations)
+    {
+        if (nInit < 1)
+            throw std::invalid_argument("The number of restarts must be greater than zero");
+
+        if (k < 1 || k > tss.dims(1))
+            throw std::invalid_argument("The number of clusters must be between one and the number of time series");
 
-        // 0. Ensure tss is normalized
+        // the normalised series and their spectra are shared by all the restarts
         auto normTSS = gauss::normalization::znorm(tss, 0, 1);
+        normTSS.eval();
+        auto spectra = seriesSpectra(normTSS);
+        spectra.spectra.eval();
+        spectra.norms.eval();
+
+        std::vector<af::array> allCentroids(static_cast<size_t>(nInit));
+        std::vector<af::array> allLabels(static_cast<size_t>(nInit));
+        std::vector<double> inertia(static_cast<size_t>(nInit));
+
+        // restarts already keep the host threads busy, thus every restart refines its centroids serially
+        auto refinementThreads = nInit > 1 ? 1u : 0u;
+        gauss::parallel::parallelFor(0, nInit, [&](dim_t r) {
+            af::randomEngine engine(AF_RANDOM_ENGINE_DEFAULT, seed + static_cast<unsigned long long>(r));
+            allLabels[r] = gauss::random::randint(0, k, af::dim4(tss.dims(1)), af::dtype::u32, engine);
+            allCentroids[r] = af::constant(0, tss.dims(0), k, tss.type());
+            inertia[r] = kshapeIterations(normTSS, spectra, allCentroids[r], allLabels[r], maxIterations,
+                                          refinementThreads);
+        });
+
+        // lowest inertia; ties go to the first restart
+        auto best = std::min_element(inertia.begin(), inertia.end()) - inertia.begin();
+        centroids = allCentroids[best];
+        labels = allLabels[best];
+        return inertia[best];
+    }
 
-        while (!terminate)
-        {
-            // 1. Refinement step. New centroids computation.
-            auto newCentroids = refinementStep(normTSS, centroids, labels);
+    af::array kshape_classify(const af::array &tss, const af::array &centroids) {
+        auto normTSS = gauss::normalization::znorm(tss, 0, 1);
+        return assignmentStep(seriesSpectra(normTSS), centroids);
+    }
 
-            // 2. Assignment step. New labels computation.
-            auto new_labels = assignmentStep(normTSS, newCentroids);
+    kshape_classifier::kshape_classifier(const af::array &centroids, dim_t batchSize)
+        : _length(centroids.dims(0)), _clusters(centroids.dims(1)), _batchSize(batchSize),
+          _fftLength(gauss::distances::sbd_fft_length(centroids.dims(0), centroids.dims(0)))
+    {
+        if (centroids.isempty())
+            throw std::invalid_argument("At least one centroid is required");
 
-            // 3. Update centroids
-            centroids = newCentroids;
+        if (batchSize < 1)
+            throw std::invalid_argument("The batch size must be greater than zero");
 
-            // 4. Check if no movement in labels or max iterations reached            
-            terminate = iter++ == maxIterations || af::allTrue<bool>(new_labels == labels);
+        auto prepared = gauss::distances::sbd_prepare(centroids, _fftLength);
+        auto bins = prepared.spectra.dims(0);
+        _spectra = af::tile(af::moddims(af::conjg(prepared.spectra), bins, _clusters, 1), 1, 1, _batchSize);
+        _norms = af::tile(prepared.norms, 1, 1, _batchSize);
 
-            // 5. Update labels.
-            labels = new_labels;
-        }
+        // [0, m) for positive shifts and [L-m+1, L) for negative ones
+        std::vector<unsigned int> lags;
+        for (dim_t i = 0; i < _length; i++) lags.push_back(static_cast<unsigned int>(i));
+        for (dim_t i = _fftLength - _length + 1; i < _fftLength; i++) lags.push_back(static_cast<unsigned int>(i));
+        _lags = af::array(static_cast<dim_t>(lags.size()), lags.data());
+
+        af::eval(_spectra, _norms, _lags);
     }
 
-    af::array kshape_classify(const af::array &tss, const af::array &centroids) {
-        auto normTSS = gauss::normalization::znorm(tss, 0, 1);
-        return assignmentStep(normTSS, centroids);
+    af::array kshape_classifier::classify(const af::array &tss) const
+    {
+        af::array similarity;
+        return classify(tss, similarity);
+    }
+
+    af::array kshape_classifier::classify(const af::array &tss, af::array &similarity) const
+    {
+        if (tss.dims(0) != _length)
+            throw std::invalid_argument("The series must have the same length as the centroids");
+
+        auto n = tss.dims(1);
+        auto normTSS = gauss::normalization::znorm(tss, 0, 1).as(_norms.type());
+
+        af::array labels = af::array(n, af::dtype::u32);
+        similarity = af::array(n, _norms.type());
+
+        for (dim_t start = 0; start < n; start += _batchSize) {
+            auto count = std::min(_batchSize, n - start);
+            auto cols = af::seq(static_cast<double>(start), static_cast<double>(start + count - 1));
+
+            // the last batch is padded, so every batch has the same shape
+            af::array batch = normTSS(af::span, cols);
+            if (count < _batchSize)
+                batch = af::join(1, batch, af::constant(0, _length, _batchSize - count, batch.type()));
+
+            auto spectra = af::fftR2C<1>(batch, af::dim4(_fftLength));
+            auto bins = spectra.dims(0);
+            auto products = _spectra * af::tile(af::moddims(spectra, bins, 1, _batchSize), 1, _clusters, 1);
+            auto cc = af::fftC2R<1>(products, _fftLength % 2 == 1, 1.0 / static_cast<double>(_fftLength));
+
+            // (1, k, batch) largest correlation over the valid lags
+            auto best = af::max(af::lookup(cc, _lags, 0), 0);
+            auto norms = af::moddims(af::sqrt(af::sum(af::pow(batch, 2.0), 0)), 1, 1, _batchSize);
+            auto ncc = best / (_norms * af::tile(norms, 1, _clusters, 1));
+
+            af::array value, idx;
+            af::max(value, idx, ncc, 1);
+            labels(cols) = af::flat(idx)(af::seq(static_cast<double>(count)));
+            similarity(cols) = af::flat(value)(af::seq(static_cast<double>(count)));
+        }
+
+        return labels;
     }
 }
\ No newline at end of file
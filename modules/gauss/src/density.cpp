@@ -0,0 +1,411 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/clustering.h>
+#include <gauss/metric_index.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// upper bound on the number of distances computed in one call by the blocked range queries
+constexpr dim_t DENSITY_BLOCK_CELLS = 1 << 24;
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+// leaf size of the vantage point trees answering the queries of metric algorithms; the queries are exact, so the
+// seed used to pick the vantage points does not change the clusters
+constexpr dim_t DENSITY_LEAF_SIZE = 64;
+constexpr unsigned int DENSITY_INDEX_SEED = 0;
+
+/**
+ * Neighbourhoods in compressed row layout: the neighbours of i are found in
+ * indices[offsets[i]], ..., indices[offsets[i+1] - 1].  Every series is part of its own neighbourhood.
+ */
+typedef struct neighbourhoods {
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> indices;
+} neighbourhoods_t;
+
+/**
+ * All the series within eps of every series.  Metric algorithms are answered by a vantage point tree; otherwise,
+ * the distances are computed in blocks of rows, which are discarded once thresholded.
+ */
+neighbourhoods_t rangeQueries(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, double eps) {
+    auto n = tss.dims(1);
+    neighbourhoods_t result;
+
+    if (algo.is_metric) {
+        gauss::distances::metric_index index(algo, tss, DENSITY_LEAF_SIZE, DENSITY_INDEX_SEED);
+        auto [d, idx, offsets] = index.range(tss, eps);
+        result.offsets = gauss::vectorutil::get<unsigned int>(offsets);
+        result.indices = result.offsets.back() > 0 ? gauss::vectorutil::get<unsigned int>(idx)
+                                                   : std::vector<unsigned int>();
+        return result;
+    }
+
+    std::vector<std::vector<unsigned int>> found(static_cast<size_t>(n));
+    auto rows = std::max<dim_t>(1, DENSITY_BLOCK_CELLS / n);
+    for (dim_t start = 0; start < n; start += rows) {
+        auto end = std::min(n, start + rows);
+        auto block = gauss::distances::compute(
+            algo, tss(af::span, af::seq(static_cast<double>(start), static_cast<double>(end - 1))), tss);
+        auto values = gauss::vectorutil::get<double>(block.as(af::dtype::f64));
+
+        auto count = end - start;
+        gauss::parallel::parallelFor(0, count, [&](dim_t r) {
+            auto &neighbours = found[start + r];
+            for (dim_t j = 0; j < n; j++) {
+                if (j == start + r || values[r + j * count] <= eps) neighbours.push_back(static_cast<unsigned int>(j));
+            }
+        });
+    }
+
+    result.offsets.assign(static_cast<size_t>(n + 1), 0);
+    for (dim_t i = 0; i < n; i++)
+        result.offsets[i + 1] = result.offsets[i] + static_cast<unsigned int>(found[i].size());
+
+    result.indices.reserve(result.offsets.back());
+    for (auto &neighbours : found) result.indices.insert(result.indices.end(), neighbours.begin(), neighbours.end());
+    return result;
+}
+
+/**
+ * Distance from every series to its k-th nearest neighbour, counting the series itself.
+ */
+std::vector<double> coreDistances(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, int k) {
+    af::array d;
+    if (algo.is_metric) {
+        gauss::distances::metric_index index(algo, tss, DENSITY_LEAF_SIZE, DENSITY_INDEX_SEED);
+        std::tie(d, std::ignore) = index.knn(tss, k);
+    } else {
+        std::tie(d, std::ignore) = gauss::distances::knn(algo, tss, tss, k);
+    }
+
+    return gauss::vectorutil::get<double>(d(af::span, k - 1).as(af::dtype::f64));
+}
+
+/**
+ * Minimal union-find with path halving.
+ */
+class disjoint_sets {
+public:
+    explicit disjoint_sets(dim_t n) : _parent(static_cast<size_t>(n)) { std::iota(_parent.begin(), _parent.end(), 0); }
+
+    dim_t find(dim_t i) {
+        while (_parent[i] != i) {
+            _parent[i] = _parent[_parent[i]];
+            i = _parent[i];
+        }
+        return i;
+    }
+
+    void join(dim_t a, dim_t b, dim_t root) {
+        _parent[find(a)] = root;
+        _parent[find(b)] = root;
+    }
+
+    void join(dim_t a, dim_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) _parent[std::max(a, b)] = std::min(a, b);
+    }
+
+private:
+    std::vector<dim_t> _parent;
+};
+
+typedef struct edge {
+    dim_t a;
+    dim_t b;
+    double weight;
+} edge_t;
+
+/**
+ * Minimum spanning tree of the mutual reachability graph, max(core_a, core_b, d(a, b)), with Prim's algorithm.
+ * The distances from each vertex are computed when it joins the tree, so every pair is evaluated once and only a
+ * row of distances is kept in memory.
+ */
+std::vector<edge_t> mutualReachabilityTree(const gauss::distances::distance_algorithm_t &algo, const af::array &tss,
+                                           const std::vector<double> &core) {
+    auto n = tss.dims(1);
+    std::vector<bool> inTree(static_cast<size_t>(n), false);
+    std::vector<double> best(static_cast<size_t>(n), INF);
+    std::vector<dim_t> from(static_cast<size_t>(n), 0);
+
+    std::vector<edge_t> edges;
+    edges.reserve(static_cast<size_t>(n - 1));
+
+    dim_t current = 0;
+    inTree[0] = true;
+    for (dim_t step = 0; step < n - 1; step++) {
+        auto row = gauss::vectorutil::get<double>(
+            gauss::distances::compute(algo, tss(af::span, current), tss).as(af::dtype::f64));
+
+        dim_t next = -1;
+        for (dim_t j = 0; j < n; j++) {
+            if (inTree[j]) continue;
+            auto reach = std::max({core[current], core[j], row[j]});
+            if (reach < best[j]) {
+                best[j] = reach;
+                from[j] = current;
+            }
+            if (next < 0 || best[j] < best[next]) next = j;
+        }
+
+        edges.push_back({from[next], next, best[next]});
+        inTree[next] = true;
+        current = next;
+    }
+
+    return edges;
+}
+
+typedef struct merge {
+    dim_t left;
+    dim_t right;
+    double distance;
+    dim_t size;
+} merge_t;
+
+/**
+ * Single linkage hierarchy implied by a spanning tree; node n + i is the cluster formed by the i-th merge.
+ */
+std::vector<merge_t> singleLinkage(std::vector<edge_t> edges, dim_t n) {
+    std::stable_sort(edges.begin(), edges.end(), [](const edge_t &x, const edge_t &y) { return x.weight < y.weight; });
+
+    disjoint_sets sets(2 * n - 1);
+    std::vector<dim_t> sizes(static_cast<size_t>(2 * n - 1), 1);
+    std::vector<merge_t> merges;
+    merges.reserve(edges.size());
+
+    for (const auto &e : edges) {
+        auto id = n + static_cast<dim_t>(merges.size());
+        auto a = sets.find(e.a);
+        auto b = sets.find(e.b);
+        sizes[id] = sizes[a] + sizes[b];
+        merges.push_back({a, b, e.weight, sizes[id]});
+        sets.join(a, b, id);
+    }
+
+    return merges;
+}
+
+typedef struct condensed_edge {
+    dim_t parent;
+    dim_t child;
+    double lambda;
+    dim_t size;
+} condensed_edge_t;
+
+/**
+ * Condenses the single linkage hierarchy: splits where either side has less than minClusterSize series are seen
+ * as series falling out of the parent cluster rather than new clusters.  Cluster ids start at n (the root).
+ */
+std::vector<condensed_edge_t> condenseTree(const std::vector<merge_t> &merges, dim_t n, dim_t minClusterSize) {
+    auto root = 2 * n - 2;
+    auto sizeOf = [&](dim_t node) { return node < n ? dim_t(1) : merges[node - n].size; };
+
+    std::vector<condensed_edge_t> result;
+    std::vector<dim_t> relabel(static_cast<size_t>(root + 1), 0);
+    relabel[root] = n;
+    auto nextLabel = n + 1;
+
+    // series below a node leave the cluster at the given lambda
+    auto fallOut = [&](dim_t node, dim_t cluster, double lambda) {
+        std::vector<dim_t> pending{node};
+        while (!pending.empty()) {
+            auto current = pending.back();
+            pending.pop_back();
+            if (current < n) {
+                result.push_back({cluster, current, lambda, 1});
+            } else {
+                pending.push_back(merges[current - n].left);
+                pending.push_back(merges[current - n].right);
+            }
+        }
+    };
+
+    // top-down, from the last merge; nodes that fell out are never visited
+    std::deque<dim_t> pending{root};
+    while (!pending.empty()) {
+        auto node = pending.front();
+        pending.pop_front();
+
+        const auto &m = merges[node - n];
+        auto lambda = m.distance > 0.0 ? 1.0 / m.distance : INF;
+        auto leftSize = sizeOf(m.left);
+        auto rightSize = sizeOf(m.right);
+        auto cluster = relabel[node];
+
+        if (leftSize >= minClusterSize && rightSize >= minClusterSize) {
+            relabel[m.left] = nextLabel++;
+            result.push_back({cluster, relabel[m.left], lambda, leftSize});
+            relabel[m.right] = nextLabel++;
+            result.push_back({cluster, relabel[m.right], lambda, rightSize});
+            if (m.left >= n) pending.push_back(m.left);
+            if (m.right >= n) pending.push_back(m.right);
+        } else if (leftSize < minClusterSize && rightSize < minClusterSize) {
+            fallOut(m.left, cluster, lambda);
+            fallOut(m.right, cluster, lambda);
+        } else if (leftSize < minClusterSize) {
+            // the cluster carries on in the larger side, which is never a single series
+            fallOut(m.left, cluster, lambda);
+            relabel[m.right] = cluster;
+            pending.push_back(m.right);
+        } else {
+            fallOut(m.right, cluster, lambda);
+            relabel[m.left] = cluster;
+            pending.push_back(m.left);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Selects the clusters of the condensed tree that maximise the total stability (excess of mass) and labels the
+ * series accordingly; series outside every selected cluster are labelled as noise (-1).
+ */
+std::vector<int> excessOfMass(const std::vector<condensed_edge_t> &tree, dim_t n) {
+    dim_t largest = n;
+    for (const auto &e : tree) largest = std::max(largest, e.parent);
+    auto clusters = largest - n + 1;
+
+    // lambda at which each cluster appears and its stability
+    std::vector<double> births(static_cast<size_t>(clusters), 0.0);
+    for (const auto &e : tree)
+        if (e.child >= n) births[e.child - n] = e.lambda;
+
+    std::vector<double> stability(static_cast<size_t>(clusters), 0.0);
+    for (const auto &e : tree) stability[e.parent - n] += (e.lambda - births[e.parent - n]) * static_cast<double>(e.size);
+
+    std::vector<dim_t> parentOf(static_cast<size_t>(largest + 1), -1);
+    std::vector<std::vector<dim_t>> children(static_cast<size_t>(clusters));
+    for (const auto &e : tree) {
+        parentOf[e.child] = e.parent;
+        if (e.child >= n) children[e.parent - n].push_back(e.child);
+    }
+
+    // children have larger ids than their parents, so they are settled first; the root is never selected
+    std::vector<bool> selected(static_cast<size_t>(clusters), false);
+    for (auto c = largest; c > n; c--) {
+        auto subtree = 0.0;
+        for (auto child : children[c - n]) subtree += stability[child - n];
+
+        if (!children[c - n].empty() && subtree > stability[c - n]) {
+            stability[c - n] = subtree;
+        } else {
+            selected[c - n] = true;
+            std::vector<dim_t> below(children[c - n]);
+            while (!below.empty()) {
+                auto current = below.back();
+                below.pop_back();
+                selected[current - n] = false;
+                below.insert(below.end(), children[current - n].begin(), children[current - n].end());
+            }
+        }
+    }
+
+    std::vector<int> labelOf(static_cast<size_t>(clusters), -1);
+    int next = 0;
+    for (dim_t c = 0; c < clusters; c++)
+        if (selected[c]) labelOf[c] = next++;
+
+    std::vector<int> labels(static_cast<size_t>(n), -1);
+    for (dim_t i = 0; i < n; i++) {
+        auto c = parentOf[i];
+        while (c > n && !selected[c - n]) c = parentOf[c];
+        if (c > n) labels[i] = labelOf[c - n];
+    }
+
+    return labels;
+}
+
+}  // namespace
+
+namespace gauss::clustering {
+
+void dbscan(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, double eps, int minSamples,
+            af::array &labels, af::array &core) {
+    if (eps < 0.0)
+        throw std::invalid_argument("The radius cannot be negative");
+
+    if (minSamples < 1)
+        throw std::invalid_argument("The minimum number of samples must be greater than zero");
+
+    auto n = tss.dims(1);
+    auto hood = rangeQueries(algo, tss, eps);
+
+    std::vector<char> isCore(static_cast<size_t>(n));
+    gauss::parallel::parallelFor(0, n, [&](dim_t i) {
+        isCore[i] = hood.offsets[i + 1] - hood.offsets[i] >= static_cast<unsigned int>(minSamples);
+    });
+
+    // clusters are the connected components of the core series
+    disjoint_sets sets(n);
+    for (dim_t i = 0; i < n; i++) {
+        if (!isCore[i]) continue;
+        for (auto p = hood.offsets[i]; p < hood.offsets[i + 1]; p++)
+            if (isCore[hood.indices[p]]) sets.join(i, hood.indices[p]);
+    }
+
+    // numbered by their first core series; border series join the cluster of their first core neighbour
+    std::vector<int> labelOf(static_cast<size_t>(n), -1);
+    std::vector<int> hostLabels(static_cast<size_t>(n), -1);
+    int next = 0;
+    for (dim_t i = 0; i < n; i++) {
+        if (!isCore[i]) continue;
+        auto root = sets.find(i);
+        if (labelOf[root] < 0) labelOf[root] = next++;
+        hostLabels[i] = labelOf[root];
+    }
+
+    for (dim_t i = 0; i < n; i++) {
+        if (isCore[i]) continue;
+        for (auto p = hood.offsets[i]; p < hood.offsets[i + 1]; p++) {
+            if (isCore[hood.indices[p]]) {
+                hostLabels[i] = hostLabels[hood.indices[p]];
+                break;
+            }
+        }
+    }
+
+    labels = af::array(n, hostLabels.data());
+    core = af::array(n, isCore.data());
+}
+
+af::array hdbscan(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, int minClusterSize,
+                  int minSamples) {
+    if (!algo.is_symmetric)
+        throw std::invalid_argument("HDBSCAN requires a symmetric distance algorithm");
+
+    if (minClusterSize < 2)
+        throw std::invalid_argument("The minimum cluster size must be at least two");
+
+    auto n = tss.dims(1);
+    if (n < 2)
+        throw std::invalid_argument("HDBSCAN requires at least two observations");
+
+    if (minSamples < 1 || minSamples > n)
+        throw std::invalid_argument("The minimum number of samples must be between one and the number of series");
+
+    auto core = coreDistances(algo, tss, minSamples);
+    auto merges = singleLinkage(mutualReachabilityTree(algo, tss, core), n);
+    auto hostLabels = excessOfMass(condenseTree(merges, n, minClusterSize), n);
+    return af::array(n, hostLabels.data());
+}
+
+}  // namespace gauss::clustering
@@ -6,11 +6,19 @@
  */
 
 #include <gauss/distances.h>
+#include <gauss/fft.h>
 #include <gauss/normalization.h>
 #include <gauss/matrix.h>
+#include <gauss/internal/elastic.h>
+#include <gauss/internal/matrixInternal.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
 #ifdef _MSC_VER
     #define forceinline __forceinline
@@ -35,7 +43,8 @@ namespace gauss::distances {
 // -> ALGO: Public name
 // -> FN  : One (col) to One (col) distance logic
 // -> SYMM: Is simmetric?
-#define LOCK_STEP_DST_ALGORITHM(ALGO, FN, SYMM)                           \
+// -> METR: Is a true metric?
+#define LOCK_STEP_DST_ALGORITHM_EX(ALGO, FN, SYMM, METR)                  \
     distance_algorithm_t ALGO() {                                         \
         return {                                                          \
             true,                                                         \
@@ -48,17 +57,21 @@ namespace gauss::distances {
                     result(0, ii) = FN(src, dst(af::span, ii));           \
                 }                                                         \
                 return result;                                            \
-            }                                                             \
+            },                                                            \
+            METR                                                          \
         };                                                                \
     }                                                                          
 
+#define LOCK_STEP_DST_ALGORITHM(ALGO, FN, SYMM) LOCK_STEP_DST_ALGORITHM_EX(ALGO, FN, SYMM, false)
+#define LOCK_STEP_METRIC_ALGORITHM(ALGO, FN) LOCK_STEP_DST_ALGORITHM_EX(ALGO, FN, true, true)
+
 //
 // The L1 Family: gower, sorensen, soergel, kulczynski, lorentzian, canberra
 //
 forceinline af::array gower_one_to_one(const af::array &p, const af::array &q) {
     return (1.0/p.dims(0)) * af::sum(af::abs(p - q));
 }
-LOCK_STEP_DST_ALGORITHM(gower, gower_one_to_one, true)
+LOCK_STEP_METRIC_ALGORITHM(gower, gower_one_to_one)
 
 forceinline af::array sorensen_one_to_one(const af::array &p, const af::array &q) {
     return af::sum(af::abs(p - q)) / af::sum(p + q);
@@ -213,6 +226,9 @@ LOCK_STEP_DST_ALGORITHM(jaccard, jaccard_one_to_one, true)
 //
 // The Fidelity family: fidelity, bhattacharyya, hellinger, matusita and square_chord
 //
+// hellinger and matusita only fulfil the triangle inequality between probability distributions, 
+// and are NaN for negative inputs, so neither is flagged as a metric.
+//
 forceinline af::array fidelity_one_to_one(const af::array &p, const af::array &q) {
     return af::sum(af::sqrt(p * q));
 }
@@ -296,7 +312,7 @@ forceinline af::array avg_l1_linf_one_to_one(const af::array &p, const af::array
     auto abs_diff = af::abs(p - q);
     return (af::sum(abs_diff) +  af::max(abs_diff)) / 2.0;
 }
-LOCK_STEP_DST_ALGORITHM(avg_l1_linf, avg_l1_linf_one_to_one, true)
+LOCK_STEP_METRIC_ALGORITHM(avg_l1_linf, avg_l1_linf_one_to_one)
 
 
 //
@@ -327,17 +343,17 @@ LOCK_STEP_DST_ALGORITHM(max_symmetric_chi, max_symmetric_chi_one_to_one, true)
 forceinline af::array manhattan_one_to_one(const af::array &p, const af::array &q) {
     return af::sum(af::abs(p - q));
 }
-LOCK_STEP_DST_ALGORITHM(manhattan, manhattan_one_to_one, true)
+LOCK_STEP_METRIC_ALGORITHM(manhattan, manhattan_one_to_one)
 
 forceinline af::array chebyshev_one_to_one(const af::array &p, const af::array &q) {
     return af::max(af::abs(p - q));
 }
-LOCK_STEP_DST_ALGORITHM(chebyshev, chebyshev_one_to_one, true)
+LOCK_STEP_METRIC_ALGORITHM(chebyshev, chebyshev_one_to_one)
 
 forceinline af::array euclidean_one_to_one(const af::array &p, const af::array &q) {
     return af::sqrt(af::sum(af::pow(p - q, 2.0)));
 }
-LOCK_STEP_DST_ALGORITHM(euclidean, euclidean_one_to_one, true)
+LOCK_STEP_METRIC_ALGORITHM(euclidean, euclidean_one_to_one)
 
 distance_algorithm_t minkowski(double p) {
     return { 
@@ -354,7 +370,8 @@ distance_algorithm_t minkowski(double p) {
                 result(0, ii) = af::pow(sum, 1.0/p);
             }
             return result;
-        }
+        },
+        p >= 1.0            // triangle inequality only holds for p >= 1
     };
 }
 
@@ -370,105 +387,451 @@ distance_algorithm_t hamming() {
                 result(0, ii) = af::sum(src != dst(af::span, ii));
             }
             return result.as(af::dtype::s32);
-        }
+        },
+        true                // is a metric
     };
 }
 
 
+namespace {
+
+// upper bound on the number of cells of the distance matrices 
+// evaluated at once by mpdist.
+constexpr dim_t MPDIST_BLOCK_CELLS = 1 << 24;
+
+// af::topk does not support larger selections 
+constexpr dim_t TOPK_MAX = 256;
+
+/**
+ * Per series state of mpdist, akin to the one prepared by mass: the series 
+ * themselves plus the mean and standard deviation of their subsequences.
+ */ 
+typedef struct mpdist_state {
+    af::array tss;
+    af::array mean;
+    af::array stdev;
+    dim_t w;
+    dim_t subsequences;
+} mpdist_state_t;
+
+mpdist_state_t _mpdist_prepare(const af::array &tss, dim_t w) {
+    if (w < 1 || w > tss.dims(0))
+        throw std::invalid_argument("The window size must be between one and the length of the series");
+
+    auto checked = tss.isfloating() ? tss : tss.as(af::dtype::f32);
+    af::array mean, stdev;
+    gauss::matrix::internal::meanStdev(checked, w, mean, stdev);
+    return {checked, mean, stdev, w, checked.dims(0) - w + 1};
+}
+
+/**
+ * Z-normalised subsequences [first, first + n) of the selected columns, laid out as 
+ * (w, n * columns).  Flat subsequences are set to zero.
+ */ 
+af::array _mpdist_windows(const mpdist_state_t &state, const af::seq &cols, dim_t ncols, dim_t first, dim_t n) {
+    auto w = state.w;
+    auto idx = af::flat(af::iota(af::dim4(w, 1), af::dim4(1, n), af::dtype::s32) + 
+                        af::iota(af::dim4(1, n), af::dim4(w, 1), af::dtype::s32) + static_cast<int>(first));
+    auto subsequences = af::seq(static_cast<double>(first), static_cast<double>(first + n - 1));
+
+    auto windows = af::moddims(state.tss(idx, cols), w, n, ncols);
+    auto mean = af::tile(af::moddims(state.mean(subsequences, cols), 1, n, ncols), w);
+    auto stdev = af::tile(af::moddims(state.stdev(subsequences, cols), 1, n, ncols), w);
+    auto flat = stdev <= 1e-8;
+    auto z = af::select(flat, 0.0, (windows - mean) / (stdev + flat.as(stdev.type())));
+    return af::moddims(z, w, n * ncols);
+}
+
+/**
+ * Value at position k of every column of profiles, in ascending order.
+ */ 
+af::array _select_kth(const af::array &profiles, dim_t k) {
+    if (k < TOPK_MAX) {
+        af::array values, indices;
+        af::topk(values, indices, profiles, static_cast<int>(k + 1), 0, AF_TOPK_MIN);
+        return af::max(values, 0);
+    }
+
+    auto rows = profiles.dims(0);
+    auto cols = profiles.dims(1);
+    auto host = gauss::vectorutil::get<double>(profiles.as(af::dtype::f64));
+    std::vector<double> result(static_cast<size_t>(cols));
+    gauss::parallel::parallelFor(0, cols, [&](dim_t c) {
+        auto first = host.begin() + c * rows;
+        std::nth_element(first, first + k, first + rows);
+        result[c] = *(first + k);
+    });
+    return af::array(1, cols, result.data()).as(profiles.type());
+}
+
+}  // namespace
+
 distance_algorithm_t mpdist(int32_t w, double threshold) {
-    return {
-        false,               // all same length
-        true,               // is symmetric
-        std::nullopt,       // results will be always integers.
-        [=](const af::array& src, const af::array& dst) {
-            auto dst_cols = dst.dims(1);
-            auto result = af::array(1, dst_cols, src.type());
-            af::array pab, pba, iab, iba;
-
-            for (auto ii = 0; ii < dst_cols; ii++) {
-                auto target = dst(af::span, ii);
-                gauss::matrix::matrixProfile(src, target, w, pab, iab);
-                gauss::matrix::matrixProfile(target, src, w, pba, iba);
-                auto abba = af::join(0, pab, pba);
-                auto sorted = af::sort(abba);
-                auto upper_idx = static_cast<dim_t>(std::ceil(threshold * (target.dims(0)+ src.dims(0)))) - 1;
-                auto checked_idx = std::min(sorted.dims(0)-1, upper_idx);
-                result(0, ii) = sorted(checked_idx);
+    auto all = [=](const af::array& xa, const af::array& xb) {
+        auto sa = _mpdist_prepare(xa, w);
+        auto sb = _mpdist_prepare(xb, w);
+        auto na = sa.subsequences;
+        auto nb = sb.subsequences;
+        auto xa_len = xa.dims(1);
+        auto xb_len = xb.dims(1);
+        auto result = af::array(xa_len, xb_len, sa.tss.type());
+
+        // position, in the joined ab and ba profiles, of the reported distance
+        auto upper_idx = static_cast<dim_t>(std::ceil(threshold * (xa.dims(0) + xb.dims(0)))) - 1;
+        auto k = std::max<dim_t>(0, std::min(na + nb - 1, upper_idx));
+
+        // tiles of ta x tb pairs of subsequences bound the distances evaluated at once; when a whole 
+        // pair of series fits, several columns of xb are evaluated together instead
+        auto side = static_cast<dim_t>(std::sqrt(static_cast<double>(MPDIST_BLOCK_CELLS)));
+        auto tb = std::min(nb, std::max(side, MPDIST_BLOCK_CELLS / na));
+        auto ta = std::min(na, std::max<dim_t>(1, MPDIST_BLOCK_CELLS / tb));
+        auto block = std::max<dim_t>(1, std::min(xb_len, MPDIST_BLOCK_CELLS / (ta * tb)));
+        auto inf = std::numeric_limits<double>::infinity();
+
+        for (dim_t j0 = 0; j0 < xb_len; j0 += block) {
+            auto j1 = std::min(j0 + block, xb_len) - 1;
+            auto cols = af::seq(static_cast<double>(j0), static_cast<double>(j1));
+            auto ncols = j1 - j0 + 1;
+            auto zbAll = tb == nb ? _mpdist_windows(sb, cols, ncols, 0, nb) : af::array();
+
+            for (dim_t i = 0; i < xa_len; i++) {
+                auto col = af::seq(static_cast<double>(i), static_cast<double>(i));
+
+                // ab and ba profiles, as running minima over the tiles
+                auto pab = af::constant(inf, na, ncols, sa.tss.type());
+                auto pba = af::constant(inf, nb, ncols, sa.tss.type());
+
+                for (dim_t a0 = 0; a0 < na; a0 += ta) {
+                    auto nta = std::min(ta, na - a0);
+                    auto rows_a = af::seq(static_cast<double>(a0), static_cast<double>(a0 + nta - 1));
+                    auto za = _mpdist_windows(sa, col, 1, a0, nta);
+
+                    for (dim_t b0 = 0; b0 < nb; b0 += tb) {
+                        auto ntb = std::min(tb, nb - b0);
+                        auto rows_b = af::seq(static_cast<double>(b0), static_cast<double>(b0 + ntb - 1));
+                        auto zb = tb == nb ? zbAll : _mpdist_windows(sb, cols, ncols, b0, ntb);
+
+                        // z-normalised euclidean distances of every pair of subsequences in the tile, 
+                        // for all the columns in the block, from a single product
+                        auto qt = af::matmulTN(za, zb);
+                        auto d = af::moddims(af::sqrt(af::max(2.0 * (static_cast<double>(w) - qt), 0.0)), 
+                                             nta, ntb, ncols);
+
+                        pab(rows_a, af::span) = af::min(pab(rows_a, af::span), af::moddims(af::min(d, 1), nta, ncols));
+                        pba(rows_b, af::span) = af::min(pba(rows_b, af::span), af::moddims(af::min(d, 0), ntb, ncols));
+                    }
+                }
+
+                result(i, cols) = _select_kth(af::join(0, pab, pba), k);
             }
-            return result;
         }
+
+        return result;
+    };
+
+    return {
+        false,              // all same length
+        true,               // is symmetric
+        std::nullopt,       // no preference on the result type
+        all,                // src is a single column, so the result is (1, dst_cols)
+        false,              // not a metric
+        all                 // per series state is prepared once
     };
 }
 
+sbd_spectra_t sbd_prepare(const af::array &tss, dim_t fft_length) {
+    if (fft_length < tss.dims(0))
+        throw std::invalid_argument("The length of the transforms cannot be smaller than the length of the series");
+
+    auto checked = tss.isfloating() ? tss : tss.as(af::dtype::f32);
+    return {
+        checked.dims(0),
+        fft_length,
+        af::fftR2C<1>(checked, af::dim4(fft_length)),
+        af::sqrt(af::sum(af::pow(checked, 2), 0))
+    };
+}
+
+dim_t sbd_fft_length(dim_t xa_rows, dim_t xb_rows) {
+    return gauss::fft::nextFastLength(xa_rows + xb_rows - 1);
+}
+
+af::array sbd_ncc(const sbd_spectra_t &xa, const sbd_spectra_t &xb, dim_t block_pairs) {
+    if (xa.fft_length != xb.fft_length)
+        throw std::invalid_argument("Both sets of spectra must be computed with the same transform length");
+
+    if (xa.fft_length < xa.length + xb.length - 1)
+        throw std::invalid_argument("The transform length is too short to hold the cross correlation");
+
+    if (block_pairs < 1)
+        throw std::invalid_argument("The block size must be greater than zero");
+
+    auto fft_length = xa.fft_length;
+    auto bins = xa.spectra.dims(0);
+    auto xa_len = xa.spectra.dims(1);
+    auto xb_len = xb.spectra.dims(1);
+    auto result = af::array(xa_len, xb_len, xa.norms.type());
+
+    // Circular cross correlation, whose valid lags are found at 
+    // [0, n) for positive shifts and [L-m+1, L) for negative ones.
+    auto positive = af::seq(static_cast<double>(xa.length));
+    auto negative = af::seq(static_cast<double>(fft_length - xb.length + 1), static_cast<double>(fft_length - 1));
+
+    auto xb_block = std::min(xb_len, block_pairs);
+    auto xa_block = std::max<dim_t>(1, block_pairs / xb_block);
+
+    for (dim_t j0 = 0; j0 < xb_len; j0 += xb_block) {
+        auto j1 = std::min(j0 + xb_block, xb_len) - 1;
+        auto cols = af::seq(static_cast<double>(j0), static_cast<double>(j1));
+        auto nb = j1 - j0 + 1;
+        auto conj_b = af::conjg(xb.spectra(af::span, cols));
+        auto norms_b = xb.norms(0, cols);
+
+        for (dim_t i0 = 0; i0 < xa_len; i0 += xa_block) {
+            auto i1 = std::min(i0 + xa_block, xa_len) - 1;
+            auto rows = af::seq(static_cast<double>(i0), static_cast<double>(i1));
+            auto na = i1 - i0 + 1;
+
+            // (bins, nb, na) products, transformed back in one batch
+            auto spectra_a = af::moddims(xa.spectra(af::span, rows), bins, 1, na);
+            auto products = af::tile(conj_b, 1, 1, na) * af::tile(spectra_a, 1, nb, 1);
+            auto cc = af::fftC2R<1>(products, fft_length % 2 == 1, 1.0 / static_cast<double>(fft_length));
+
+            auto best = af::max(cc(positive, af::span, af::span), 0);
+            if (xb.length > 1) best = af::max(best, af::max(cc(negative, af::span, af::span), 0));
+
+            // (1, nb, na) -> (na, nb)
+            auto den = af::matmulTN(xa.norms(0, rows), norms_b);
+            result(rows, cols) = af::moddims(af::reorder(best, 2, 1, 0), na, nb) / den;
+        }
+    }
+
+    return result;
+}
+
 distance_algorithm_t sbd() {
+    auto all = [](const af::array& xa, const af::array& xb) {
+        auto fft_length = sbd_fft_length(xa.dims(0), xb.dims(0));
+        return 1.0 - sbd_ncc(sbd_prepare(xa, fft_length), sbd_prepare(xb, fft_length));
+    };
+
     return { 
         false,              // all same length
         true,               // is symmetric
         std::nullopt,       // no preference on the result type
-        [](const af::array& src, const af::array& dst) {
-            auto dst_cols = dst.dims(1);
-            auto result = af::array(1, dst_cols, src.type());
-            
-            af::array xNorm = af::sqrt(af::sum(af::pow(src, 2), 0));
-            gfor(auto ii, dst_cols) {
-                auto other = dst(af::span, ii);
-                af::array yNorm = af::sqrt(af::sum(af::pow(other, 2), 0));
-                result(0, ii) = 1.0 - af::max(af::convolve(src, af::flip(other, 0), AF_CONV_EXPAND), 0) / (xNorm * yNorm);
-            }
-            return result;
-        }
+        all,                // src is a single column, so the result is (1, dst_cols)
+        false,              // not a metric
+        all                 // spectra are computed once per column
+    };
+}
+
+//
+// The Elastic family: dtw, ddtw, wdtw, erp, lcss, msm and twe
+//
+// All of them are evaluated on the host by the dynamic programming engine 
+// found at gauss/internal/elastic.h, which keeps two rolling rows per pair 
+// and distributes the columns of dst across host threads.
+//
+
+/**
+ * Runs evaluate for the column in src against every column in dst.
+ */
+template <typename Evaluate>
+af::array _elastic_one_to_many(const af::array &src, const af::array &dst, Evaluate evaluate) {
+    auto n = src.dims(0);
+    auto m = dst.dims(0);
+    auto dst_cols = dst.dims(1);
+
+    auto a = gauss::vectorutil::get<double>(src.as(af::dtype::f64));
+    auto b = gauss::vectorutil::get<double>(dst.as(af::dtype::f64));
+    std::vector<double> result(static_cast<size_t>(dst_cols));
+
+    gauss::parallel::parallelFor(0, dst_cols, [&](dim_t col) {
+        thread_local std::vector<double> prev, curr;
+        result[col] = evaluate(a.data(), n, b.data() + col * m, m, prev, curr);
+    });
+
+    return af::array(1, dst_cols, result.data()).as(src.type());
+}
+
+/**
+ * Builds an elastic algorithm from evaluate, which resolves both the columns 
+ * of dense matrices and pairs of host buffers.
+ */
+template <typename Evaluate>
+distance_algorithm_t _elastic_algorithm(bool symmetric, bool metric, Evaluate evaluate) {
+    distance_algorithm_t algo = {
+        false,              // all same length
+        symmetric,
+        std::nullopt,       // no preference on the result type
+        [=](const af::array& src, const af::array& dst) { return _elastic_one_to_many(src, dst, evaluate); },
+        metric
     };
+    algo.compute_pair = [=](const double *a, dim_t n, const double *b, dim_t m) {
+        thread_local std::vector<double> prev, curr;
+        return evaluate(a, n, b, m, prev, curr);
+    };
+    return algo;
 }
 
-af::array _dtw_cost_distance(const af::array &a, const af::array &bss) {
-    return af::sqrt(af::pow(af::tile(a, 1, static_cast<unsigned int>(bss.dims(1))) - bss, 2));
+#define ELASTIC_DST_ALGORITHM(SYMM, METR, COST)                                                          \
+    _elastic_algorithm(SYMM, METR,                                                                       \
+        [=](const double *a, dim_t n, const double *b, dim_t m,                                          \
+            std::vector<double> &prev, std::vector<double> &curr) {                                      \
+            return internal::elastic(COST, n, m, opts.window, opts.cutoff, prev, curr);                  \
+        })
+
+// Elastic distances are only guaranteed to be metrics when 
+// the warping path is unconstrained and no abandoning occurs
+forceinline bool _unconstrained(const elastic_options_t &opts) {
+    return opts.window >= 1.0 && std::isinf(opts.cutoff);
 }
 
-af::array _dtw(const af::array &a, const af::array &bss) {
-    auto m = a.dims(0);
-    auto n = bss.dims(0);
+// Boundaries shared by those recurrences starting at D(0,0) = 0
+struct _origin_boundaries {
+    double row0(dim_t j) const { return j == 0 ? 0.0 : internal::INF; }
+    double col0(dim_t) const { return internal::INF; }
+    double result(double d) const { return d; }
+};
 
-    // Allocate the cost Matrix:
-    af::array cost = af::constant(0, m, n, bss.dims(1));
-    auto d = _dtw_cost_distance(a(0), bss(0, af::span));
-    cost(0, 0, af::span) = af::reorder(d, 0, 2, 1, 3);
+struct _dtw_cost : _origin_boundaries {
+    static constexpr bool monotone = true;
+    const double *a, *b;
+    double match(dim_t i, dim_t j) const { return std::abs(a[i - 1] - b[j - 1]); }
+    double up(dim_t i, dim_t j) const { return match(i, j); }
+    double left(dim_t i, dim_t j) const { return match(i, j); }
+};
 
-    // Calculate the first column
-    for (int i = 1; i < m; i++) {
-        cost(i, 0, af::span) = cost(i - 1, 0, af::span) + af::reorder(_dtw_cost_distance(a(i), bss(0, af::span)), 0, 2, 1, 3);
+struct _wdtw_cost : _origin_boundaries {
+    static constexpr bool monotone = true;
+    const double *a, *b;
+    const std::vector<double> &weights;
+    double match(dim_t i, dim_t j) const {
+        auto diff = a[i - 1] - b[j - 1];
+        return weights[static_cast<size_t>(std::abs(i - j))] * diff * diff;
     }
+    double up(dim_t i, dim_t j) const { return match(i, j); }
+    double left(dim_t i, dim_t j) const { return match(i, j); }
+};
 
-    // Calculate the first row
-    for (int j = 1; j < n; j++) {
-        cost(0, j, af::span) = cost(0, j - 1, af::span) + af::reorder(_dtw_cost_distance(a(0), bss(j, af::span)), 0, 2, 1, 3);
+struct _erp_cost {
+    static constexpr bool monotone = true;
+    const double *a, *b;
+    double g;
+    // cumulative costs of deleting the prefixes of a and b against the gap
+    const std::vector<double> &gap_a, &gap_b;
+    double row0(dim_t j) const { return gap_b[j]; }
+    double col0(dim_t i) const { return gap_a[i]; }
+    double match(dim_t i, dim_t j) const { return std::abs(a[i - 1] - b[j - 1]); }
+    double up(dim_t i, dim_t) const { return std::abs(a[i - 1] - g); }
+    double left(dim_t, dim_t j) const { return std::abs(b[j - 1] - g); }
+    double result(double d) const { return d; }
+};
+
+forceinline std::vector<double> _erp_gaps(const double *x, dim_t n, double g) {
+    std::vector<double> gaps(static_cast<size_t>(n + 1), 0.0);
+    for (dim_t i = 1; i <= n; i++) gaps[i] = gaps[i - 1] + std::abs(x[i - 1] - g);
+    return gaps;
+}
+
+// LCSS is expressed as a minimisation over the negated length of the 
+// common subsequence; costs are negative, thus no early abandoning.
+struct _lcss_cost {
+    static constexpr bool monotone = false;
+    const double *a, *b;
+    double epsilon;
+    dim_t shortest;
+    double row0(dim_t) const { return 0.0; }
+    double col0(dim_t) const { return 0.0; }
+    double match(dim_t i, dim_t j) const { return std::abs(a[i - 1] - b[j - 1]) <= epsilon ? -1.0 : internal::INF; }
+    double up(dim_t, dim_t) const { return 0.0; }
+    double left(dim_t, dim_t) const { return 0.0; }
+    double result(double d) const { return 1.0 + d / static_cast<double>(shortest); }
+};
+
+struct _msm_cost : _origin_boundaries {
+    static constexpr bool monotone = true;
+    const double *a, *b;
+    double c;
+    // cost of a split or merge operation of x, with neighbours y and z
+    double split_merge(double x, double y, double z) const {
+        if ((y <= x && x <= z) || (y >= x && x >= z)) return c;
+        return c + std::min(std::abs(x - y), std::abs(x - z));
     }
+    double match(dim_t i, dim_t j) const { return std::abs(a[i - 1] - b[j - 1]); }
+    double up(dim_t i, dim_t j) const { return i > 1 ? split_merge(a[i - 1], a[i - 2], b[j - 1]) : c; }
+    double left(dim_t i, dim_t j) const { return j > 1 ? split_merge(b[j - 1], a[i - 1], b[j - 2]) : c; }
+};
 
-    for (int i = 1; i < m; i++) {
-        for (int j = 1; j < n; j++) {
-            cost(i, j, af::span) =
-                af::min(cost(i - 1, j, af::span), af::min(cost(i, j - 1, af::span), cost(i - 1, j - 1, af::span))) +
-                af::reorder(_dtw_cost_distance(a(i), bss(j, af::span)), 0, 2, 1, 3);
-        }
+// TWE uses the position of the samples as timestamps and a 
+// virtual sample with value zero before the start of each series
+struct _twe_cost : _origin_boundaries {
+    static constexpr bool monotone = true;
+    const double *a, *b;
+    double nu, lambda;
+    double at(const double *x, dim_t i) const { return i > 0 ? x[i - 1] : 0.0; }
+    double match(dim_t i, dim_t j) const {
+        return std::abs(at(a, i) - at(b, j)) + std::abs(at(a, i - 1) - at(b, j - 1)) + 
+               2.0 * nu * static_cast<double>(std::abs(i - j));
     }
-    return af::reorder(cost(m - 1, n - 1, af::span), 0, 2, 1, 3);
+    double up(dim_t i, dim_t) const { return std::abs(at(a, i) - at(a, i - 1)) + nu + lambda; }
+    double left(dim_t, dim_t j) const { return std::abs(at(b, j) - at(b, j - 1)) + nu + lambda; }
+};
+
+distance_algorithm_t dtw(const elastic_options_t &opts) {
+    return ELASTIC_DST_ALGORITHM(true, false, (_dtw_cost{{}, a, b}));
 }
 
+distance_algorithm_t ddtw(const elastic_options_t &opts) {
+    return _elastic_algorithm(true, false, 
+        [=](const double *a, dim_t n, const double *b, dim_t m, 
+            std::vector<double> &prev, std::vector<double> &curr) {
+            auto da = internal::derivative(a, n);
+            auto db = internal::derivative(b, m);
+            return internal::elastic(_dtw_cost{{}, da.data(), db.data()}, n, m, opts.window, opts.cutoff, prev, curr);
+        });
+}
 
-distance_algorithm_t dtw() {
-    return { 
-        false,              // all same length
-        true,               // is symmetric
-        std::nullopt,       // no preference on the result type
-        [](const af::array& src, const af::array& dst) {
-            auto dst_cols = dst.dims(1);
-            auto result = af::array(1, dst_cols, src.type());
-            gfor(auto otherCol, dst_cols) {
-                auto otherSpan = dst(af::span, otherCol);
-                result(0, otherCol) = _dtw(src, af::reorder(otherSpan, 0, 3, 1, 2));
-            }
-            return result;
-        }
+distance_algorithm_t wdtw(double g, const elastic_options_t &opts) {
+    auto algo = _elastic_algorithm(true, false, 
+        [=](const double *a, dim_t n, const double *b, dim_t m, 
+            std::vector<double> &prev, std::vector<double> &curr) {
+            auto weights = internal::wdtwWeights(std::max(n, m), g);
+            return internal::elastic(_wdtw_cost{{}, a, b, weights}, n, m, opts.window, opts.cutoff, prev, curr);
+        });
+
+    // on dense matrices all the pairs share the same lengths, thus the weights are computed once
+    algo.compute = [=](const af::array& src, const af::array& dst) {
+        auto weights = internal::wdtwWeights(std::max(src.dims(0), dst.dims(0)), g);
+        return _elastic_one_to_many(src, dst, 
+            [&](const double *a, dim_t n, const double *b, dim_t m, 
+                std::vector<double> &prev, std::vector<double> &curr) {
+                return internal::elastic(_wdtw_cost{{}, a, b, weights}, n, m, opts.window, opts.cutoff, prev, curr);
+            });
     };
+    return algo;
+}
+
+distance_algorithm_t erp(double g, const elastic_options_t &opts) {
+    return _elastic_algorithm(true, _unconstrained(opts), 
+        [=](const double *a, dim_t n, const double *b, dim_t m, 
+            std::vector<double> &prev, std::vector<double> &curr) {
+            auto gap_a = _erp_gaps(a, n, g);
+            auto gap_b = _erp_gaps(b, m, g);
+            return internal::elastic(_erp_cost{a, b, g, gap_a, gap_b}, n, m, opts.window, opts.cutoff, prev, curr);
+        });
+}
+
+distance_algorithm_t lcss(double epsilon, const elastic_options_t &opts) {
+    return ELASTIC_DST_ALGORITHM(true, false, (_lcss_cost{a, b, epsilon, std::min(n, m)}));
+}
+
+distance_algorithm_t msm(double c, const elastic_options_t &opts) {
+    return ELASTIC_DST_ALGORITHM(true, _unconstrained(opts), (_msm_cost{{}, a, b, c}));
+}
+
+distance_algorithm_t twe(double nu, double lambda, const elastic_options_t &opts) {
+    return ELASTIC_DST_ALGORITHM(true, _unconstrained(opts), (_twe_cost{{}, a, b, nu, lambda}));
 }
 
 /**
@@ -482,7 +845,14 @@ af::array compute(const distance_algorithm_t& algo, const af::array& xa) {
     // prepare the result array, which is going to be (xa_len,xa_len)
     af::array result = af::constant(0.0, xa_len, xa_len, algo.resultType.value_or(xa.type()));
 
-    if (algo.is_symmetric) {
+    if (algo.compute_all.has_value()) {
+        // the whole matrix in one go; d_ii are set to zero when the 
+        // algorithm is symmetric, as done by the column wise path.
+        result = algo.compute_all.value()(xa, xa).as(result.type());
+        if (algo.is_symmetric) 
+            result = af::select(af::identity(xa_len, xa_len) > 0, 0.0, result);
+    }
+    else if (algo.is_symmetric) {
         // the output is going to be something like:
         //
         //  0  d01 d02 d03
@@ -571,6 +941,9 @@ af::array compute(const distance_algorithm_t& algo, const af::array& xa, const a
     // geometry of the result will be (xa_len, xb_len)
     auto result = af::array(xa_len, xb_len, algo.resultType.value_or(xa.type()));
 
+    if (algo.compute_all.has_value()) 
+        return algo.compute_all.value()(checked_xa, checked_xb).as(result.type());
+
     // Run the algorithm sequentially for every column in xa...
     for (auto xa_col = 0; xa_col < xa_len; xa_col++) {
         auto xa_current = checked_xa(af::span, xa_col);
@@ -582,5 +955,78 @@ af::array compute(const distance_algorithm_t& algo, const af::array& xa, const a
     return result;
 }
 
+namespace {
+
+/**
+ * Retains the k smallest entries of every column in dist, carrying over 
+ * the associated entries in idx.
+ */
+void _keep_nearest(const af::array &dist, const af::array &idx, int k, af::array &best_dist, af::array &best_idx) {
+    auto rows = dist.dims(0);
+    auto cols = dist.dims(1);
+    auto keep = std::min(static_cast<dim_t>(k), rows);
+
+    af::array sorted, perm;
+    af::sort(sorted, perm, dist, 0, true);
+
+    auto top = af::seq(static_cast<double>(keep));
+    best_dist = sorted(top, af::span);
+
+    // translate the per column permutation into linear indices over idx
+    auto offsets = af::iota(af::dim4(1, cols), af::dim4(keep, 1), af::dtype::u32) * static_cast<unsigned int>(rows);
+    auto linear = perm(top, af::span) + offsets;
+    best_idx = af::moddims(idx(af::flat(linear)), keep, cols);
+}
+
+}  // namespace
+
+/**
+ * Finds, for every column in xa, the k nearest columns in xb, streaming xb 
+ * in blocks of block_size columns.
+ */ 
+std::tuple<af::array, af::array> knn(const distance_algorithm_t& algo, const af::array& xa, const af::array &xb, 
+                                     int k, dim_t block_size) {
+    // number of columns in xa
+    auto xa_len = xa.dims(1);
+
+    // number of columns in xb
+    auto xb_len = xb.dims(1);
+
+    if (k < 1)
+        throw std::invalid_argument("The number of neighbours must be greater than zero");
+
+    if (k > xb_len)
+        throw std::invalid_argument("The number of neighbours cannot exceed the number of columns in xb");
+
+    if (block_size < 1)
+        throw std::invalid_argument("The block size must be greater than zero");
+
+    // best candidates found so far, laid out as (k, xa_len) so 
+    // the selection runs along the first dimension
+    af::array best_dist;
+    af::array best_idx;
+
+    for (dim_t start = 0; start < xb_len; start += block_size) {
+        auto end = std::min(start + block_size, xb_len) - 1;
+        auto block = xb(af::span, af::seq(static_cast<double>(start), static_cast<double>(end)));
+
+        // distances of every column in xa against the block; compute 
+        // takes care of padding and of the symmetric optimisations.
+        auto block_dist = compute(algo, xa, block).T();
+        auto block_idx = af::iota(af::dim4(end - start + 1), af::dim4(1, xa_len), af::dtype::u32) + 
+                         static_cast<unsigned int>(start);
+
+        // merge with the candidates of previous blocks
+        if (!best_dist.isempty()) {
+            block_dist = af::join(0, best_dist, block_dist);
+            block_idx = af::join(0, best_idx, block_idx);
+        }
+
+        _keep_nearest(block_dist, block_idx, k, best_dist, best_idx);
+    }
+
+    // return them as (xa_len, k) to match the layout of compute
+    return std::make_tuple(best_dist.T(), best_idx.T());
 }
 
+}
@@ -6,7 +6,11 @@
  */
 
 #include <gauss/features.h>
+#include <gauss/fft.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
 #include <gauss/normalization.h>
+#include <gauss/peaks.h>
 #include <gauss/polynomial.h>
 #include <gauss/regression.h>
 #include <gauss/regularization.h>
@@ -14,154 +18,265 @@
 
 #include <algorithm>
 #include <cmath>
-#include <tuple>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
 #include <utility>
-
-using CWTTuple = std::tuple<std::vector<int>, std::vector<int>, int>;
-using LineTuple = std::tuple<std::vector<int>, std::vector<int>>;
+#include <vector>
 
 using namespace gauss::features;
 
-constexpr dim_t BATCH_SIZE = 2048;
-
 namespace {
 
-af::array entropy(af::array tss, int m, float r) {
-    long n = static_cast<long>(tss.dims(0));
-
-    af::array std = af::stdev(tss);
-    std *= r;
-
-    const long chunkSizeH = 512;
-    const long chunkSizeV = 512;
-    long lastIterationSizeH = chunkSizeH;
-    long lastIterationSizeV = chunkSizeV;
-
-    af::array expandH = af::array(m, chunkSizeH, tss.dims(1), tss.type());
-    af::array expandV = af::array(m, chunkSizeV, tss.dims(1), tss.type());
-
-    // Calculate the matrix distance
-    af::array distances = af::constant(af::Inf, chunkSizeV, chunkSizeH, tss.dims(1), tss.type());
-    af::array sum_c = af::constant(0, 1, chunkSizeH, tss.dims(1), tss.type());
-    af::array sum = af::constant(0, tss.dims(1), tss.type());
-
-    // it performs a batching (or blocking) in the horizontal direction
-    for (int i = 0; i < n - m + 1; i += chunkSizeH) {
-        long startH = i;
-        long iterationSizeH = std::min(chunkSizeH, n - m + 1 - startH);
-        // if our batching dimension does not match the dimesion of the remaining elements, modify dimensions
-        if (iterationSizeH != chunkSizeH || iterationSizeH != lastIterationSizeH) {
-            lastIterationSizeH = iterationSizeH;
-            distances = af::constant(af::Inf, chunkSizeV, iterationSizeH, tss.dims(1), tss.type());
-            sum_c = af::constant(0, 1, iterationSizeH, tss.dims(1), tss.type());
-            expandH = af::array(m, iterationSizeH, tss.dims(1), tss.type());
+/**
+ * Counts the pairs of templates (i < j) whose Chebyshev distance is less or equal to the tolerance, comparing only
+ * the ones whose first values lie within the tolerance of each other.  It is quadratic when most first values are
+ * close, and is only used by matchingPairs when the tolerance is too small for a grid over the values.
+ */
+template <typename T>
+dim_t sortedPairs(const T *x, const std::vector<dim_t> &valid, int m, T tolerance, std::vector<dim_t> *perTemplate) {
+    auto order = valid;
+    std::sort(order.begin(), order.end(), [x](dim_t a, dim_t b) { return x[a] < x[b]; });
+
+    auto count = static_cast<dim_t>(order.size());
+    dim_t pairs = 0;
+    for (dim_t a = 0; a < count; a++) {
+        auto i = order[a];
+        for (dim_t b = a + 1; b < count && x[order[b]] - x[i] <= tolerance; b++) {
+            auto j = order[b];
+            int k = 1;
+            while (k < m && std::abs(x[i + k] - x[j + k]) <= tolerance) k++;
+            if (k < m) continue;
+
+            pairs++;
+            if (perTemplate != nullptr) {
+                (*perTemplate)[i]++;
+                (*perTemplate)[j]++;
+            }
         }
+    }
+    return pairs;
+}
 
-        gfor(af::seq j, static_cast<double>(tss.dims(1))) {
-            for (int k = 0; k < m; k++) {
-                expandH(k, af::span, j, af::span) =
-                    af::reorder(tss(af::seq(i + k, i + k + iterationSizeH - 1), j), 1, 0, 3, 2);
+struct CellHash {
+    size_t operator()(const std::vector<int64_t> &cell) const {
+        size_t h = 0;
+        for (auto c : cell) h = h * 1000003u ^ std::hash<int64_t>()(c);
+        return h;
+    }
+};
+
+/**
+ * Counts the pairs of templates (i < j) of length m, starting at the first `templates` positions of x, whose
+ * Chebyshev distance is less or equal to the tolerance; templates holding a NaN or an infinite value match no
+ * other one.  When perTemplate is given, the matches found for each template are added to it.
+ *
+ * For m = 1 the values are sorted and the matches are counted with a sliding window, or with two binary searches
+ * per template when perTemplate is given, in O(n log n).  Longer templates are bucketed in a grid of cells of side
+ * tolerance over their m coordinates: templates sharing a cell always match, so only the pairs in neighbouring
+ * cells are compared, which keeps the cost close to linear unless many templates crowd into neighbouring cells.
+ */
+template <typename T>
+dim_t matchingPairs(const T *x, dim_t templates, int m, T tolerance, std::vector<dim_t> *perTemplate) {
+    // a NaN tolerance matches nothing
+    if (!(tolerance >= 0)) return 0;
+
+    if (m == 1) {
+        std::vector<T> sorted;
+        sorted.reserve(static_cast<size_t>(templates));
+        for (dim_t i = 0; i < templates; i++)
+            if (std::isfinite(x[i])) sorted.push_back(x[i]);
+        std::sort(sorted.begin(), sorted.end());
+
+        auto count = static_cast<dim_t>(sorted.size());
+        dim_t pairs = 0;
+        if (perTemplate == nullptr) {
+            // the end of the window can only move forward as the first value grows
+            dim_t end = 0;
+            for (dim_t a = 0; a < count; a++) {
+                end = std::max(end, a + 1);
+                while (end < count && sorted[end] - sorted[a] <= tolerance) end++;
+                pairs += end - a - 1;
             }
+            return pairs;
         }
-        // it performs a batching (or blocking) in the vertical direction
-        for (int j = 0; j < n - m + 1; j += chunkSizeV) {
-            long startV = j;
-            long iterationSizeV = std::min(chunkSizeV, n - m + 1 - startV);
-            // if our batching dimension does not match the dimension of the remaining elements, modify dimensions
-            if (iterationSizeV != chunkSizeV || iterationSizeV != lastIterationSizeV) {
-                lastIterationSizeV = iterationSizeV;
-                distances = af::constant(af::Inf, iterationSizeV, chunkSizeH, tss.dims(1), tss.type());
-                expandV = af::array(m, iterationSizeV, tss.dims(1), tss.type());
-            }
 
-            gfor(af::seq k, static_cast<double>(tss.dims(1))) {
-                for (int l = 0; l < m; l++) {
-                    expandV(l, af::span, k, af::span) =
-                        af::reorder(tss(af::seq(j + l, j + l + iterationSizeV - 1), k), 1, 0, 3, 2);
+        for (dim_t i = 0; i < templates; i++) {
+            if (!std::isfinite(x[i])) continue;
+            auto low = std::partition_point(sorted.begin(), sorted.end(), [&](T y) { return x[i] - y > tolerance; });
+            auto high = std::partition_point(low, sorted.end(), [&](T y) { return y - x[i] <= tolerance; });
+            auto matches = static_cast<dim_t>(high - low) - 1;
+            (*perTemplate)[i] += matches;
+            pairs += matches;
+        }
+        return pairs / 2;
+    }
+
+    auto n = templates + m - 1;
+    std::vector<dim_t> valid;
+    valid.reserve(static_cast<size_t>(templates));
+    auto lowest = std::numeric_limits<T>::infinity();
+    auto highest = -std::numeric_limits<T>::infinity();
+    dim_t lastInvalid = -1;
+    for (dim_t k = 0; k < n; k++) {
+        if (std::isfinite(x[k])) {
+            lowest = std::min(lowest, x[k]);
+            highest = std::max(highest, x[k]);
+        } else {
+            lastInvalid = k;
+        }
+        if (k >= m - 1 && lastInvalid < k - m + 1) valid.push_back(k - m + 1);
+    }
+    if (valid.empty()) return 0;
+
+    // cells of side tolerance, or one cell per distinct value when only equal values match; cells whose
+    // coordinates could not be told apart in double precision fall back to comparing sorted templates
+    std::vector<int64_t> coords(static_cast<size_t>(n), 0);
+    if (tolerance > 0) {
+        if (!(static_cast<double>(highest - lowest) / static_cast<double>(tolerance) < 4503599627370496.0))
+            return sortedPairs(x, valid, m, tolerance, perTemplate);
+        for (dim_t k = 0; k < n; k++)
+            if (std::isfinite(x[k]))
+                coords[k] = static_cast<int64_t>(
+                    std::floor((static_cast<double>(x[k]) - static_cast<double>(lowest)) / tolerance));
+    } else {
+        std::vector<T> distinct;
+        for (dim_t k = 0; k < n; k++)
+            if (std::isfinite(x[k])) distinct.push_back(x[k]);
+        std::sort(distinct.begin(), distinct.end());
+        distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+        for (dim_t k = 0; k < n; k++)
+            if (std::isfinite(x[k]))
+                coords[k] = std::lower_bound(distinct.begin(), distinct.end(), x[k]) - distinct.begin();
+    }
+
+    std::unordered_map<std::vector<int64_t>, std::vector<dim_t>, CellHash> cells;
+    for (auto i : valid) cells[std::vector<int64_t>(coords.begin() + i, coords.begin() + i + m)].push_back(i);
+
+    // offsets to the neighbouring cells whose first non zero coordinate is positive, so every pair of cells is
+    // visited once; with a zero tolerance only the templates of the same cell match
+    std::vector<std::vector<int64_t>> offsets;
+    if (tolerance > 0) {
+        std::vector<int64_t> offset(static_cast<size_t>(m), -1);
+        while (true) {
+            auto first = std::find_if(offset.begin(), offset.end(), [](int64_t o) { return o != 0; });
+            if (first != offset.end() && *first > 0) offsets.push_back(offset);
+            int k = m - 1;
+            while (k >= 0 && offset[k] == 1) offset[k--] = -1;
+            if (k < 0) break;
+            offset[k]++;
+        }
+    }
+
+    dim_t pairs = 0;
+    std::vector<int64_t> neighbour(static_cast<size_t>(m));
+    for (const auto &cell : cells) {
+        const auto &members = cell.second;
+        auto size = static_cast<dim_t>(members.size());
+        pairs += size * (size - 1) / 2;
+        if (perTemplate != nullptr)
+            for (auto i : members) (*perTemplate)[i] += size - 1;
+
+        for (const auto &offset : offsets) {
+            for (int k = 0; k < m; k++) neighbour[k] = cell.first[k] + offset[k];
+            auto found = cells.find(neighbour);
+            if (found == cells.end()) continue;
+
+            for (auto i : members) {
+                for (auto j : found->second) {
+                    int k = 0;
+                    while (k < m && std::abs(x[i + k] - x[j + k]) <= tolerance) k++;
+                    if (k < m) continue;
+
+                    pairs++;
+                    if (perTemplate != nullptr) {
+                        (*perTemplate)[i]++;
+                        (*perTemplate)[j]++;
+                    }
                 }
             }
-            // Get the maximum difference among all dimensions for each timeseries
-            gfor(af::seq k, iterationSizeV) {
-                af::array aux = af::tile(expandV(af::span, k, af::span), 1, static_cast<unsigned int>(iterationSizeH));
-                distances = af::reorder(
-                    af::max(af::abs(aux - af::tile(expandH, 1, 1, 1, static_cast<unsigned int>(iterationSizeV)))), 3, 1,
-                    2, 0);
-            }
-            // sum the number of elements bigger than the threshhold given by (stdev*r)
-            af::array count =
-                distances <= af::tile(af::reorder(std, 0, 2, 1, 3), static_cast<unsigned int>(distances.dims(0)),
-                                      static_cast<unsigned int>(distances.dims(1)));
-            // we summarise all partial sums in sum; we accumulate all partial sums for each vertical dimension
-            sum_c += af::sum(count, 0);
         }
-        // Finally, we collapse (aggregate) all total sums for each timeseries, we can do it as sum is commutative and
-        // associative.
-        sum += af::reorder(af::sum(af::log(sum_c / (n - m + 1.0)), 1), 2, 0, 1, 3);
     }
-    // Before returning the final value, we divide the total sum for each timeseries by (n - m + 1.0)
-    sum /= (n - m + 1.0);
+    return pairs;
+}
+
+/**
+ * Average of the logarithm of the fraction of templates of length m, self matches included, within the
+ * tolerance of each template.
+ */
+template <typename T>
+double phi(const T *x, dim_t n, int m, T tolerance) {
+    auto templates = n - m + 1;
+    std::vector<dim_t> matches(static_cast<size_t>(templates), 1);
+    matchingPairs(x, templates, m, tolerance, &matches);
 
-    return sum;
+    double sum = 0.0;
+    for (auto c : matches) sum += std::log(static_cast<double>(c) / static_cast<double>(templates));
+    return sum / static_cast<double>(templates);
 }
 
-// af::array aggregatingOnChunks(const af::array &input, long chunkSize, AggregationFuncInt aggregationFunction) {
-//     // Calculating the chunk size to split the input data into. The rest of dividing the input data
-//     // length by the chunk size should be zero. In other words, input data length should be multiple
-//     // of the chunk size
-//     auto size = (input.dims(0) % chunkSize == 0) ? 0 : chunkSize - input.dims(0) % chunkSize;
-//     // If it is not multiple, then pad with zeros at the end
-//     af::array inputChunks = af::join(0, input, af::constant(0, size, input.dims(1), input.type()));
-//     // Modify the array dimensions to split it by the chunk size
-//     inputChunks = af::moddims(inputChunks, chunkSize, inputChunks.dims(0) / chunkSize, inputChunks.dims(1));
-//     // Aggregate the data using the aggregation function specified as parameter, and then reorder
-//     // the resulting array to have the number of chunks in the 2nd dimension
-//     return af::reorder(af::transpose(aggregationFunction(inputChunks, 0)), 0, 2, 1, 3);
-// }
+/**
+ * Evaluates fn(column, tolerance) for every column of tss on the host threads, where the tolerance is r times the
+ * standard deviation of the column.
+ */
+template <typename T, typename Fn>
+af::array perColumn(const af::array &tss, float r, Fn &&fn) {
+    auto n = tss.dims(0);
+    auto columns = tss.dims(1);
+    auto values = gauss::vectorutil::get<T>(tss.as(af::dtype_traits<T>::af_type));
+    auto tolerances =
+        gauss::vectorutil::get<T>((gauss::statistics::stdev(tss, 0) * r).as(af::dtype_traits<T>::af_type));
 
-// af::array aggregatingOnChunks(const af::array &input, long chunkSize, AggregationFuncDimT aggregationFunction) {
-//     // Calculating the chunk size to split the input data into. The rest of dividing the input data
-//     // length by the chunk size should be zero. In other words, input data length should be multiple
-//     // of the chunk size
-//     auto size = (input.dims(0) % chunkSize == 0) ? 0 : chunkSize - input.dims(0) % chunkSize;
-//     // If it is not multiple, then pad with zeros at the end
-//     af::array inputChunks = af::join(0, input, af::constant(0, size, input.dims(1), input.type()));
-//     // Modify the array dimensions to split it by the chunk size
-//     inputChunks = af::moddims(inputChunks, chunkSize, inputChunks.dims(0) / chunkSize, inputChunks.dims(1));
-//     // Aggregate the data using the aggregation function specified as parameter, and then reorder
-//     // the resulting array to have the number of chunks in the 2nd dimension
-//     return af::reorder(af::transpose(aggregationFunction(inputChunks, 0)), 0, 2, 1, 3);
-// }
+    std::vector<T> result(static_cast<size_t>(columns));
+    gauss::parallel::parallelFor(0, columns, [&](dim_t c) {
+        result[c] = static_cast<T>(fn(values.data() + c * n, tolerances[c]));
+    });
+    return af::array(1, columns, result.data()).as(tss.type());
+}
 
-af::array ricker(int points, int a) {
-    double pi = 3.14159265358979323846264338327950288;
-    double A = 2 / (std::sqrt(3 * a) * std::pow(pi, 0.25));
-    double wsq = std::pow(a, 2);
-    af::array vec = af::range(af::dim4(points)) - ((points - 1) / 2.0);
-    af::array xsq = af::pow(vec, 2);
-    af::array mod = (1 - xsq / wsq);
-    af::array gauss = af::exp(-xsq / (2 * wsq));
-    af::array total = A * mod * gauss;
-    return total;
+af::array approximateEntropyOf(const af::array &tss, int m, float r) {
+    auto n = tss.dims(0);
+    auto entropy = [n, m](const auto *x, auto tolerance) {
+        return std::abs(phi(x, n, m, tolerance) - phi(x, n, m + 1, tolerance));
+    };
+    if (tss.type() == af::dtype::f64) return perColumn<double>(tss, r, entropy);
+    return perColumn<float>(tss, r, entropy);
 }
 
-af::array cwt(const af::array &data, af::array widths) {
-    int nw = static_cast<int>(widths.dims(0));
-    int len_data = static_cast<int>(data.dims(0));
-    int cols = static_cast<int>(data.dims(1));
-    af::array filter;
-    af::array output = af::constant(0, widths.dims(0), data.dims(0), data.dims(1), af::dtype::f32);
-
-    for (int i = 0; i < nw; i++) {
-        int w = widths(i).scalar<int>();
-        int minimum = std::min(10 * w, len_data);
-        af::array wavelet_data = ricker(minimum, w);
-        if (wavelet_data.dims(0) != data.dims(0)) {
-            wavelet_data = af::join(0, af::constant(0, 1, wavelet_data.dims(1)), wavelet_data);
-        }
-        output(i, af::span, af::span) =
-            af::moddims(af::convolve(af::reorder(data, 0, 2, 1), wavelet_data), 1, len_data, cols);
+af::array sampleEntropyOf(const af::array &tss, float r) {
+    auto n = tss.dims(0);
+    auto entropy = [n](const auto *x, auto tolerance) {
+        auto matches = static_cast<double>(matchingPairs(x, n, 1, tolerance, nullptr));
+        auto pairs = static_cast<double>(n) * static_cast<double>(n - 1) / 2.0;
+        return -std::log(matches / pairs);
+    };
+    if (tss.type() == af::dtype::f64) return perColumn<double>(tss, r, entropy);
+    return perColumn<float>(tss, r, entropy);
+}
+
+/**
+ * Sorts every column of tss (unless they are already sorted) and finds the runs of equal values in them: starts
+ * flags the first element of each run and lengths holds, for every element, the length of the run it belongs to.
+ * All the columns are processed at once, without leaving the device.
+ */
+void runLengths(const af::array &tss, bool isSorted, af::array &sorted, af::array &starts, af::array &lengths) {
+    auto n = tss.dims(0);
+    sorted = isSorted ? tss : af::sort(tss, 0);
+    if (n < 2) {
+        starts = af::constant(1, n, tss.dims(1), af::dtype::b8);
+        lengths = af::constant(1, n, tss.dims(1), af::dtype::u32);
+        return;
     }
-    return output;
+
+    starts = af::join(0, af::constant(1, 1, tss.dims(1), af::dtype::b8), af::diff1(sorted, 0) != 0);
+
+    // Consecutive elements of a run share the same key, so counting forwards and backwards within each key gives
+    // the position of every element counted from both ends of its run
+    af::array keys = af::accum(starts.as(af::dtype::s32), 0);
+    af::array ones = af::constant(1, n, tss.dims(1), af::dtype::u32);
+    af::array forward = af::scanByKey(keys, ones, 0);
+    af::array backward = af::flip(af::scanByKey(af::flip(keys, 0), ones, 0), 0);
+    lengths = forward + backward - 1;
 }
 
 af::array calculateMoment(const af::array &tss, int moment) {
@@ -224,215 +339,6 @@ af::array calculateKurtosis(const af::array &tss) {
 //     return result;
 // }
 
-int indexMinValue(std::vector<int> values) {
-    int result = -1;
-    int minimum = std::numeric_limits<int>::max();
-    for (size_t i = 0; i < values.size(); i++) {
-        if (values[i] < minimum) {
-            minimum = values[i];
-            result = static_cast<int>(i);
-        }
-    }
-    return result;
-}
-
-std::vector<int> subsValueToVector(int a, const std::vector<int> &v) {
-    std::vector<int> res;
-    for (auto value : v) {
-        res.emplace_back(std::abs(std::abs(value) - std::abs(a)));
-    }
-    return res;
-}
-
-af::array localMaximals(const af::array &tss) {
-    af::array plus = af::shift(tss, 0, -1);
-    auto plusDims1 = plus.dims(1);
-    plus(af::span, plusDims1 - 1, af::span) = plus(af::span, plusDims1 - 2, af::span);
-
-    af::array minus = af::shift(tss, 0, 1);
-    minus(af::span, 0, af::span) = minus(af::span, 1, af::span);
-
-    af::array res1 = (tss > plus);
-    af::array res2 = (tss > minus);
-    af::array result = (res1 * res2).as(af::dtype::s32);
-
-    return result;
-}
-
-// std::vector<LineTuple> identifyRidgeLines(const af::array &cwt_tss, const algos::array::Array<float> &maxDistances,
-//                                           float gapThresh) {
-//     std::vector<LineTuple> outLines;
-
-//     // Gets all local maximals
-//     af::array maximals = localMaximals(cwt_tss);
-//     algos::array::Array<int> relativeMaximals(maximals);
-
-//     // Gets all rows which contains at least one maximal
-//     std::vector<int> rowsWithMaximal = algos::array::getRowsWithMaximals(relativeMaximals);
-//     if (rowsWithMaximal.empty()) {
-//         return outLines;
-//     }
-
-//     // Gets the last row with a maximal
-//     auto startRow = rowsWithMaximal.back();
-
-//     // Setting the first Ridge Lines (rows, cols, gap number)
-//     std::vector<int> lastRowCols = algos::array::getIndexMaxColumns(relativeMaximals.getRow(startRow));
-//     std::vector<CWTTuple> ridgeLines;
-
-//     for (auto c : lastRowCols) {
-//         std::vector<int> rows;
-//         rows.push_back(startRow);
-//         std::vector<int> cols;
-//         cols.push_back(c);
-//         CWTTuple newRidge = std::make_tuple(rows, cols, 0);
-//         ridgeLines.push_back(newRidge);
-//     }
-
-//     // For storing the final lines
-//     std::vector<CWTTuple> finalLines;
-
-//     // Generate a range for rows
-//     std::vector<int> rows;
-//     for (int i = startRow - 1; i > -1; i--) {
-//         rows.push_back(i);
-//     }
-//     // Generate a range for cols
-//     std::vector<int> cols;
-//     for (int i = 0; i < cwt_tss.dims(1); i++) {
-//         cols.push_back(i);
-//     }
-
-//     for (const int &row : rows) {
-//         std::vector<int> thisMaxCols = algos::array::getIndexMaxColumns(relativeMaximals.getRow(row));
-
-//         // Increment the gap number of each line
-//         for (auto &line : ridgeLines) {
-//             std::get<2>(line) = std::get<2>(line) + 1;
-//         }
-
-//         // We store the last col for each line in prevRidgeCols
-//         std::vector<int> prevRidgeCols;
-//         for (auto &line : ridgeLines) {
-//             prevRidgeCols.push_back(std::get<1>(line).back());
-//         }
-
-//         // Look through every relative maximum found at current row, attempt to connect them with
-//         // existing ridge lines.
-//         for (int col : thisMaxCols) {
-//             CWTTuple *line = nullptr;
-//             bool filled = false;
-//             // If there is a previous ridge line within
-//             // the max_distance to connect to, do so.
-//             // Otherwise start a new one.
-//             if (!prevRidgeCols.empty()) {
-//                 std::vector<int> diffs = subsValueToVector(col, prevRidgeCols);
-//                 int closest = indexMinValue(diffs);
-//                 if (diffs[closest] <= maxDistances.getRow(row).front()) {
-//                     line = &ridgeLines[closest];
-//                     filled = true;
-//                 }
-//             }
-//             if (filled) {
-//                 // Found a point close enough, extend current ridge line
-//                 std::vector<int> rows2 = std::get<0>(*line);
-//                 rows2.push_back(row);
-//                 std::get<0>(*line) = rows2;
-
-//                 std::vector<int> cols2 = std::get<1>(*line);
-//                 cols2.push_back(col);
-//                 std::get<1>(*line) = cols2;
-
-//                 std::get<2>(*line) = 0;
-//             } else {
-//                 std::vector<int> rows2;
-//                 rows2.push_back(row);
-//                 std::vector<int> cols2;
-//                 cols2.push_back(col);
-//                 CWTTuple newLine = std::make_tuple(rows2, cols2, 0);
-//                 ridgeLines.push_back(newLine);
-//             }
-//         }
-
-//         // Remove the ridgeLines with a gap_number too high
-//         for (int ind = static_cast<int>(ridgeLines.size()) - 1; ind > -1; ind--) {
-//             CWTTuple ridge = ridgeLines[ind];
-//             if (std::get<2>(ridge) > gapThresh) {
-//                 finalLines.push_back(ridge);
-//                 ridgeLines.erase(ridgeLines.begin() + ind);
-//             }
-//         }
-//     }
-
-//     finalLines.insert(finalLines.end(), ridgeLines.begin(), ridgeLines.end());
-
-//     for (auto line : finalLines) {
-//         auto l = std::make_tuple(std::get<0>(line), std::get<1>(line));
-//         outLines.push_back(l);
-//     }
-
-//     return outLines;
-// }
-
-float scoreAtPercentile(std::vector<float> row, int start, int end, float noisePerc) {
-    std::vector<float> target;
-    target.insert(target.end(), row.begin() + start, row.begin() + end);
-
-    std::sort(target.begin(), target.end());
-    float idx = noisePerc / 100.0f * (target.size() - 1);
-    int i = (int)idx;
-    if (i == idx) {
-        return target[i];
-    } else {
-        int j = i + 1;
-        float w1 = j - idx;
-        float w2 = idx - i;
-        float sumval = w1 + w2;
-        float sum = target[i] * w1 + target[j] * w2;
-        return sum / sumval;
-    }
-
-    return 0.0f;
-}
-
-// std::vector<LineTuple> filterFunction(const std::vector<LineTuple> &ridgeLines, std::vector<float> noises,
-//                                       const algos::array::Array<float> &cwt, int minSnr, int minLength) {
-//     std::vector<LineTuple> res;
-
-//     for (auto line : ridgeLines) {
-//         if (static_cast<int>(std::get<0>(line).size()) >= minLength) {
-//             float snr = std::abs(cwt.getElement(std::get<0>(line).front(), std::get<1>(line).front()) /
-//                                  noises[std::get<1>(line).front()]);
-//             if (snr >= minSnr) {
-//                 res.push_back(line);
-//             }
-//         }
-//     }
-//     return res;
-// }
-
-// std::vector<LineTuple> filterRidgeLines(const af::array &cwtDat, const std::vector<LineTuple> &ridgeLines, int minSnr,
-//                                         float noisePerc) {
-//     int numPoints = static_cast<int>(cwtDat.dims(1));
-//     int minLength = static_cast<int>(std::ceil(cwtDat.dims(0) / 4.0));
-//     int windowSize = static_cast<int>(std::ceil(numPoints / 20.0));
-//     int hfWindow = windowSize / 2;
-//     int odd = windowSize % 2;
-
-//     algos::array::Array<float> cwtValues(cwtDat);
-
-//     std::vector<float> rowOne = cwtValues.getRow(0);
-//     std::vector<float> noises(rowOne.size());
-
-//     for (int i = 0; i < static_cast<int>(rowOne.size()); i++) {
-//         int windowStart = std::max(i - hfWindow, 0);
-//         int windowEnd = std::min(i + hfWindow + odd, numPoints);
-//         noises[i] = scoreAtPercentile(rowOne, windowStart, windowEnd, noisePerc);
-//     }
-
-//     return filterFunction(ridgeLines, noises, cwtValues, minSnr, minLength);
-// }
-
 af::array cidCeInternal(const af::array &tss) {
     auto n = tss.dims(0);
     // Calculating tss(t + 1) - tss(t) from 0 to the length of the time series minus 1
@@ -443,76 +349,6 @@ af::array cidCeInternal(const af::array &tss) {
     return af::sqrt(af::sum(diff * diff));
 }
 
-
-/**
- *  @brief Return a Hann window.
- *  The Hann window is a taper formed by using a raised cosine or sine-squared with ends that touch
- *  zero.
- *
- *  The Hann window is defined as:
- * \f[
- *      w(n) = 0.5 - 0.5 \cos\left(\frac{2\pi{n}}{M-1}\right)
- *              \qquad 0 \leq n \leq M-1
- * \f]
- *  The window was named for Julius von Hann, an Austrian meteorologist. It is also known as the
- *  Cosine Bell. It is sometimes erroneously referred to as
- *  the "Hanning" window, from the use of "hann" as a verb in the original
- *  paper and confusion with the very similar Hamming window.
- *
- * @param m Number of points in the output window. If zero or less, an empty array is returned.
- * @param sym When True, generates a symmetric window, for use in filter design. When
- * False, generates a periodic window, for use in spectral analysis.
- * @return af::array The window, with the maximum value normalized to 1 (though the value 1 does
- * not appear if m is even and sym is True).
- */
-af::array hannWindow(int m, bool sym) {
-    af::array window;
-    af::array a = af::constant(0.5, 2, 1);
-
-    if (!sym) {
-        window = af::constant(0, m + 1, 1);
-    } else {
-        window = af::constant(0, m, 1);
-    }
-
-    double step = (2 * af::Pi) / (m);
-    af::seq s(-af::Pi, af::Pi, step);
-    af::array fac = s;
-    for (int k = 0; k < a.dims(0); k++) {
-        window += 0.5 * af::cos(k * fac);
-    }
-    return window(af::seq(0, m - 1));
-}
-
-/**
- *  @brief This function detrends the given time series.
- *  @param data The time series.
- *  @return af::array The detrended time timeseries.
- */
-af::array detrend(const af::array &data) {
-    af::array result = data - af::tile(af::mean(data, 0), static_cast<unsigned int>(data.dims(0)));
-    return result;
-}
-
-/**
- * @brief This is a helper function that does the main FFT calculation. All input valdiation is performed there,
- * and the data axis is assumed to be the last axis of x. It is not designed to be called externally.
- * @param tss The given time series.
- * @param win The fft windows.
- * @param nperseg
- * @param noverlap Overlapping points.
- * @param nfft number of ffts points
- * @return af::array the result from each window is returned.
- */
-af::array fftHelper(const af::array &tss, const af::array &win) {
-    af::array result = af::seq(0, static_cast<double>(tss.dims(0)) - 1);
-    result = detrend(result);
-    result = win * result;
-    result = af::fft(result, 0);
-
-    return result(af::seq(0, static_cast<double>(result.dims(0)) / 2));
-}
-
 }  // namespace
 
 af::array gauss::features::absEnergy(const af::array &base) {
@@ -531,29 +367,36 @@ af::array gauss::features::absoluteSumOfChanges(const af::array &tss) {
 
 
 
-// void gauss::features::aggregatedLinearTrend(const af::array &t, long chunkSize, AggregationFuncDimT aggregationFunction,
-//                                             af::array &slope, af::array &intercept, af::array &rvalue,
-//                                             af::array &pvalue, af::array &stderrest) {
-//     // Aggregating the data using the specified chunk size and aggregation function
-//     af::array aggregateResult = aggregatingOnChunks(t, chunkSize, aggregationFunction);
-//     // Preparing the x vector for the linear regression. Tiling it to the number of time series
-//     // contained in t
-//     af::array x = af::tile(af::range(aggregateResult.dims(0)).as(t.type()), 1, static_cast<unsigned int>(t.dims(1)));
-//     // Calculating the linear regression and storing the results in the parameters passed as reference
-//     gauss::regression::linear(x, aggregateResult, slope, intercept, rvalue, pvalue, stderrest);
-// }
+void gauss::features::aggregatedLinearTrend(const af::array &tss, long chunkSize, Aggregation aggregation,
+                                            af::array &slope, af::array &intercept, af::array &rvalue,
+                                            af::array &pvalue, af::array &stderrest) {
+    aggregatedLinearTrend(tss, chunkSize, std::vector<Aggregation>{aggregation}, slope, intercept, rvalue, pvalue,
+                          stderrest);
+}
 
-// void gauss::features::aggregatedLinearTrend(const af::array &t, long chunkSize, AggregationFuncInt aggregationFunction,
-//                                             af::array &slope, af::array &intercept, af::array &rvalue,
-//                                             af::array &pvalue, af::array &stderrest) {
-//     // Aggregating the data using the specified chunk size and aggregation function
-//     af::array aggregateResult = aggregatingOnChunks(t, chunkSize, aggregationFunction);
-//     // Preparing the x vector for the linear regression. Tiling it to the number of time series
-//     // contained in t
-//     af::array x = af::tile(af::range(aggregateResult.dims(0)).as(t.type()), 1, static_cast<unsigned int>(t.dims(1)));
-//     // Calculating the linear regression and storing the results in the parameters passed as reference
-//     gauss::regression::linear(x, aggregateResult, slope, intercept, rvalue, pvalue, stderrest);
-// }
+void gauss::features::aggregatedLinearTrend(const af::array &tss, long chunkSize,
+                                            const std::vector<Aggregation> &aggregations, af::array &slope,
+                                            af::array &intercept, af::array &rvalue, af::array &pvalue,
+                                            af::array &stderrest) {
+    // (chunks, series, aggregations), laid out as (chunks, series * aggregations) so that every aggregation of
+    // every series is regressed at once
+    af::array aggregated = aggregateOnChunks(tss, chunkSize, aggregations);
+    auto chunks = aggregated.dims(0);
+    auto series = aggregated.dims(1);
+    auto count = aggregated.dims(2);
+    aggregated = af::moddims(aggregated, chunks, series * count);
+
+    af::array x = af::tile(af::range(chunks).as(aggregated.type()), 1, static_cast<unsigned int>(series * count));
+    gauss::regression::linear(x, aggregated, slope, intercept, rvalue, pvalue, stderrest);
+
+    // back to (aggregations, series)
+    auto layout = [series, count](const af::array &a) { return af::transpose(af::moddims(a, series, count)); };
+    slope = layout(slope);
+    intercept = layout(intercept);
+    rvalue = layout(rvalue);
+    pvalue = layout(pvalue);
+    stderrest = layout(stderrest);
+}
 
 af::array gauss::features::approximateEntropy(const af::array &tss, int m, float r) {
     long n = static_cast<long>(tss.dims(0));
@@ -561,11 +404,15 @@ af::array gauss::features::approximateEntropy(const af::array &tss, int m, float
         throw std::invalid_argument("Parameter r must be positive ...");
     }
 
+    if (m < 1) {
+        throw std::invalid_argument("Parameter m must be greater than zero ...");
+    }
+
     if (n <= (m + 1)) {
-        return 0;
+        return af::constant(0, 1, tss.dims(1), tss.type());
     }
 
-    return af::abs(entropy(tss, m, r) - entropy(tss, m + 1, r));
+    return approximateEntropyOf(tss, m, r);
 }
 
 
@@ -621,13 +468,9 @@ af::array gauss::features::countBelowMean(const af::array &tss) {
 af::array gauss::features::cwtCoefficients(const af::array &tss, const af::array &widths, int coeff, int w) {
     int len = static_cast<int>(tss.dims(0));
     int nts = static_cast<int>(tss.dims(1));
-    if (len < coeff) {
-        return af::constant(af::NaN, 1, nts);
-    }
-    if (len < coeff) {
+    if (coeff >= len) {
         return af::constant(af::NaN, 1, nts);
     }
-    af::array output = cwt(tss, widths);
 
     // To find w in widths
     af::array index;
@@ -636,21 +479,24 @@ af::array gauss::features::cwtCoefficients(const af::array &tss, const af::array
     af::max(maximum, index, aux, 0);
     // WORKAROUND: Forcing movement of index to CPU mem, just to avoid problems with Intel GPU
     auto i = index.scalar<unsigned int>();
+    // Only the transform for the width of interest is computed
+    af::array output = gauss::fft::cwt(tss, widths(i), gauss::fft::Wavelet::Ricker);
     // Select the corresponding values of coeff and w
-    return af::reorder(output(i, coeff, af::span), 0, 2, 1);
+    return af::reorder(output(0, coeff, af::span), 0, 2, 1);
 }
 
 af::array gauss::features::energyRatioByChunks(af::array tss, long numSegments, long segmentFocus) {
-    // Calculating the energy of all the time series
-    af::array fullSeriesEnergy = gauss::features::absEnergy(tss);
     long n = static_cast<long>(tss.dims(0));
-    // Calculating the segment length given the length of the time series and the number of segments
-    long segmentLength = n / numSegments;
-    // Positioning at the beginning of the segment to focus on
-    long start = segmentFocus * segmentLength;
-    // Calculating the end (which should be lower than the length of the time series)
-    long end = std::min((segmentFocus + 1) * segmentLength, n);
-    return gauss::features::absEnergy(tss(af::seq(start, end - 1), af::span)) / fullSeriesEnergy;
+    if (numSegments < 1 || numSegments > n)
+        throw std::invalid_argument("The number of segments must be between one and the length of the time series");
+    if (segmentFocus < 0 || segmentFocus >= numSegments)
+        throw std::invalid_argument("The segment focus must be lower than the number of segments");
+
+    // The energy of every segment is computed at once; when the length of the time series is not a multiple of
+    // the number of segments, the values beyond the last segment make up one or more trailing chunks (up to
+    // numSegments - 1 values), which only count towards the energy of the full series
+    af::array energies = aggregateOnChunks(tss, n / numSegments, {Aggregation::ENERGY});
+    return energies(segmentFocus, af::span) / af::sum(energies, 0);
 }
 
 af::array gauss::features::fftAggregated(const af::array &tss) {
@@ -723,19 +569,10 @@ af::array gauss::features::firstLocationOfMinimum(const af::array &tss) {
 // }
 
 af::array gauss::features::hasDuplicates(const af::array &tss) {
-    // Array with the number of input time series in the 1st dimension of type bool
-    auto result = af::array(tss.dims(1), af::dtype::b8);
-
-    // Doing it sequentially because af::setUnique only works with vectors
-    for (dim_t i = 0; i < tss.dims(1); ++i) {
-        // Calculating the unique elements for each time series
-        af::array uniq = af::setUnique(tss(af::span, i));
-        // If the number of elements differ, then the time series has duplicates
-        result(i) = tss.dims(0) != uniq.dims(0);
-    }
-
-    // Transposing the array to match the dimensions of the output
-    return af::transpose(result);
+    af::array sorted, starts, lengths;
+    runLengths(tss, false, sorted, starts, lengths);
+    // There are duplicates whenever there are fewer runs of equal values than elements
+    return af::count(starts, 0) < tss.dims(0);
 }
 
 af::array gauss::features::hasDuplicateMax(const af::array &tss) {
@@ -771,7 +608,7 @@ af::array gauss::features::kurtosis(const af::array &tss) {
 }
 
 af::array gauss::features::largeStandardDeviation(const af::array &tss, float r) {
-    return af::stdev(tss, 0) > (r * (af::max(tss, 0) - af::min(tss, 0)));
+    return gauss::statistics::stdev(tss, 0) > (r * (af::max(tss, 0) - af::min(tss, 0)));
 }
 
 af::array gauss::features::lastLocationOfMaximum(const af::array &tss) {
@@ -889,96 +726,32 @@ af::array gauss::features::numberCrossingM(const af::array &tss, int m) {
     return af::sum(af::abs(af::diff1(tss > m)), 0).as(tss.type());
 }
 
-// af::array algos::features::numberCwtPeaks(const af::array &tss, int maxW) {
-//     af::array out = af::constant(0, 1, tss.dims(1), tss.type());
-
-//     af::array widths = (af::range(af::dim4(maxW)) + 1).as(af::dtype::s32);
-//     float gapThresh = 1;
-//     af::array max_distances = widths / 4.0;
-//     algos::array::Array<float> maxDistances(max_distances);
-
-//     // Computing one timeseries at a time, due to divergencies in the algorithm
-//     for (int i = 0; i < tss.dims(1); i++) {
-//         af::array cwt_tss = cwt(tss(af::span, i), widths);
-
-//         std::vector<LineTuple> ridgeLines = identifyRidgeLines(cwt_tss, maxDistances, gapThresh);
-
-//         std::vector<LineTuple> filtered = filterRidgeLines(cwt_tss, ridgeLines, 1, 10);
-
-//         std::vector<int> maxLoc;
-//         for (auto line : filtered) {
-//             maxLoc.push_back(std::get<1>(line).front());
-//         }
-
-//         std::sort(maxLoc.begin(), maxLoc.end());
-//         out(0, i) = maxLoc.size();
-//     }
-
-//     return out;
-// }
+af::array gauss::features::numberCwtPeaks(const af::array &tss, int maxW) {
+    peak_options_t options;
+    options.mode = PeakMode::CWT_RIDGE;
+    options.maxWidth = maxW;
+    return findPeaks(tss, options).counts.as(tss.type());
+}
 
 af::array gauss::features::numberPeaks(af::array tss, int n) {
-    auto length = tss.dims(0);
-    af::array tssReduced = tss(af::seq(n, length - n - 1), af::span);
-
-    // Initializing it to ones
-    af::array res = tssReduced == tssReduced;
-    for (int i = 1; i < n + 1; i++) {
-        af::array rightShifted = af::shift(tss, i)(af::seq(n, length - n - 1), af::span);
-        af::array leftShifted = af::shift(tss, -i)(af::seq(n, length - n - 1), af::span);
-        res = res & ((tssReduced > rightShifted) & (tssReduced > leftShifted));
-    }
-
-    return af::sum(res.as(tss.type()), 0);
+    peak_options_t options;
+    options.support = n;
+    return findPeaks(tss, options).counts.as(tss.type());
 }
 
 af::array gauss::features::percentageOfReoccurringDatapointsToAllDatapoints(const af::array &tss, bool isSorted) {
-    af::array result = af::array(1, tss.dims(1), tss.type());
-    // Doing it sequentially because the setUnique function can only be used with a vector
-    for (int i = 0; i < tss.dims(1); i++) {
-        af::array unique = af::setUnique(tss(af::span, i), isSorted);
-        auto n = unique.dims(0);
-        // The chunk size cannot be greater than the length of the unique values
-        auto chunkSize = std::min(n, BATCH_SIZE);
-
-        af::array tmpResult = af::array(0, tss.type());
-
-        for (dim_t j = 0; j < n; j += chunkSize) {
-            // The iteration space cannot be greater than what is left (n - j)
-            auto iterationSize = std::min(chunkSize, n - j);
-            af::array uniqueChunk = unique(af::seq(j, j + iterationSize - 1));
-
-            af::array tssTiled = af::tile(tss(af::span, i), 1, static_cast<unsigned int>(uniqueChunk.dims(0)));
-            uniqueChunk = af::transpose(af::tile(uniqueChunk, 1, static_cast<unsigned int>(tss.dims(0))));
-
-            tmpResult = af::join(0, tmpResult, af::sum(af::sum(uniqueChunk == tssTiled, 0) > 1, 1).as(tss.type()));
-        }
-        result(i) = af::sum(tmpResult, 0) / (float)unique.dims(0);
-    }
-
-    return result;
+    af::array sorted, starts, lengths;
+    runLengths(tss, isSorted, sorted, starts, lengths);
+    // Each run of equal values is a unique value, which reoccurs when the run is longer than one
+    af::array reoccurring = (starts && lengths > 1).as(tss.type());
+    return af::sum(reoccurring, 0) / af::sum(starts.as(tss.type()), 0);
 }
 
 af::array gauss::features::percentageOfReoccurringValuesToAllValues(const af::array &tss, bool isSorted) {
-    af::array result = af::constant(0, 1, tss.dims(1), tss.type());
-    // Doing it sequentially because the setUnique function can only be used with a vector
-    for (int i = 0; i < tss.dims(1); i++) {
-        af::array uniques = af::setUnique(tss(af::span, i), isSorted);
-        auto n = uniques.dims(0);
-        af::array tmp = af::constant(0, 1, n, tss.type());
-        // Computing the number of occurrences for each unique value
-        for (auto j = 0; j < n; j++) {
-            tmp(0, j) = af::count(
-                tss(af::span, i) == af::tile(uniques(j), static_cast<unsigned int>(tss(af::span, i).dims(0)), 1), 0);
-        }
-        // WORKAROUND: Because of indirect memory access fails on Intel GPU
-        // result(0, i) = af::sum(tmp(0, aux), 1);
-        af::array aux = af::where(tmp - 1);
-        for (int h = 0; h < aux.dims(0); h++) {
-            result(0, i) = result(0, i) + tmp(0, aux(h).scalar<unsigned int>());
-        }
-    }
-    return result / tss.dims(0);
+    af::array sorted, starts, lengths;
+    runLengths(tss, isSorted, sorted, starts, lengths);
+    // Number of elements whose value appears more than once
+    return af::sum((lengths > 1).as(tss.type()), 0) / tss.dims(0);
 }
 
 // af::array gauss::features::quantile(const af::array &tss, const af::array &q, float precision) {
@@ -994,142 +767,49 @@ af::array gauss::features::rangeCount(const af::array &tss, float min, float max
 
 af::array gauss::features::ratioBeyondRSigma(const af::array &tss, float r) {
     auto n = static_cast<float>(tss.dims(0));
+    auto moments = gauss::statistics::moments(tss);
+
+    auto rows = static_cast<unsigned int>(tss.dims(0));
 
-    af::array greaterThanRSigma = af::abs(tss - af::tile(af::mean(tss, 0), static_cast<unsigned int>(tss.dims(0)))) >
-                                  af::tile(r * af::stdev(tss, 0), static_cast<unsigned int>(tss.dims(0)));
+    af::array greaterThanRSigma = af::abs(tss - af::tile(moments.mean, rows)) >
+                                  af::tile(r * gauss::statistics::stdev(moments, 0), rows);
 
     return af::sum(greaterThanRSigma.as(tss.type()), 0) / n;
 }
 
 af::array gauss::features::ratioValueNumberToTimeSeriesLength(const af::array &tss) {
-    af::array result = af::constant(0, 1, tss.dims(1), tss.type());
-    for (auto i = 0; i < tss.dims(1); i++) {
-        auto n = static_cast<float>(af::setUnique(tss(af::span, i)).dims(0));
-        result(0, i) = n / tss.dims(0);
-    }
-    return result;
+    af::array sorted, starts, lengths;
+    runLengths(tss, false, sorted, starts, lengths);
+    return af::sum(starts.as(tss.type()), 0) / tss.dims(0);
 }
 
-af::array gauss::features::sampleEntropy(const af::array &tss) {
-    auto n = tss.dims(0);
-
-    af::array std = af::stdev(tss, 0);
-    std *= 0.2;
-
-    const dim_t chunkSize = 32768;
-    long lastIterationSize = chunkSize;
-
-    af::array query = af::array(1, chunkSize, tss.dims(1), tss.type());
-    af::array reference = af::array(1, chunkSize, tss.dims(1), tss.type());
-
-    af::array A = af::constant(0, tss.dims(1), tss.type());
-    af::array B = af::constant(0, tss.dims(1), tss.type());
-
-    // it performs a batching (or blocking) in the horizontal direction
-    for (dim_t i = 0; i < n - 1; i++) {
-        // it performs a batching (or blocking) in the vertical direction
-        for (dim_t j = i + 1; j < n; j += chunkSize) {
-            auto iterationSize = std::min(chunkSize, n - j);
-            // if our batching dimension does not match the dimension of the remaining elements, modify dimensions
-            if (iterationSize != chunkSize || iterationSize != lastIterationSize) {
-                lastIterationSize = iterationSize;
-                query = af::array(1, iterationSize, tss.dims(1), tss.type());
-                reference = af::array(1, iterationSize, tss.dims(1), tss.type());
-            }
-
-            query = af::tile(af::reorder(tss(af::seq(i, i), af::span), 0, 2, 1, 3), 1,
-                             static_cast<unsigned int>(iterationSize));
-            reference = af::reorder(tss(af::seq(j, j + iterationSize - 1), af::span), 2, 0, 1, 3);
-
-            // Get the maximum difference among all dimensions for each time series
-            af::array distances = af::abs(reference - query);
-            // sum the number of elements bigger than the threshhold given by (stdev*r)
-            af::array count =
-                distances <= af::tile(af::reorder(std, 0, 2, 1, 3), static_cast<unsigned int>(distances.dims(0)),
-                                      static_cast<unsigned int>(distances.dims(1)));
-            // we summarise all partial sums in sum; we accumulate all partial sums for each vertical dimension
-            A += af::reorder(af::sum(af::sum(count, 0), 1), 2, 0, 1, 3);
-        }
-    }
-
-    float N = n * (n - 1) / 2.0f;
-
-    B = af::tile(af::array(1, &N), static_cast<unsigned int>(tss.dims(1))).as(tss.type());
-
-    return -af::log(A / B);
-}
+af::array gauss::features::sampleEntropy(const af::array &tss) { return sampleEntropyOf(tss, 0.2f); }
 
 af::array gauss::features::skewness(const af::array &tss) { return gauss::statistics::skewness(tss); }
 
 af::array gauss::features::spktWelchDensity(const af::array &tss, int coeff) {
-    float fs = 1.0;
-    int nfft = static_cast<int>(tss.dims(0));
-
-    af::array window = hannWindow(static_cast<int>(tss.dims(0)), false);
-    float scale = 1.0f / (fs * af::sum(window * window, 0).scalar<float>());
-
-    af::array out = af::constant(0, (tss.dims(0) / 2) + 1, tss.dims(1));
-    for (int i = 0; i < tss.dims(1); i++) {
-        af::array result = fftHelper(tss, window);
-        result = af::conjg(result) * result;
-        result *= scale;
-        result *= 2;
-        result(0) = result(0) / 2;
-
-        if ((nfft % 2) != 0) {
-            // Last point is unpaired Nyquist freq point, don't double
-            result(static_cast<const int>(result.dims(0)) - 1) = result(static_cast<const int>(result.dims(0)) - 1) / 2;
-        }
-        out(af::span, i) = af::real(result);
-    }
-    return out(coeff, af::span);
+    // segments of up to 256 points with half overlap, as tsfresh does
+    auto segmentLength = std::min<dim_t>(tss.dims(0), 256);
+    if (coeff < 0 || coeff > segmentLength / 2)
+        throw std::invalid_argument("The coefficient must be between zero and half the segment length");
+
+    return gauss::fft::welch(tss, segmentLength)(coeff, af::span);
 }
 
-af::array gauss::features::standardDeviation(const af::array &tss) { return af::stdev(tss, 0); }
+af::array gauss::features::standardDeviation(const af::array &tss) { return gauss::statistics::stdev(tss, 0); }
 
 af::array gauss::features::sumOfReoccurringDatapoints(const af::array &tss, bool isSorted) {
-    af::array result = af::array(1, tss.dims(1), tss.type());
-    // Doing it sequentially because the setUnique function can only be used with a vector
-    for (auto i = 0; i < tss.dims(1); i++) {
-        af::array unique = af::setUnique(tss(af::span, i), isSorted);
-        auto n = unique.dims(0);
-        // The chunk size cannot be greater than the length of the unique values
-        auto chunkSize = std::min(n, BATCH_SIZE);
-
-        af::array counts = af::array(0, tss.type());
-
-        for (auto j = 0; j < n; j += chunkSize) {
-            // The iteration space cannot be greater than what is left (n - j)
-            auto iterationSize = std::min(chunkSize, n - j);
-            af::array uniqueChunk = unique(af::seq(j, j + iterationSize - 1));
-
-            af::array tssTiled = af::tile(tss(af::span, i), 1, static_cast<unsigned int>(uniqueChunk.dims(0)));
-            uniqueChunk = af::transpose(af::tile(uniqueChunk, 1, static_cast<unsigned int>(tss.dims(0))));
-
-            counts = af::join(0, counts, af::transpose(af::sum(uniqueChunk == tssTiled, 0).as(tss.type())));
-        }
-        counts(counts < 2) = 0.0;
-        result(i) = af::sum(counts * unique, 0);
-    }
-
-    return result;
+    af::array sorted, starts, lengths;
+    runLengths(tss, isSorted, sorted, starts, lengths);
+    // Every occurrence of a reoccurring value contributes to the sum
+    return af::sum(sorted * (lengths > 1).as(tss.type()), 0);
 }
 
 af::array gauss::features::sumOfReoccurringValues(const af::array &tss, bool isSorted) {
-    af::array result = af::constant(0, 1, tss.dims(1), tss.type());
-    // Doing it sequentially because the setUnique function can only be used with a vector
-    for (int i = 0; i < tss.dims(1); i++) {
-        af::array uniques = af::setUnique(tss(af::span, i), isSorted);
-        int n = static_cast<int>(uniques.dims(0));
-        af::array tmp = af::constant(0, 1, n, tss.type());
-        // Computing the number of occurrences for each unique value
-        for (int j = 0; j < n; j++) {
-            tmp(0, j) = af::count(
-                tss(af::span, i) == af::tile(uniques(j), static_cast<unsigned int>(tss(af::span, i).dims(0)), 1), 0);
-        }
-        result(0, i) = af::sum(uniques(tmp > 1), 0);
-    }
-    return result;
+    af::array sorted, starts, lengths;
+    runLengths(tss, isSorted, sorted, starts, lengths);
+    // Only the first occurrence of a reoccurring value contributes to the sum
+    return af::sum(sorted * (starts && lengths > 1).as(tss.type()), 0);
 }
 
 af::array gauss::features::sumValues(const af::array &tss) { return af::sum(tss, 0); }
@@ -1159,8 +839,9 @@ af::array gauss::features::valueCount(const af::array &tss, float v) {
     return af::sum((value == tss).as(af::dtype::u32), 0);
 }
 
-af::array gauss::features::variance(const af::array &tss) { return af::var(tss, true, 0); }
+af::array gauss::features::variance(const af::array &tss) { return gauss::statistics::var(tss, 0); }
 
 af::array gauss::features::varianceLargerThanStandardDeviation(const af::array &tss) {
-    return af::var(tss, false, 0) > af::stdev(tss, 0);
+    auto moments = gauss::statistics::moments(tss);
+    return gauss::statistics::var(moments, 1) > gauss::statistics::stdev(moments, 0);
 }
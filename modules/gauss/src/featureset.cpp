@@ -0,0 +1,674 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/features.h>
+#include <gauss/featureset.h>
+#include <gauss/normalization.h>
+#include <gauss/regression.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using gauss::features::Feature;
+using gauss::features::feature_spec_t;
+
+/**
+ * Intermediate results shared between features; all of them are computed along dimension zero of a block.
+ */
+enum Intermediate {
+    SUM,           // (1, cols)
+    MEAN,          // (1, cols), from SUM
+    CENTERED,      // (n, cols), from MEAN
+    VARIANCE,      // (1, cols), population variance, from CENTERED
+    STDEV,         // (1, cols), from VARIANCE
+    ENERGY,        // (1, cols)
+    MINIMUM,       // (1, cols)
+    MAXIMUM,       // (1, cols)
+    SORTED,        // (n, cols)
+    MEDIAN,        // (1, cols), from SORTED
+    DISTINCT,      // (1, cols), number of distinct values, from SORTED
+    DIFF,          // (n-1, cols)
+    ABS_DIFF,      // (1, cols), sum of the absolute differences, from DIFF
+    ABOVE_MEAN,    // (n, cols) mask, from CENTERED
+    BELOW_MEAN,    // (n, cols) mask, from CENTERED
+    SPECTRUM,      // (n, cols) complex
+    AGGREGATED,    // (4, cols), centroid, variance, skew and kurtosis of the spectrum
+    TREND,         // (5, cols), pvalue, rvalue, intercept, slope and stderr
+    ZNORMALIZED,   // (n, cols)
+    INTERMEDIATES
+};
+
+/**
+ * Direct dependencies of an intermediate.
+ */
+std::vector<Intermediate> dependencies(Intermediate node) {
+    switch (node) {
+        case MEAN:
+            return {SUM};
+        case CENTERED:
+            return {MEAN};
+        case VARIANCE:
+            return {CENTERED};
+        case STDEV:
+            return {VARIANCE};
+        case MEDIAN:
+        case DISTINCT:
+            return {SORTED};
+        case ABS_DIFF:
+            return {DIFF};
+        case ABOVE_MEAN:
+        case BELOW_MEAN:
+            return {CENTERED};
+        default:
+            return {};
+    }
+}
+
+/**
+ * Number of parameters and intermediates consumed by a feature.
+ */
+void describe(Feature feature, size_t &params, std::vector<Intermediate> &uses) {
+    params = 0;
+    uses.clear();
+    switch (feature) {
+        case Feature::ABS_ENERGY:
+            uses = {ENERGY};
+            break;
+        case Feature::ABSOLUTE_SUM_OF_CHANGES:
+        case Feature::MEAN_ABSOLUTE_CHANGE:
+            uses = {ABS_DIFF};
+            break;
+        case Feature::APPROXIMATE_ENTROPY:
+        case Feature::ENERGY_RATIO_BY_CHUNKS:
+        case Feature::RANGE_COUNT:
+            params = 2;
+            break;
+        case Feature::BINNED_ENTROPY:
+        case Feature::C3:
+        case Feature::INDEX_MASS_QUANTILE:
+        case Feature::NUMBER_CROSSING_M:
+        case Feature::NUMBER_CWT_PEAKS:
+        case Feature::NUMBER_PEAKS:
+        case Feature::SPKT_WELCH_DENSITY:
+        case Feature::TIME_REVERSAL_ASYMMETRY_STATISTIC:
+        case Feature::VALUE_COUNT:
+            params = 1;
+            break;
+        case Feature::CID_CE:
+            params = 1;
+            uses = {ZNORMALIZED};
+            break;
+        case Feature::COUNT_ABOVE_MEAN:
+        case Feature::LONGEST_STRIKE_ABOVE_MEAN:
+            uses = {ABOVE_MEAN};
+            break;
+        case Feature::COUNT_BELOW_MEAN:
+        case Feature::LONGEST_STRIKE_BELOW_MEAN:
+            uses = {BELOW_MEAN};
+            break;
+        case Feature::FFT_AGGREGATED_CENTROID:
+        case Feature::FFT_AGGREGATED_VARIANCE:
+        case Feature::FFT_AGGREGATED_SKEW:
+        case Feature::FFT_AGGREGATED_KURTOSIS:
+            uses = {AGGREGATED};
+            break;
+        case Feature::FFT_COEFFICIENT_REAL:
+        case Feature::FFT_COEFFICIENT_IMAG:
+        case Feature::FFT_COEFFICIENT_ABS:
+        case Feature::FFT_COEFFICIENT_ANGLE:
+            params = 1;
+            uses = {SPECTRUM};
+            break;
+        case Feature::HAS_DUPLICATES:
+        case Feature::RATIO_VALUE_NUMBER_TO_TIME_SERIES_LENGTH:
+            uses = {DISTINCT};
+            break;
+        case Feature::HAS_DUPLICATE_MAX:
+        case Feature::MAXIMUM:
+            uses = {MAXIMUM};
+            break;
+        case Feature::HAS_DUPLICATE_MIN:
+        case Feature::MINIMUM:
+            uses = {MINIMUM};
+            break;
+        case Feature::KURTOSIS:
+        case Feature::SKEWNESS:
+            uses = {CENTERED, STDEV};
+            break;
+        case Feature::LARGE_STANDARD_DEVIATION:
+            params = 1;
+            uses = {STDEV, MAXIMUM, MINIMUM};
+            break;
+        case Feature::LINEAR_TREND_PVALUE:
+        case Feature::LINEAR_TREND_RVALUE:
+        case Feature::LINEAR_TREND_INTERCEPT:
+        case Feature::LINEAR_TREND_SLOPE:
+        case Feature::LINEAR_TREND_STDERR:
+            uses = {TREND};
+            break;
+        case Feature::MEAN:
+            uses = {MEAN};
+            break;
+        case Feature::MEAN_CHANGE:
+            uses = {DIFF};
+            break;
+        case Feature::MEDIAN:
+            uses = {MEDIAN};
+            break;
+        case Feature::PERCENTAGE_OF_REOCCURRING_DATAPOINTS_TO_ALL_DATAPOINTS:
+        case Feature::PERCENTAGE_OF_REOCCURRING_VALUES_TO_ALL_VALUES:
+        case Feature::SUM_OF_REOCCURRING_DATAPOINTS:
+        case Feature::SUM_OF_REOCCURRING_VALUES:
+            uses = {SORTED};
+            break;
+        case Feature::RATIO_BEYOND_R_SIGMA:
+            params = 1;
+            uses = {CENTERED, STDEV};
+            break;
+        case Feature::STANDARD_DEVIATION:
+            uses = {STDEV};
+            break;
+        case Feature::SUM_VALUES:
+            uses = {SUM};
+            break;
+        case Feature::SYMMETRY_LOOKING:
+            params = 1;
+            uses = {MEAN, MEDIAN, MAXIMUM, MINIMUM};
+            break;
+        case Feature::VARIANCE:
+            uses = {VARIANCE};
+            break;
+        case Feature::VARIANCE_LARGER_THAN_STANDARD_DEVIATION:
+            uses = {VARIANCE, STDEV};
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Adds node and all its transitive dependencies to the closure.
+ */
+void addWithDependencies(Intermediate node, std::vector<bool> &closure) {
+    if (closure[node]) return;
+    closure[node] = true;
+    for (auto dependency : dependencies(node)) addWithDependencies(dependency, closure);
+}
+
+/**
+ * Lazily evaluated intermediates of a single block of columns.
+ */
+class block_context {
+public:
+    explicit block_context(const af::array &block) : _block(block), _cache(INTERMEDIATES), _ready(INTERMEDIATES) {}
+
+    const af::array &block() const { return _block; }
+
+    const af::array &get(Intermediate node) {
+        if (!_ready[node]) {
+            _cache[node] = evaluate(node);
+            _ready[node] = true;
+        }
+        return _cache[node];
+    }
+
+    void release(Intermediate node) {
+        _cache[node] = af::array();
+        _ready[node] = false;
+    }
+
+private:
+    af::array evaluate(Intermediate node) {
+        auto n = static_cast<unsigned int>(_block.dims(0));
+        auto len = static_cast<double>(_block.dims(0));
+        switch (node) {
+            case SUM:
+                return af::sum(_block, 0);
+            case MEAN:
+                return get(SUM) / len;
+            case CENTERED:
+                return _block - af::tile(get(MEAN), n);
+            case VARIANCE:
+                return af::sum(get(CENTERED) * get(CENTERED), 0) / len;
+            case STDEV:
+                return af::sqrt(get(VARIANCE));
+            case ENERGY:
+                return af::sum(_block * _block, 0);
+            case MINIMUM:
+                return af::min(_block, 0);
+            case MAXIMUM:
+                return af::max(_block, 0);
+            case SORTED:
+                return af::sort(_block, 0);
+            case MEDIAN: {
+                // same convention as af::median: the mean of the two central values for even lengths
+                const auto &sorted = get(SORTED);
+                auto half = _block.dims(0) / 2;
+                if (_block.dims(0) % 2 != 0) return sorted(half, af::span);
+                return (sorted(half - 1, af::span) + sorted(half, af::span)) / 2.0;
+            }
+            case DISTINCT: {
+                if (_block.dims(0) < 2) return af::constant(len, 1, _block.dims(1), _block.type());
+                return 1 + af::sum((af::diff1(get(SORTED), 0) != 0).as(_block.type()), 0);
+            }
+            case DIFF:
+                return af::diff1(_block, 0);
+            case ABS_DIFF:
+                return af::sum(af::abs(get(DIFF)), 0);
+            case ABOVE_MEAN:
+                return get(CENTERED) > 0;
+            case BELOW_MEAN:
+                return get(CENTERED) < 0;
+            case SPECTRUM:
+                return af::fft(_block);
+            case AGGREGATED:
+                return gauss::features::fftAggregated(_block);
+            case TREND: {
+                af::array pvalue, rvalue, intercept, slope, stder;
+                gauss::features::linearTrend(_block, pvalue, rvalue, intercept, slope, stder);
+                return af::join(0, af::join(0, pvalue, rvalue, intercept, slope), stder);
+            }
+            case ZNORMALIZED:
+                return gauss::normalization::znorm(_block);
+            default:
+                throw std::invalid_argument("Unknown intermediate");
+        }
+    }
+
+    af::array _block;
+    std::vector<af::array> _cache;
+    std::vector<bool> _ready;
+};
+
+/**
+ * Square root of the sum of the squared consecutive differences, as in features::cidCe.
+ */
+af::array complexityEstimate(const af::array &tss) { return af::sqrt(af::sum(af::pow(af::diff1(tss, 0), 2), 0)); }
+
+/**
+ * Evaluates a single feature over the block held by the context, as a (1, cols) row.
+ */
+af::array evaluate(const feature_spec_t &spec, block_context &context) {
+    namespace features = gauss::features;
+
+    const auto &tss = context.block();
+    const auto &p = spec.params;
+    auto n = tss.dims(0);
+    auto len = static_cast<double>(n);
+    auto tiled = [&](const af::array &row) { return af::tile(row, static_cast<unsigned int>(n)); };
+
+    switch (spec.feature) {
+        case Feature::ABS_ENERGY:
+            return context.get(ENERGY);
+        case Feature::ABSOLUTE_SUM_OF_CHANGES:
+            return context.get(ABS_DIFF);
+        case Feature::APPROXIMATE_ENTROPY:
+            return features::approximateEntropy(tss, static_cast<int>(p[0]), static_cast<float>(p[1]));
+        case Feature::BINNED_ENTROPY:
+            return features::binnedEntropy(tss, static_cast<int>(p[0]));
+        case Feature::C3:
+            return features::c3(tss, static_cast<long>(p[0]));
+        case Feature::CID_CE:
+            return complexityEstimate(p[0] != 0.0 ? context.get(ZNORMALIZED) : tss);
+        case Feature::COUNT_ABOVE_MEAN:
+            return af::sum(context.get(ABOVE_MEAN).as(af::dtype::u32), 0);
+        case Feature::COUNT_BELOW_MEAN:
+            return af::sum(context.get(BELOW_MEAN).as(af::dtype::u32), 0);
+        case Feature::ENERGY_RATIO_BY_CHUNKS:
+            return features::energyRatioByChunks(tss, static_cast<long>(p[0]), static_cast<long>(p[1]));
+        case Feature::FFT_AGGREGATED_CENTROID:
+            return context.get(AGGREGATED)(0, af::span);
+        case Feature::FFT_AGGREGATED_VARIANCE:
+            return context.get(AGGREGATED)(1, af::span);
+        case Feature::FFT_AGGREGATED_SKEW:
+            return context.get(AGGREGATED)(2, af::span);
+        case Feature::FFT_AGGREGATED_KURTOSIS:
+            return context.get(AGGREGATED)(3, af::span);
+        case Feature::FFT_COEFFICIENT_REAL:
+        case Feature::FFT_COEFFICIENT_IMAG:
+        case Feature::FFT_COEFFICIENT_ABS:
+        case Feature::FFT_COEFFICIENT_ANGLE: {
+            auto coefficient = static_cast<dim_t>(p[0]);
+            if (coefficient < 0 || coefficient >= n)
+                throw std::invalid_argument("The fft coefficient must be lower than the length of the time series");
+            af::array value = context.get(SPECTRUM)(static_cast<int>(coefficient), af::span);
+            // same outputs as features::fftCoefficient
+            if (spec.feature == Feature::FFT_COEFFICIENT_REAL) return af::real(value);
+            if (spec.feature == Feature::FFT_COEFFICIENT_IMAG) return af::imag(value);
+            if (spec.feature == Feature::FFT_COEFFICIENT_ABS) return af::abs(af::real(value));
+            return af::arg(value);
+        }
+        case Feature::FIRST_LOCATION_OF_MAXIMUM:
+            return features::firstLocationOfMaximum(tss);
+        case Feature::FIRST_LOCATION_OF_MINIMUM:
+            return features::firstLocationOfMinimum(tss);
+        case Feature::HAS_DUPLICATES:
+            return context.get(DISTINCT) < len;
+        case Feature::HAS_DUPLICATE_MAX:
+            return af::sum(tss == tiled(context.get(MAXIMUM)), 0) > 1;
+        case Feature::HAS_DUPLICATE_MIN:
+            return af::sum(tss == tiled(context.get(MINIMUM)), 0) > 1;
+        case Feature::INDEX_MASS_QUANTILE:
+            return features::indexMassQuantile(tss, static_cast<float>(p[0]));
+        case Feature::KURTOSIS: {
+            // same definition as statistics::kurtosis
+            auto a = (len * (len + 1)) / ((len - 1) * (len - 2) * (len - 3));
+            auto c = (3 * (len - 1) * (len - 1)) / ((len - 2) * (len - 3));
+            auto b = af::sum(af::pow(context.get(CENTERED) / tiled(context.get(STDEV)), 4), 0);
+            return a * b - c;
+        }
+        case Feature::LARGE_STANDARD_DEVIATION:
+            return context.get(STDEV) > (p[0] * (context.get(MAXIMUM) - context.get(MINIMUM)));
+        case Feature::LAST_LOCATION_OF_MAXIMUM:
+            return features::lastLocationOfMaximum(tss);
+        case Feature::LAST_LOCATION_OF_MINIMUM:
+            return features::lastLocationOfMinimum(tss);
+        case Feature::LENGTH:
+            return af::constant(len, 1, tss.dims(1), tss.type());
+        case Feature::LINEAR_TREND_PVALUE:
+            return context.get(TREND)(0, af::span);
+        case Feature::LINEAR_TREND_RVALUE:
+            return context.get(TREND)(1, af::span);
+        case Feature::LINEAR_TREND_INTERCEPT:
+            return context.get(TREND)(2, af::span);
+        case Feature::LINEAR_TREND_SLOPE:
+            return context.get(TREND)(3, af::span);
+        case Feature::LINEAR_TREND_STDERR:
+            return context.get(TREND)(4, af::span);
+        case Feature::LONGEST_STRIKE_ABOVE_MEAN: {
+            auto mask = context.get(ABOVE_MEAN).as(tss.type());
+            return af::max(af::scanByKey(mask.as(af::dtype::s32), mask), 0);
+        }
+        case Feature::LONGEST_STRIKE_BELOW_MEAN: {
+            auto mask = context.get(BELOW_MEAN).as(tss.type());
+            return af::max(af::scanByKey(mask.as(af::dtype::s32), mask), 0);
+        }
+        case Feature::MAXIMUM:
+            return context.get(MAXIMUM);
+        case Feature::MEAN:
+            return context.get(MEAN);
+        case Feature::MEAN_ABSOLUTE_CHANGE:
+            return context.get(ABS_DIFF) / len;
+        case Feature::MEAN_CHANGE:
+            return af::sum(context.get(DIFF), 0) / len;
+        case Feature::MEAN_SECOND_DERIVATIVE_CENTRAL:
+            return features::meanSecondDerivativeCentral(tss);
+        case Feature::MEDIAN:
+            return context.get(MEDIAN);
+        case Feature::MINIMUM:
+            return context.get(MINIMUM);
+        case Feature::NUMBER_CROSSING_M:
+            return features::numberCrossingM(tss, static_cast<int>(p[0]));
+        case Feature::NUMBER_CWT_PEAKS:
+            return features::numberCwtPeaks(tss, static_cast<int>(p[0]));
+        case Feature::NUMBER_PEAKS:
+            return features::numberPeaks(tss, static_cast<int>(p[0]));
+        case Feature::PERCENTAGE_OF_REOCCURRING_DATAPOINTS_TO_ALL_DATAPOINTS:
+            return features::percentageOfReoccurringDatapointsToAllDatapoints(context.get(SORTED), true);
+        case Feature::PERCENTAGE_OF_REOCCURRING_VALUES_TO_ALL_VALUES:
+            return features::percentageOfReoccurringValuesToAllValues(context.get(SORTED), true);
+        case Feature::RANGE_COUNT:
+            return features::rangeCount(tss, static_cast<float>(p[0]), static_cast<float>(p[1]));
+        case Feature::RATIO_BEYOND_R_SIGMA:
+            return af::sum((af::abs(context.get(CENTERED)) > tiled(p[0] * context.get(STDEV))).as(tss.type()), 0) / len;
+        case Feature::RATIO_VALUE_NUMBER_TO_TIME_SERIES_LENGTH:
+            return context.get(DISTINCT) / len;
+        case Feature::SAMPLE_ENTROPY:
+            return features::sampleEntropy(tss);
+        case Feature::SKEWNESS: {
+            // same definition as statistics::skewness
+            auto m3 = af::sum(af::pow(context.get(CENTERED), 3), 0) / len;
+            return (len * len / ((len - 1) * (len - 2))) * m3 / af::pow(context.get(STDEV), 3);
+        }
+        case Feature::SPKT_WELCH_DENSITY:
+            return features::spktWelchDensity(tss, static_cast<int>(p[0]));
+        case Feature::STANDARD_DEVIATION:
+            return context.get(STDEV);
+        case Feature::SUM_OF_REOCCURRING_DATAPOINTS:
+            return features::sumOfReoccurringDatapoints(context.get(SORTED), true);
+        case Feature::SUM_OF_REOCCURRING_VALUES:
+            return features::sumOfReoccurringValues(context.get(SORTED), true);
+        case Feature::SUM_VALUES:
+            return context.get(SUM);
+        case Feature::SYMMETRY_LOOKING:
+            return af::abs(context.get(MEAN) - context.get(MEDIAN)) <
+                   (p[0] * (context.get(MAXIMUM) - context.get(MINIMUM)));
+        case Feature::TIME_REVERSAL_ASYMMETRY_STATISTIC:
+            return features::timeReversalAsymmetryStatistic(tss, static_cast<int>(p[0]));
+        case Feature::VALUE_COUNT:
+            return features::valueCount(tss, static_cast<float>(p[0]));
+        case Feature::VARIANCE:
+            return context.get(VARIANCE);
+        case Feature::VARIANCE_LARGER_THAN_STANDARD_DEVIATION:
+            // the sample variance against the population deviation, as features::varianceLargerThanStandardDeviation
+            return context.get(VARIANCE) * (len / (len - 1.0)) > context.get(STDEV);
+    }
+    throw std::invalid_argument("Unknown feature");
+}
+
+/**
+ * Evaluates a single feature straight from its function in gauss/features.h, as a (1, cols) row.
+ */
+af::array reference(const af::array &tss, const feature_spec_t &spec) {
+    namespace features = gauss::features;
+
+    const auto &p = spec.params;
+    switch (spec.feature) {
+        case Feature::ABS_ENERGY:
+            return features::absEnergy(tss);
+        case Feature::ABSOLUTE_SUM_OF_CHANGES:
+            return features::absoluteSumOfChanges(tss);
+        case Feature::APPROXIMATE_ENTROPY:
+            return features::approximateEntropy(tss, static_cast<int>(p[0]), static_cast<float>(p[1]));
+        case Feature::BINNED_ENTROPY:
+            return features::binnedEntropy(tss, static_cast<int>(p[0]));
+        case Feature::C3:
+            return features::c3(tss, static_cast<long>(p[0]));
+        case Feature::CID_CE:
+            return features::cidCe(tss, p[0] != 0.0);
+        case Feature::COUNT_ABOVE_MEAN:
+            return features::countAboveMean(tss);
+        case Feature::COUNT_BELOW_MEAN:
+            return features::countBelowMean(tss);
+        case Feature::ENERGY_RATIO_BY_CHUNKS:
+            return features::energyRatioByChunks(tss, static_cast<long>(p[0]), static_cast<long>(p[1]));
+        case Feature::FFT_AGGREGATED_CENTROID:
+            return features::fftAggregated(tss)(0, af::span);
+        case Feature::FFT_AGGREGATED_VARIANCE:
+            return features::fftAggregated(tss)(1, af::span);
+        case Feature::FFT_AGGREGATED_SKEW:
+            return features::fftAggregated(tss)(2, af::span);
+        case Feature::FFT_AGGREGATED_KURTOSIS:
+            return features::fftAggregated(tss)(3, af::span);
+        case Feature::FFT_COEFFICIENT_REAL:
+        case Feature::FFT_COEFFICIENT_IMAG:
+        case Feature::FFT_COEFFICIENT_ABS:
+        case Feature::FFT_COEFFICIENT_ANGLE: {
+            af::array real, imag, abs, angle;
+            features::fftCoefficient(tss, static_cast<long>(p[0]), real, imag, abs, angle);
+            if (spec.feature == Feature::FFT_COEFFICIENT_REAL) return real;
+            if (spec.feature == Feature::FFT_COEFFICIENT_IMAG) return imag;
+            if (spec.feature == Feature::FFT_COEFFICIENT_ABS) return abs;
+            return angle;
+        }
+        case Feature::FIRST_LOCATION_OF_MAXIMUM:
+            return features::firstLocationOfMaximum(tss);
+        case Feature::FIRST_LOCATION_OF_MINIMUM:
+            return features::firstLocationOfMinimum(tss);
+        case Feature::HAS_DUPLICATES:
+            return features::hasDuplicates(tss);
+        case Feature::HAS_DUPLICATE_MAX:
+            return features::hasDuplicateMax(tss);
+        case Feature::HAS_DUPLICATE_MIN:
+            return features::hasDuplicateMin(tss);
+        case Feature::INDEX_MASS_QUANTILE:
+            return features::indexMassQuantile(tss, static_cast<float>(p[0]));
+        case Feature::KURTOSIS:
+            return features::kurtosis(tss);
+        case Feature::LARGE_STANDARD_DEVIATION:
+            return features::largeStandardDeviation(tss, static_cast<float>(p[0]));
+        case Feature::LAST_LOCATION_OF_MAXIMUM:
+            return features::lastLocationOfMaximum(tss);
+        case Feature::LAST_LOCATION_OF_MINIMUM:
+            return features::lastLocationOfMinimum(tss);
+        case Feature::LENGTH:
+            return features::length(tss);
+        case Feature::LINEAR_TREND_PVALUE:
+        case Feature::LINEAR_TREND_RVALUE:
+        case Feature::LINEAR_TREND_INTERCEPT:
+        case Feature::LINEAR_TREND_SLOPE:
+        case Feature::LINEAR_TREND_STDERR: {
+            af::array pvalue, rvalue, intercept, slope, stder;
+            features::linearTrend(tss, pvalue, rvalue, intercept, slope, stder);
+            if (spec.feature == Feature::LINEAR_TREND_PVALUE) return pvalue;
+            if (spec.feature == Feature::LINEAR_TREND_RVALUE) return rvalue;
+            if (spec.feature == Feature::LINEAR_TREND_INTERCEPT) return intercept;
+            if (spec.feature == Feature::LINEAR_TREND_SLOPE) return slope;
+            return stder;
+        }
+        case Feature::LONGEST_STRIKE_ABOVE_MEAN:
+            return features::longestStrikeAboveMean(tss);
+        case Feature::LONGEST_STRIKE_BELOW_MEAN:
+            return features::longestStrikeBelowMean(tss);
+        case Feature::MAXIMUM:
+            return features::maximum(tss);
+        case Feature::MEAN:
+            return features::mean(tss);
+        case Feature::MEAN_ABSOLUTE_CHANGE:
+            return features::meanAbsoluteChange(tss);
+        case Feature::MEAN_CHANGE:
+            return features::meanChange(tss);
+        case Feature::MEAN_SECOND_DERIVATIVE_CENTRAL:
+            return features::meanSecondDerivativeCentral(tss);
+        case Feature::MEDIAN:
+            return features::median(tss);
+        case Feature::MINIMUM:
+            return features::minimum(tss);
+        case Feature::NUMBER_CROSSING_M:
+            return features::numberCrossingM(tss, static_cast<int>(p[0]));
+        case Feature::NUMBER_CWT_PEAKS:
+            return features::numberCwtPeaks(tss, static_cast<int>(p[0]));
+        case Feature::NUMBER_PEAKS:
+            return features::numberPeaks(tss, static_cast<int>(p[0]));
+        case Feature::PERCENTAGE_OF_REOCCURRING_DATAPOINTS_TO_ALL_DATAPOINTS:
+            return features::percentageOfReoccurringDatapointsToAllDatapoints(tss);
+        case Feature::PERCENTAGE_OF_REOCCURRING_VALUES_TO_ALL_VALUES:
+            return features::percentageOfReoccurringValuesToAllValues(tss);
+        case Feature::RANGE_COUNT:
+            return features::rangeCount(tss, static_cast<float>(p[0]), static_cast<float>(p[1]));
+        case Feature::RATIO_BEYOND_R_SIGMA:
+            return features::ratioBeyondRSigma(tss, static_cast<float>(p[0]));
+        case Feature::RATIO_VALUE_NUMBER_TO_TIME_SERIES_LENGTH:
+            return features::ratioValueNumberToTimeSeriesLength(tss);
+        case Feature::SAMPLE_ENTROPY:
+            return features::sampleEntropy(tss);
+        case Feature::SKEWNESS:
+            return features::skewness(tss);
+        case Feature::SPKT_WELCH_DENSITY:
+            return features::spktWelchDensity(tss, static_cast<int>(p[0]));
+        case Feature::STANDARD_DEVIATION:
+            return features::standardDeviation(tss);
+        case Feature::SUM_OF_REOCCURRING_DATAPOINTS:
+            return features::sumOfReoccurringDatapoints(tss);
+        case Feature::SUM_OF_REOCCURRING_VALUES:
+            return features::sumOfReoccurringValues(tss);
+        case Feature::SUM_VALUES:
+            return features::sumValues(tss);
+        case Feature::SYMMETRY_LOOKING:
+            return features::symmetryLooking(tss, static_cast<float>(p[0]));
+        case Feature::TIME_REVERSAL_ASYMMETRY_STATISTIC:
+            return features::timeReversalAsymmetryStatistic(tss, static_cast<int>(p[0]));
+        case Feature::VALUE_COUNT:
+            return features::valueCount(tss, static_cast<float>(p[0]));
+        case Feature::VARIANCE:
+            return features::variance(tss);
+        case Feature::VARIANCE_LARGER_THAN_STANDARD_DEVIATION:
+            return features::varianceLargerThanStandardDeviation(tss);
+    }
+    throw std::invalid_argument("Unknown feature");
+}
+
+/**
+ * Checks the number of parameters given to a feature.
+ */
+void checkParams(const feature_spec_t &spec) {
+    size_t params;
+    std::vector<Intermediate> uses;
+    describe(spec.feature, params, uses);
+    if (spec.params.size() != params)
+        throw std::invalid_argument("Wrong number of parameters for feature " +
+                                    std::to_string(static_cast<int>(spec.feature)));
+}
+
+}  // namespace
+
+namespace gauss::features {
+
+af::array computeFeature(const af::array &tss, const feature_spec_t &spec) {
+    checkParams(spec);
+    return af::moddims(reference(tss, spec), 1, tss.dims(1)).as(tss.type());
+}
+
+FeatureSet::FeatureSet(std::vector<feature_spec_t> specs) : _specs(std::move(specs)), _releases(_specs.size()) {
+    if (_specs.empty())
+        throw std::invalid_argument("A feature set requires at least one feature");
+
+    // the feature after which each intermediate is no longer needed
+    std::vector<int> lastUse(INTERMEDIATES, -1);
+
+    size_t params;
+    std::vector<Intermediate> uses;
+    for (size_t f = 0; f < _specs.size(); f++) {
+        checkParams(_specs[f]);
+        describe(_specs[f].feature, params, uses);
+
+        std::vector<bool> closure(INTERMEDIATES, false);
+        for (auto node : uses) addWithDependencies(node, closure);
+        for (int node = 0; node < INTERMEDIATES; node++)
+            if (closure[node]) lastUse[node] = static_cast<int>(f);
+    }
+
+    for (int node = 0; node < INTERMEDIATES; node++)
+        if (lastUse[node] >= 0) _releases[lastUse[node]].push_back(node);
+}
+
+af::array FeatureSet::computeBlock(const af::array &block) const {
+    block_context context(block);
+    af::array result = af::constant(0, static_cast<dim_t>(_specs.size()), block.dims(1), block.type());
+
+    for (size_t f = 0; f < _specs.size(); f++) {
+        auto row = evaluate(_specs[f], context);
+        result(static_cast<int>(f), af::span) = af::moddims(row, 1, block.dims(1)).as(block.type());
+        for (auto node : _releases[f]) context.release(static_cast<Intermediate>(node));
+    }
+
+    return result;
+}
+
+af::array FeatureSet::compute(const af::array &tss, dim_t blockSize) const {
+    if (blockSize < 1)
+        throw std::invalid_argument("The block size must be greater than zero");
+
+    auto columns = tss.dims(1);
+    if (columns <= blockSize) return computeBlock(tss);
+
+    af::array result = af::constant(0, static_cast<dim_t>(_specs.size()), columns, tss.type());
+    for (dim_t start = 0; start < columns; start += blockSize) {
+        auto end = std::min(columns, start + blockSize);
+        auto range = af::seq(static_cast<double>(start), static_cast<double>(end - 1));
+        result(af::span, range) = computeBlock(tss(af::span, range));
+    }
+
+    return result;
+}
+
+}  // namespace gauss::features
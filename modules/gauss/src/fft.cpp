@@ -6,12 +6,55 @@
  */
 
 #include <gauss/fft.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
 #include <variant>
 #include <optional>
 #include <iostream>
 
 namespace gauss::fft {
 
+// upper bound on the number of complex cells multiplied at once when computing wavelet transforms
+constexpr dim_t CWT_BLOCK_CELLS = 1 << 24;
+
+/**
+ * Samples one wavelet per width (columns) on a common frame of n points.  The wavelet of width w spans
+ * min(10w, n) points, centred on the same position for every width, so a single crop of the full convolution
+ * gives the same mode convolution for all the widths.  Wavelets are returned already conjugated and reversed,
+ * ready to be convolved.
+ */
+af::array sampledWavelets(const af::array& widths, dim_t n, Wavelet wavelet, double omega0, af::dtype type) {
+    auto nw = widths.elements();
+    auto frame = static_cast<unsigned int>(n);
+
+    af::array w = af::tile(af::moddims(widths, 1, nw).as(type), frame);
+    af::array length = af::min(af::floor(10.0 * w), static_cast<double>(n));
+
+    // position within the wavelet of each point of the frame, and its distance to the centre of the wavelet
+    af::array start = std::floor((n - 1) / 2.0) - af::floor((length - 1) / 2.0);
+    af::array index = af::range(af::dim4(n, nw), 0, type) - start;
+    af::array x = index - (length - 1) / 2.0;
+    af::array inside = (index >= 0 && index < length).as(type);
+
+    // both wavelets are even in their real part and odd in their imaginary part, so conjugating and reversing
+    // the samples gives back the same samples
+    switch (wavelet) {
+        case Wavelet::Ricker: {
+            af::array a = 2.0 / (af::sqrt(3.0 * w) * std::pow(af::Pi, 0.25));
+            af::array xsq = x * x;
+            af::array wsq = w * w;
+            return a * (1.0 - xsq / wsq) * af::exp(-xsq / (2.0 * wsq)) * inside;
+        }
+        case Wavelet::Morlet: {
+            af::array xs = x / w;
+            af::array envelope = af::exp(-0.5 * xs * xs) * std::pow(af::Pi, -0.25) / af::sqrt(w) * inside;
+            return af::complex(envelope * af::cos(omega0 * xs), envelope * af::sin(omega0 * xs));
+        }
+    }
+    throw std::invalid_argument("Unknown wavelet");
+}
+
 inline double towardsFrequencyDomain(Norm norm, int32_t n) {
     switch (norm)
     {
@@ -266,4 +309,115 @@ af::array spectral_derivative(const af::array& signal, const std::variant<double
     return af::real(df);
 }
 
-}
\ No newline at end of file
+dim_t nextFastLength(dim_t n) {
+    if (n <= 1) return 1;
+
+    for (auto candidate = n;; candidate++) {
+        auto rest = candidate;
+        for (dim_t factor : {2, 3, 5, 7}) {
+            while (rest % factor == 0) rest /= factor;
+        }
+        if (rest == 1) return candidate;
+    }
+}
+
+af::array cwt(const af::array& tss, const af::array& widths, Wavelet wavelet, double omega0) {
+    if (widths.isempty())
+        throw std::invalid_argument("At least one width is required");
+
+    if (af::anyTrue<bool>(widths <= 0))
+        throw std::invalid_argument("Widths must be greater than zero");
+
+    auto n = tss.dims(0);
+    auto columns = tss.dims(1);
+    auto nw = widths.elements();
+    auto type = tss.type() == af::dtype::f64 ? af::dtype::f64 : af::dtype::f32;
+
+    // linear (not circular) convolution of the signals with wavelets of up to n points
+    auto padded = nextFastLength(2 * n - 1);
+    auto offset = static_cast<double>((n - 1) / 2);
+    auto crop = af::seq(offset, offset + static_cast<double>(n) - 1);
+
+    // (padded, widths, 1) spectra of the wavelets
+    af::array kernels = af::fft(sampledWavelets(widths, n, wavelet, omega0, type), padded);
+
+    auto block = std::max<dim_t>(1, CWT_BLOCK_CELLS / (padded * nw));
+    auto isComplex = wavelet == Wavelet::Morlet;
+    auto complexType = type == af::dtype::f64 ? af::dtype::c64 : af::dtype::c32;
+    af::array result = af::array(nw, n, columns, isComplex ? complexType : type);
+
+    for (dim_t start = 0; start < columns; start += block) {
+        auto end = std::min(columns, start + block);
+        auto range = af::seq(static_cast<double>(start), static_cast<double>(end - 1));
+
+        // (padded, 1, block) spectra of the signals
+        af::array signals = af::reorder(af::fft(tss(af::span, range).as(type), padded), 0, 2, 1);
+        af::array product = af::tile(kernels, 1, 1, static_cast<unsigned int>(end - start)) *
+                            af::tile(signals, 1, static_cast<unsigned int>(nw));
+        af::array convolved = af::ifft(product)(crop, af::span, af::span);
+
+        // (n, widths, block) -> (widths, n, block)
+        convolved = af::reorder(convolved, 1, 0, 2);
+        result(af::span, af::span, range) = isComplex ? convolved : af::real(convolved);
+    }
+
+    return result;
+}
+
+/**
+ * Periodic window of m points, as a column vector.
+ */
+af::array spectralWindow(dim_t m, SpectralWindow window, af::dtype type) {
+    auto phase = (2.0 * af::Pi / static_cast<double>(m)) * af::iota(af::dim4(m), af::dim4(1), type);
+    switch (window) {
+        case SpectralWindow::Hann:
+            return 0.5 - 0.5 * af::cos(phase);
+        case SpectralWindow::Hamming:
+            return 0.54 - 0.46 * af::cos(phase);
+        case SpectralWindow::Boxcar:
+            return af::constant(1.0, m, type);
+    }
+    throw std::invalid_argument("Unknown spectral window");
+}
+
+af::array welch(const af::array& tss, dim_t segmentLength, std::optional<dim_t> overlap, SpectralWindow window,
+                double fs) {
+    auto n = tss.dims(0);
+    auto signals = tss.dims(1);
+    auto noverlap = overlap.value_or(segmentLength / 2);
+
+    if (segmentLength < 1 || segmentLength > n)
+        throw std::invalid_argument("The segment length must be between one and the length of the signals");
+
+    if (noverlap < 0 || noverlap >= segmentLength)
+        throw std::invalid_argument("The overlap must be positive and lower than the segment length");
+
+    if (fs <= 0.0)
+        throw std::invalid_argument("The sampling frequency must be greater than zero");
+
+    auto type = tss.type() == af::dtype::f64 ? af::dtype::f64 : af::dtype::f32;
+    auto step = segmentLength - noverlap;
+    auto segments = (n - segmentLength) / step + 1;
+    auto bins = segmentLength / 2 + 1;
+
+    // (segmentLength, segments * signals), segments of the same signal next to each other
+    af::array frames = af::unwrap(tss.as(type), segmentLength, 1, step, 1, 0, 0, true);
+    frames -= af::tile(af::mean(frames, 0), static_cast<unsigned int>(segmentLength));
+
+    auto win = spectralWindow(segmentLength, window, type);
+    frames *= af::tile(win, 1, static_cast<unsigned int>(segments * signals));
+
+    af::array spectra = af::fftR2C<1>(frames, af::dim4(segmentLength));
+    af::array power = af::real(spectra * af::conjg(spectra));
+
+    // one sided density: every bin but the zero and, for even lengths, the Nyquist one stands for two frequencies
+    auto scale = 1.0 / (fs * af::sum<double>(win * win));
+    af::array factors = af::constant(2.0 * scale, bins, type);
+    factors(0) = scale;
+    if (segmentLength % 2 == 0) factors(bins - 1) = scale;
+
+    af::array averaged = af::mean(af::moddims(power, bins, segments, signals), 1);
+    return af::moddims(averaged, bins, signals) * af::tile(factors, 1, static_cast<unsigned int>(signals));
+}
+
+}
@@ -0,0 +1,237 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/clustering.h>
+#include <gauss/internal/vectorUtil.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using gauss::clustering::Linkage;
+
+// upper bound on the number of distances computed in one call when filling the condensed buffer
+constexpr dim_t LINKAGE_BLOCK_CELLS = 1 << 24;
+
+/**
+ * Position of d(i, j), i != j, in a condensed buffer of n series.
+ */
+inline size_t condensedIndex(dim_t n, dim_t i, dim_t j) {
+    if (i > j) std::swap(i, j);
+    return static_cast<size_t>(n) * static_cast<size_t>(i) - static_cast<size_t>(i) * static_cast<size_t>(i + 1) / 2 +
+           static_cast<size_t>(j - i - 1);
+}
+
+/**
+ * Number of series represented by a condensed buffer of the given length.
+ */
+dim_t condensedSize(dim_t entries) {
+    auto n = static_cast<dim_t>(std::llround((1.0 + std::sqrt(1.0 + 8.0 * static_cast<double>(entries))) / 2.0));
+    if (n * (n - 1) / 2 != entries)
+        throw std::invalid_argument("The length of a condensed dissimilarity matrix must be n(n-1)/2");
+    return n;
+}
+
+/**
+ * Lance-Williams update: distance from i to the union of x and y.
+ */
+double mergedDistance(Linkage method, double dxi, double dyi, double dxy, double sx, double sy, double si) {
+    switch (method) {
+        case Linkage::SINGLE:
+            return std::min(dxi, dyi);
+        case Linkage::COMPLETE:
+            return std::max(dxi, dyi);
+        case Linkage::AVERAGE:
+            return (sx * dxi + sy * dyi) / (sx + sy);
+        case Linkage::WARD: {
+            auto t = sx + sy + si;
+            return std::sqrt(std::max(((sx + si) * dxi * dxi + (sy + si) * dyi * dyi - si * dxy * dxy) / t, 0.0));
+        }
+    }
+    throw std::invalid_argument("Unknown linkage method");
+}
+
+typedef struct merge {
+    dim_t x;
+    dim_t y;
+    double distance;
+} merge_t;
+
+/**
+ * Nearest neighbour chain over a condensed buffer, which is overwritten.  Merges are returned in the order they
+ * are found, which is not necessarily sorted by distance; the merged cluster takes the position of the larger
+ * of the two indices.
+ */
+std::vector<merge_t> nnChain(std::vector<double> &d, dim_t n, Linkage method) {
+    std::vector<double> sizes(static_cast<size_t>(n), 1.0);
+    std::vector<dim_t> chain;
+    chain.reserve(static_cast<size_t>(n));
+
+    std::vector<merge_t> merges;
+    merges.reserve(static_cast<size_t>(n - 1));
+
+    for (dim_t step = 0; step < n - 1; step++) {
+        if (chain.empty()) {
+            auto first = std::find_if(sizes.begin(), sizes.end(), [](double s) { return s > 0.0; });
+            chain.push_back(static_cast<dim_t>(first - sizes.begin()));
+        }
+
+        dim_t x, y;
+        double current;
+        while (true) {
+            x = chain.back();
+
+            // the previous element in the chain wins ties, which guarantees termination
+            auto previous = chain.size() > 1 ? chain[chain.size() - 2] : dim_t(-1);
+            y = previous;
+            current = previous >= 0 ? d[condensedIndex(n, x, previous)] : std::numeric_limits<double>::infinity();
+
+            for (dim_t i = 0; i < n; i++) {
+                if (sizes[i] == 0.0 || i == x) continue;
+                auto dist = d[condensedIndex(n, x, i)];
+                if (y < 0 || dist < current) {
+                    current = dist;
+                    y = i;
+                }
+            }
+
+            if (y == previous) break;
+            chain.push_back(y);
+        }
+
+        // x and y are reciprocal nearest neighbours
+        chain.pop_back();
+        chain.pop_back();
+        if (x > y) std::swap(x, y);
+        merges.push_back({x, y, current});
+
+        auto sx = sizes[x];
+        auto sy = sizes[y];
+        for (dim_t i = 0; i < n; i++) {
+            if (sizes[i] == 0.0 || i == x || i == y) continue;
+            auto &target = d[condensedIndex(n, i, y)];
+            target = mergedDistance(method, d[condensedIndex(n, i, x)], target, current, sx, sy, sizes[i]);
+        }
+
+        sizes[x] = 0.0;
+        sizes[y] = sx + sy;
+    }
+
+    return merges;
+}
+
+/**
+ * Sorts the merges by distance and relabels them with the cluster ids used by SciPy.
+ */
+af::array linkageMatrix(std::vector<merge_t> merges, dim_t n) {
+    std::stable_sort(merges.begin(), merges.end(),
+                     [](const merge_t &a, const merge_t &b) { return a.distance < b.distance; });
+
+    // union-find over original series (ids < n) and formed clusters (ids >= n)
+    std::vector<dim_t> parent(static_cast<size_t>(2 * n - 1));
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<double> sizes(static_cast<size_t>(2 * n - 1), 1.0);
+    auto find = [&](dim_t i) {
+        auto root = i;
+        while (parent[root] != root) root = parent[root];
+        while (parent[i] != root) {
+            auto next = parent[i];
+            parent[i] = root;
+            i = next;
+        }
+        return root;
+    };
+
+    auto rows = n - 1;
+    std::vector<double> z(static_cast<size_t>(rows * 4));
+    for (dim_t r = 0; r < rows; r++) {
+        auto a = find(merges[r].x);
+        auto b = find(merges[r].y);
+        auto id = n + r;
+        parent[a] = id;
+        parent[b] = id;
+        sizes[id] = sizes[a] + sizes[b];
+
+        z[r] = static_cast<double>(std::min(a, b));
+        z[r + rows] = static_cast<double>(std::max(a, b));
+        z[r + 2 * rows] = merges[r].distance;
+        z[r + 3 * rows] = sizes[id];
+    }
+
+    return af::array(rows, 4, z.data());
+}
+
+af::array cluster(std::vector<double> &condensed, dim_t n, Linkage method) {
+    return linkageMatrix(nnChain(condensed, n, method), n);
+}
+
+}  // namespace
+
+namespace gauss::clustering {
+
+af::array linkage(const af::array &dist, Linkage method) {
+    std::vector<double> condensed;
+    dim_t n;
+
+    if (!dist.isvector() && !dist.isscalar()) {
+        if (dist.dims(0) != dist.dims(1) || dist.dims(2) > 1)
+            throw std::invalid_argument("The dissimilarity matrix must be square");
+
+        n = dist.dims(0);
+        auto square = gauss::vectorutil::get<double>(dist.as(af::dtype::f64));
+        condensed.resize(static_cast<size_t>(n * (n - 1) / 2));
+        for (dim_t i = 0; i < n; i++)
+            for (dim_t j = i + 1; j < n; j++) condensed[condensedIndex(n, i, j)] = square[i + j * n];
+    } else {
+        n = condensedSize(dist.elements());
+        condensed = gauss::vectorutil::get<double>(dist.as(af::dtype::f64));
+    }
+
+    if (n < 2)
+        throw std::invalid_argument("Hierarchical clustering requires at least two observations");
+
+    return cluster(condensed, n, method);
+}
+
+af::array linkage(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, Linkage method) {
+    if (!algo.is_symmetric)
+        throw std::invalid_argument("Hierarchical clustering requires a symmetric distance algorithm");
+
+    auto n = tss.dims(1);
+    if (n < 2)
+        throw std::invalid_argument("Hierarchical clustering requires at least two observations");
+
+    std::vector<double> condensed(static_cast<size_t>(n * (n - 1) / 2));
+
+    // rows [start, end) against columns [start, n); only the entries above the diagonal are kept
+    for (dim_t start = 0; start < n - 1;) {
+        auto cols = n - start;
+        auto end = std::min(n - 1, start + std::max<dim_t>(1, LINKAGE_BLOCK_CELLS / cols));
+
+        auto rowSeries = tss(af::span, af::seq(static_cast<double>(start), static_cast<double>(end - 1)));
+        auto colSeries = tss(af::span, af::seq(static_cast<double>(start), static_cast<double>(n - 1)));
+        auto block = gauss::distances::compute(algo, rowSeries, colSeries);
+        auto values = gauss::vectorutil::get<double>(block.as(af::dtype::f64));
+
+        auto rows = end - start;
+        for (dim_t r = 0; r < rows; r++) {
+            auto i = start + r;
+            for (dim_t j = i + 1; j < n; j++) condensed[condensedIndex(n, i, j)] = values[r + (j - start) * rows];
+        }
+
+        start = end;
+    }
+
+    return cluster(condensed, n, method);
+}
+
+}  // namespace gauss::clustering
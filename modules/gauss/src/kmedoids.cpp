@@ -0,0 +1,365 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/clustering.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// number of swap candidates evaluated concurrently before applying the best one
+constexpr dim_t CANDIDATE_GROUP = 32;
+
+using row_t = std::shared_ptr<const std::vector<double>>;
+
+/**
+ * Gives access to the distances from one series to all the others.
+ */
+class dissimilarities {
+public:
+    virtual ~dissimilarities() = default;
+    virtual dim_t size() const = 0;
+    virtual row_t row(dim_t i) = 0;
+};
+
+/**
+ * Dissimilarities held in a square or condensed matrix.
+ */
+class matrix_dissimilarities : public dissimilarities {
+public:
+    explicit matrix_dissimilarities(const af::array &dist) {
+        // vectors, either rows or columns, hold condensed matrices
+        if (!dist.isvector() && !dist.isscalar()) {
+            if (dist.dims(0) != dist.dims(1) || dist.dims(2) > 1 || dist.dims(3) > 1)
+                throw std::invalid_argument("The dissimilarity matrix must be square");
+
+            _n = dist.dims(0);
+            _condensed = false;
+        } else {
+            // n(n-1)/2 entries
+            auto entries = dist.elements();
+            _n = static_cast<dim_t>(std::llround((1.0 + std::sqrt(1.0 + 8.0 * static_cast<double>(entries))) / 2.0));
+            if (_n * (_n - 1) / 2 != entries)
+                throw std::invalid_argument("The length of a condensed dissimilarity matrix must be n(n-1)/2");
+
+            _condensed = true;
+        }
+
+        _values = gauss::vectorutil::get<double>(dist.as(af::dtype::f64));
+    }
+
+    dim_t size() const override { return _n; }
+
+    row_t row(dim_t i) override {
+        auto result = std::make_shared<std::vector<double>>(static_cast<size_t>(_n));
+        if (!_condensed) {
+            std::copy_n(_values.begin() + i * _n, _n, result->begin());
+            return result;
+        }
+
+        for (dim_t j = 0; j < _n; j++) {
+            if (j == i) {
+                (*result)[j] = 0.0;
+                continue;
+            }
+            auto a = std::min(i, j);
+            auto b = std::max(i, j);
+            (*result)[j] = _values[_n * a - a * (a + 1) / 2 + b - a - 1];
+        }
+        return result;
+    }
+
+private:
+    dim_t _n;
+    bool _condensed;
+    std::vector<double> _values;
+};
+
+/**
+ * Dissimilarities computed on demand, keeping the most recently used rows.
+ */
+class lazy_dissimilarities : public dissimilarities {
+public:
+    lazy_dissimilarities(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, dim_t capacity)
+        : _algo(algo), _tss(tss), _capacity(std::max<dim_t>(1, capacity)) {}
+
+    dim_t size() const override { return _tss.dims(1); }
+
+    row_t row(dim_t i) override {
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            auto found = _cache.find(i);
+            if (found != _cache.end()) {
+                _recent.splice(_recent.begin(), _recent, found->second.second);
+                return found->second.first;
+            }
+        }
+
+        auto computed = std::make_shared<const std::vector<double>>(
+            gauss::vectorutil::get<double>(_algo.compute(_tss(af::span, i), _tss).as(af::dtype::f64)));
+
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_cache.find(i) == _cache.end()) {
+            _recent.push_front(i);
+            _cache.emplace(i, std::make_pair(computed, _recent.begin()));
+            if (static_cast<dim_t>(_cache.size()) > _capacity) {
+                _cache.erase(_recent.back());
+                _recent.pop_back();
+            }
+        }
+        return computed;
+    }
+
+private:
+    gauss::distances::distance_algorithm_t _algo;
+    af::array _tss;
+    dim_t _capacity;
+    std::mutex _lock;
+    std::list<dim_t> _recent;
+    std::unordered_map<dim_t, std::pair<row_t, std::list<dim_t>::iterator>> _cache;
+};
+
+/**
+ * Closest and second closest medoids of a series, as positions in the list of medoids.
+ */
+typedef struct assignment {
+    dim_t nearest;
+    double d1;
+    dim_t second;
+    double d2;
+} assignment_t;
+
+/**
+ * FasterPAM over a source of dissimilarities.
+ */
+class faster_pam {
+public:
+    faster_pam(dissimilarities &source, std::vector<dim_t> medoids)
+        : _source(source), _n(source.size()), _medoids(std::move(medoids)),
+          _isMedoid(static_cast<size_t>(_n), false), _assignments(static_cast<size_t>(_n)) {
+        for (auto m : _medoids) {
+            _isMedoid[m] = true;
+            _rows.push_back(_source.row(m));
+        }
+
+        for (dim_t o = 0; o < _n; o++) assign(o);
+        updateRemovalLoss();
+    }
+
+    /**
+     * Runs passes over all the swap candidates until no swap improves the total deviation.
+     */
+    void run(int maxIterations) {
+        for (int iter = 0; iter < maxIterations; iter++) {
+            auto swapped = false;
+
+            for (dim_t start = 0; start < _n; start += CANDIDATE_GROUP) {
+                auto end = std::min(start + CANDIDATE_GROUP, _n);
+                std::vector<std::pair<double, dim_t>> changes(static_cast<size_t>(end - start));
+
+                gauss::parallel::parallelFor(start, end, [&](dim_t candidate) {
+                    changes[candidate - start] = _isMedoid[candidate]
+                                                     ? std::make_pair(std::numeric_limits<double>::infinity(), dim_t(0))
+                                                     : evaluate(*_source.row(candidate));
+                });
+
+                // best improving swap of the group; ties resolved by position
+                dim_t best = -1;
+                for (dim_t c = 0; c < end - start; c++) {
+                    if (changes[c].first < -1e-12 && (best < 0 || changes[c].first < changes[best].first)) best = c;
+                }
+
+                if (best >= 0) {
+                    swap(changes[best].second, start + best);
+                    swapped = true;
+                }
+            }
+
+            if (!swapped) break;
+        }
+    }
+
+    std::vector<dim_t> medoids() const { return _medoids; }
+
+    std::vector<unsigned int> labels() const {
+        std::vector<unsigned int> result(static_cast<size_t>(_n));
+        for (dim_t o = 0; o < _n; o++) result[o] = static_cast<unsigned int>(_assignments[o].nearest);
+        return result;
+    }
+
+private:
+    /**
+     * Recomputes the closest and second closest medoids of o.
+     */
+    void assign(dim_t o) {
+        assignment_t a{0, std::numeric_limits<double>::infinity(), 0, std::numeric_limits<double>::infinity()};
+        for (size_t m = 0; m < _rows.size(); m++) {
+            auto d = (*_rows[m])[o];
+            if (d < a.d1) {
+                a.second = a.nearest;
+                a.d2 = a.d1;
+                a.nearest = static_cast<dim_t>(m);
+                a.d1 = d;
+            } else if (d < a.d2) {
+                a.second = static_cast<dim_t>(m);
+                a.d2 = d;
+            }
+        }
+        _assignments[o] = a;
+    }
+
+    /**
+     * Change of the total deviation when each medoid is removed, without any replacement.
+     */
+    void updateRemovalLoss() {
+        _removalLoss.assign(_medoids.size(), 0.0);
+        for (const auto &a : _assignments) _removalLoss[a.nearest] += a.d2 - a.d1;
+    }
+
+    /**
+     * Finds the best medoid to be replaced by the candidate, whose distances to all the series are given,
+     * and the implied change in the total deviation.
+     */
+    std::pair<double, dim_t> evaluate(const std::vector<double> &distances) const {
+        if (_medoids.size() == 1) {
+            // every series moves to the candidate
+            auto change = 0.0;
+            for (dim_t o = 0; o < _n; o++) change += distances[o] - _assignments[o].d1;
+            return std::make_pair(change, dim_t(0));
+        }
+
+        auto delta = _removalLoss;
+        auto shared = 0.0;
+
+        for (dim_t o = 0; o < _n; o++) {
+            const auto &a = _assignments[o];
+            auto d = distances[o];
+            if (d < a.d1) {
+                // o moves to the candidate regardless of the medoid removed
+                shared += d - a.d1;
+                delta[a.nearest] += a.d1 - a.d2;
+            } else if (d < a.d2) {
+                // o only moves to the candidate when its medoid is removed
+                delta[a.nearest] += d - a.d2;
+            }
+        }
+
+        auto best = std::min_element(delta.begin(), delta.end());
+        return std::make_pair(*best + shared, static_cast<dim_t>(best - delta.begin()));
+    }
+
+    /**
+     * Replaces the medoid at the given position by the candidate.
+     */
+    void swap(dim_t position, dim_t candidate) {
+        _isMedoid[_medoids[position]] = false;
+        _isMedoid[candidate] = true;
+        _medoids[position] = candidate;
+        _rows[position] = _source.row(candidate);
+
+        const auto &distances = *_rows[position];
+        for (dim_t o = 0; o < _n; o++) {
+            auto &a = _assignments[o];
+            auto d = distances[o];
+            if (a.nearest == position || a.second == position) {
+                assign(o);
+            } else if (d < a.d1) {
+                a.second = a.nearest;
+                a.d2 = a.d1;
+                a.nearest = position;
+                a.d1 = d;
+            } else if (d < a.d2) {
+                a.second = position;
+                a.d2 = d;
+            }
+        }
+
+        updateRemovalLoss();
+    }
+
+    dissimilarities &_source;
+    dim_t _n;
+    std::vector<dim_t> _medoids;
+    std::vector<bool> _isMedoid;
+    std::vector<row_t> _rows;
+    std::vector<assignment_t> _assignments;
+    std::vector<double> _removalLoss;
+};
+
+/**
+ * Validates the given medoids or, when empty, draws k distinct series at random.
+ */
+std::vector<dim_t> initialMedoids(const af::array &medoids, dim_t n, int k, unsigned int seed) {
+    if (k < 1 || k > n)
+        throw std::invalid_argument("The number of clusters must be between one and the number of time series");
+
+    if (medoids.isempty()) {
+        std::vector<dim_t> all(static_cast<size_t>(n));
+        std::iota(all.begin(), all.end(), 0);
+        std::mt19937 rng(seed);
+        for (dim_t i = 0; i < k; i++) {
+            std::uniform_int_distribution<dim_t> pick(i, n - 1);
+            std::swap(all[i], all[pick(rng)]);
+        }
+        all.resize(static_cast<size_t>(k));
+        return all;
+    }
+
+    if (medoids.elements() != k)
+        throw std::invalid_argument("There must be k initial medoids");
+
+    auto given = gauss::vectorutil::get<unsigned int>(medoids.as(af::dtype::u32));
+    std::vector<dim_t> result(given.begin(), given.end());
+    std::vector<dim_t> sorted(result);
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.back() >= n || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        throw std::invalid_argument("The initial medoids must be distinct series");
+
+    return result;
+}
+
+void run(dissimilarities &source, int k, af::array &medoids, af::array &labels, int maxIterations, unsigned int seed) {
+    faster_pam pam(source, initialMedoids(medoids, source.size(), k, seed));
+    pam.run(maxIterations);
+
+    auto found = pam.medoids();
+    std::vector<unsigned int> hostMedoids(found.begin(), found.end());
+    auto hostLabels = pam.labels();
+    medoids = af::array(static_cast<dim_t>(hostMedoids.size()), hostMedoids.data());
+    labels = af::array(static_cast<dim_t>(hostLabels.size()), hostLabels.data());
+}
+
+}  // namespace
+
+namespace gauss::clustering {
+
+void kMedoids(const af::array &dist, int k, af::array &medoids, af::array &labels, int maxIterations,
+              unsigned int seed) {
+    matrix_dissimilarities source(dist);
+    run(source, k, medoids, labels, maxIterations, seed);
+}
+
+void kMedoids(const gauss::distances::distance_algorithm_t &algo, const af::array &tss, int k, af::array &medoids,
+              af::array &labels, int maxIterations, unsigned int seed, dim_t cacheRows) {
+    lazy_dissimilarities source(algo, tss, cacheRows);
+    run(source, k, medoids, labels, maxIterations, seed);
+}
+
+}  // namespace gauss::clustering
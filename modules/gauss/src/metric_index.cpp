@@ -0,0 +1,351 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/metric_index.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
+
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr char INDEX_MAGIC[4] = {'G', 'V', 'P', 'T'};
+constexpr uint32_t INDEX_VERSION = 2;
+
+/**
+ * Writes a single field of the index; fields are written one by one, with fixed widths, so the format does not
+ * depend on the layout of the structures in memory.
+ */
+template <typename T>
+void writeField(std::ostream &out, T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/**
+ * Reads a single field of the index, failing as soon as the stream runs out of data.
+ */
+template <typename T>
+T readField(std::istream &in) {
+    T value{};
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    if (!in.good())
+        throw std::runtime_error("Truncated metric index");
+    return value;
+}
+
+/**
+ * Evaluates the distance of the query column against all the columns in others and
+ * brings the results to the host.
+ */
+std::vector<double> evaluate(const gauss::distances::distance_algorithm_t &algo, const af::array &query,
+                             const af::array &others) {
+    return gauss::vectorutil::get<double>(algo.compute(query, others).as(af::dtype::f64));
+}
+
+/**
+ * Collects the k nearest candidates with a bounded max-heap.
+ */
+class knn_visitor {
+public:
+    explicit knn_visitor(size_t k) : _k(k) {}
+
+    double tau() const {
+        return _heap.size() < _k ? std::numeric_limits<double>::infinity() : _heap.top().first;
+    }
+
+    void offer(double d, dim_t pos) {
+        if (_heap.size() < _k) {
+            _heap.emplace(d, pos);
+        } else if (d < _heap.top().first) {
+            _heap.pop();
+            _heap.emplace(d, pos);
+        }
+    }
+
+    std::vector<std::pair<double, dim_t>> sorted() {
+        std::vector<std::pair<double, dim_t>> result;
+        result.reserve(_heap.size());
+        while (!_heap.empty()) {
+            result.push_back(_heap.top());
+            _heap.pop();
+        }
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    size_t _k;
+    std::priority_queue<std::pair<double, dim_t>> _heap;
+};
+
+/**
+ * Collects all the candidates within a fixed radius.
+ */
+class range_visitor {
+public:
+    explicit range_visitor(double radius) : _radius(radius) {}
+
+    double tau() const { return _radius; }
+
+    void offer(double d, dim_t pos) {
+        if (d <= _radius) _found.emplace_back(d, pos);
+    }
+
+    std::vector<std::pair<double, dim_t>> sorted() {
+        std::sort(_found.begin(), _found.end());
+        return std::move(_found);
+    }
+
+private:
+    double _radius;
+    std::vector<std::pair<double, dim_t>> _found;
+};
+
+}  // namespace
+
+namespace gauss::distances {
+
+metric_index::metric_index(const distance_algorithm_t &algo, const af::array &data, unbuilt_t)
+    : _algo(algo), _data(data), _leaf_size(0) {
+    if (!algo.is_metric)
+        throw std::invalid_argument("Metric indices require a distance algorithm that satisfies the triangle inequality");
+
+    if (data.isempty())
+        throw std::invalid_argument("Cannot build an index over an empty array");
+}
+
+metric_index::metric_index(const distance_algorithm_t &algo, const af::array &data, dim_t leaf_size, unsigned int seed)
+    : metric_index(algo, data, unbuilt_t{}) {
+    if (leaf_size < 1)
+        throw std::invalid_argument("The leaf size must be greater than zero");
+
+    _leaf_size = leaf_size;
+    _items.resize(static_cast<size_t>(data.dims(1)));
+    std::iota(_items.begin(), _items.end(), 0);
+
+    std::mt19937 rng(seed);
+    build(0, static_cast<dim_t>(_items.size()), rng);
+
+    _ordered = _data(af::span, af::array(static_cast<dim_t>(_items.size()), _items.data()));
+}
+
+int32_t metric_index::build(dim_t begin, dim_t end, std::mt19937 &rng) {
+    auto id = static_cast<int32_t>(_nodes.size());
+    _nodes.push_back({-1, 0.0, -1, -1, begin, end});
+
+    if (end - begin <= _leaf_size) return id;
+
+    // move a random vantage point to the start of the range
+    std::uniform_int_distribution<dim_t> pick(begin, end - 1);
+    std::swap(_items[begin], _items[pick(rng)]);
+
+    // distances from the vantage point to the rest of the range, in one batch
+    auto count = end - begin - 1;
+    auto others = _data(af::span, af::array(count, _items.data() + begin + 1));
+    auto d = evaluate(_algo, _data(af::span, _items[begin]), others);
+
+    std::vector<std::pair<double, dim_t>> keyed(static_cast<size_t>(count));
+    for (dim_t i = 0; i < count; i++) keyed[i] = std::make_pair(d[i], _items[begin + 1 + i]);
+
+    // split by the median distance
+    auto median = keyed.begin() + (count - 1) / 2;
+    std::nth_element(keyed.begin(), median, keyed.end());
+    auto mu = median->first;
+    for (dim_t i = 0; i < count; i++) _items[begin + 1 + i] = keyed[i].second;
+
+    auto split = begin + 1 + (count - 1) / 2 + 1;
+    auto inside = build(begin + 1, split, rng);
+    auto outside = split < end ? build(split, end, rng) : -1;
+
+    _nodes[id] = {begin, mu, inside, outside, 0, 0};
+    return id;
+}
+
+std::vector<double> metric_index::distancesTo(const af::array &query, dim_t begin, dim_t end) const {
+    return evaluate(_algo, query, _ordered(af::span, af::seq(static_cast<double>(begin), static_cast<double>(end - 1))));
+}
+
+af::array metric_index::checkedQueries(const af::array &queries) const {
+    if (queries.dims(0) == _data.dims(0)) return queries;
+
+    if (_algo.same_length)
+        throw std::invalid_argument("The length of the queries must match the length of the indexed series");
+
+    return queries;
+}
+
+template <typename Visitor>
+void metric_index::search(int32_t node, const af::array &query, Visitor &visitor) const {
+    const auto &current = _nodes[node];
+
+    if (current.vantage < 0) {
+        auto d = distancesTo(query, current.begin, current.end);
+        for (dim_t i = 0; i < current.end - current.begin; i++) visitor.offer(d[i], current.begin + i);
+        return;
+    }
+
+    auto d = distancesTo(query, current.vantage, current.vantage + 1)[0];
+    visitor.offer(d, current.vantage);
+
+    // visit first the ball where the query falls; the second ball is only
+    // visited when the triangle inequality cannot rule it out.
+    if (d <= current.mu) {
+        if (current.inside >= 0 && d - visitor.tau() <= current.mu) search(current.inside, query, visitor);
+        if (current.outside >= 0 && d + visitor.tau() >= current.mu) search(current.outside, query, visitor);
+    } else {
+        if (current.outside >= 0 && d + visitor.tau() >= current.mu) search(current.outside, query, visitor);
+        if (current.inside >= 0 && d - visitor.tau() <= current.mu) search(current.inside, query, visitor);
+    }
+}
+
+std::tuple<af::array, af::array> metric_index::knn(const af::array &queries, int k) const {
+    if (k < 1)
+        throw std::invalid_argument("The number of neighbours must be greater than zero");
+
+    if (k > size())
+        throw std::invalid_argument("The number of neighbours cannot exceed the number of indexed series");
+
+    auto checked = checkedQueries(queries);
+    auto nq = checked.dims(1);
+
+    // column major (nq, k) buffers
+    std::vector<double> distances(static_cast<size_t>(nq * k));
+    std::vector<unsigned int> indices(static_cast<size_t>(nq * k));
+
+    gauss::parallel::parallelFor(0, nq, [&](dim_t q) {
+        knn_visitor visitor(static_cast<size_t>(k));
+        search(0, checked(af::span, q), visitor);
+        auto found = visitor.sorted();
+        for (size_t j = 0; j < found.size(); j++) {
+            distances[q + j * nq] = found[j].first;
+            indices[q + j * nq] = static_cast<unsigned int>(_items[found[j].second]);
+        }
+    });
+
+    auto resultType = _algo.resultType.value_or(_data.type());
+    return std::make_tuple(af::array(nq, k, distances.data()).as(resultType), af::array(nq, k, indices.data()));
+}
+
+std::tuple<af::array, af::array, af::array> metric_index::range(const af::array &queries, double radius) const {
+    if (radius < 0.0)
+        throw std::invalid_argument("The radius cannot be negative");
+
+    auto checked = checkedQueries(queries);
+    auto nq = checked.dims(1);
+
+    std::vector<std::vector<std::pair<double, dim_t>>> found(static_cast<size_t>(nq));
+    gauss::parallel::parallelFor(0, nq, [&](dim_t q) {
+        range_visitor visitor(radius);
+        search(0, checked(af::span, q), visitor);
+        found[q] = visitor.sorted();
+    });
+
+    std::vector<unsigned int> offsets(static_cast<size_t>(nq + 1), 0);
+    for (dim_t q = 0; q < nq; q++) offsets[q + 1] = offsets[q] + static_cast<unsigned int>(found[q].size());
+
+    std::vector<double> distances(offsets.back());
+    std::vector<unsigned int> indices(offsets.back());
+    for (dim_t q = 0; q < nq; q++) {
+        for (size_t j = 0; j < found[q].size(); j++) {
+            distances[offsets[q] + j] = found[q][j].first;
+            indices[offsets[q] + j] = static_cast<unsigned int>(_items[found[q][j].second]);
+        }
+    }
+
+    auto resultType = _algo.resultType.value_or(_data.type());
+    auto total = static_cast<dim_t>(offsets.back());
+    auto d = total > 0 ? af::array(total, distances.data()).as(resultType) : af::array(0, resultType);
+    auto i = total > 0 ? af::array(total, indices.data()) : af::array(0, af::dtype::u32);
+    return std::make_tuple(d, i, af::array(nq + 1, offsets.data()));
+}
+
+void metric_index::save(std::ostream &out) const {
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    writeField<uint32_t>(out, INDEX_VERSION);
+    writeField<int64_t>(out, _data.dims(0));
+    writeField<int64_t>(out, static_cast<int64_t>(_items.size()));
+    writeField<int64_t>(out, static_cast<int64_t>(_nodes.size()));
+    writeField<int64_t>(out, _leaf_size);
+
+    for (auto item : _items) writeField<int64_t>(out, item);
+    for (const auto &node : _nodes) {
+        writeField<int64_t>(out, node.vantage);
+        writeField<double>(out, node.mu);
+        writeField<int32_t>(out, node.inside);
+        writeField<int32_t>(out, node.outside);
+        writeField<int64_t>(out, node.begin);
+        writeField<int64_t>(out, node.end);
+    }
+
+    if (!out)
+        throw std::runtime_error("Unable to write the metric index");
+}
+
+metric_index metric_index::load(std::istream &in, const distance_algorithm_t &algo, const af::array &data) {
+    char magic[sizeof(INDEX_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in.good() || !std::equal(magic, magic + sizeof(magic), INDEX_MAGIC) ||
+        readField<uint32_t>(in) != INDEX_VERSION)
+        throw std::runtime_error("The stream does not contain a compatible metric index");
+
+    auto rows = readField<int64_t>(in);
+    auto items = readField<int64_t>(in);
+    auto nodes = readField<int64_t>(in);
+    auto leaf = readField<int64_t>(in);
+
+    if (rows != data.dims(0) || items != data.dims(1))
+        throw std::invalid_argument("The data does not match the dimensions of the stored index");
+
+    // every node holds at least one item, either as vantage point or in its leaf
+    if (leaf < 1 || nodes < 1 || nodes > items)
+        throw std::runtime_error("Corrupt metric index");
+
+    metric_index result(algo, data, unbuilt_t{});
+    result._leaf_size = static_cast<dim_t>(leaf);
+
+    // items must be a permutation of the columns of data
+    std::vector<bool> seen(static_cast<size_t>(items), false);
+    result._items.resize(static_cast<size_t>(items));
+    for (auto &item : result._items) {
+        item = static_cast<dim_t>(readField<int64_t>(in));
+        if (item < 0 || item >= items || seen[item])
+            throw std::runtime_error("Corrupt metric index");
+        seen[item] = true;
+    }
+
+    // children are stored after their parents, thus searches always move forward and terminate
+    result._nodes.resize(static_cast<size_t>(nodes));
+    auto child = [nodes](int32_t id, int32_t c) { return c == -1 || (c > id && c < nodes); };
+    for (int32_t id = 0; id < nodes; id++) {
+        auto &node = result._nodes[id];
+        node.vantage = static_cast<dim_t>(readField<int64_t>(in));
+        node.mu = readField<double>(in);
+        node.inside = readField<int32_t>(in);
+        node.outside = readField<int32_t>(in);
+        node.begin = static_cast<dim_t>(readField<int64_t>(in));
+        node.end = static_cast<dim_t>(readField<int64_t>(in));
+
+        auto leafNode = node.vantage == -1 && node.inside == -1 && node.outside == -1 && node.begin >= 0 &&
+                        node.begin < node.end && node.end <= items;
+        auto innerNode = node.vantage >= 0 && node.vantage < items && child(id, node.inside) &&
+                         child(id, node.outside);
+        if (!leafNode && !innerNode)
+            throw std::runtime_error("Corrupt metric index");
+    }
+
+    result._ordered = data(af::span, af::array(static_cast<dim_t>(items), result._items.data()));
+    return result;
+}
+
+}  // namespace gauss::distances
@@ -0,0 +1,308 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/peaks.h>
+#include <gauss/fft.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using gauss::features::peaks_t;
+
+// upper bound on the number of wavelet coefficients computed at once when following ridge lines
+constexpr dim_t RIDGE_BLOCK_CELLS = 1 << 24;
+
+/**
+ * Maximum of the width values starting at each position of dimension zero, for the first rows - width + 1
+ * positions.  Windows double their length with every strided comparison, and two overlapping windows of the
+ * largest power of two cover the requested width.
+ */
+af::array windowMaxima(const af::array &tss, dim_t width) {
+    auto rows = tss.dims(0);
+    af::array current = tss;
+    dim_t span = 1;
+    while (2 * span <= width) {
+        auto valid = static_cast<double>(rows - 2 * span + 1);
+        current = af::max(current(af::seq(0, valid - 1), af::span),
+                          current(af::seq(static_cast<double>(span), span + valid - 1), af::span));
+        span *= 2;
+    }
+
+    auto valid = static_cast<double>(rows - width + 1);
+    auto shift = static_cast<double>(width - span);
+    return af::max(current(af::seq(0, valid - 1), af::span), current(af::seq(shift, shift + valid - 1), af::span));
+}
+
+/**
+ * Number and, optionally, positions of the peaks flagged in mask, whose first row stands for position offset.
+ */
+peaks_t fromMask(const af::array &mask, dim_t offset, bool locations) {
+    peaks_t result;
+    result.counts = af::sum(mask.as(af::dtype::u32), 0);
+    if (locations) {
+        auto rows = static_cast<unsigned int>(mask.dims(0));
+        af::array linear = af::where(af::flat(mask));
+        result.locations = (linear % rows + static_cast<unsigned int>(offset)).as(af::dtype::u32);
+        result.offsets = af::join(0, af::constant(0, 1, af::dtype::u32), af::flat(af::accum(result.counts, 1)));
+    }
+    return result;
+}
+
+/**
+ * Number and, optionally, positions of the peaks found for each series.
+ */
+peaks_t fromLists(const std::vector<std::vector<unsigned int>> &found, bool locations) {
+    auto series = static_cast<dim_t>(found.size());
+    std::vector<unsigned int> counts(found.size());
+    std::vector<unsigned int> offsets(found.size() + 1, 0);
+    for (size_t s = 0; s < found.size(); s++) {
+        counts[s] = static_cast<unsigned int>(found[s].size());
+        offsets[s + 1] = offsets[s] + counts[s];
+    }
+
+    peaks_t result;
+    result.counts = af::array(1, series, counts.data());
+    if (locations) {
+        std::vector<unsigned int> positions;
+        positions.reserve(offsets.back());
+        for (const auto &list : found) positions.insert(positions.end(), list.begin(), list.end());
+        result.locations = positions.empty() ? af::array(0, af::dtype::u32)
+                                             : af::array(static_cast<dim_t>(positions.size()), positions.data());
+        result.offsets = af::array(series + 1, offsets.data());
+    }
+    return result;
+}
+
+peaks_t supportPeaks(const af::array &tss, int support, bool locations) {
+    auto rows = tss.dims(0);
+    auto columns = tss.dims(1);
+    auto n = static_cast<dim_t>(support);
+
+    if (rows < 2 * n + 1) {
+        std::vector<std::vector<unsigned int>> none(static_cast<size_t>(columns));
+        return fromLists(none, locations);
+    }
+
+    // the n values at the left of position t are those of the window starting at t - n, and the ones at its
+    // right, those of the window starting at t + 1
+    auto maxima = windowMaxima(tss, n);
+    auto centers = tss(af::seq(static_cast<double>(n), static_cast<double>(rows - n - 1)), af::span);
+    auto left = maxima(af::seq(0, static_cast<double>(rows - 2 * n - 1)), af::span);
+    auto right = maxima(af::seq(static_cast<double>(n + 1), static_cast<double>(rows - n)), af::span);
+
+    return fromMask(centers > left && centers > right, n, locations);
+}
+
+/**
+ * Prominence of the peak at position peak: its height over the highest of the lowest points found at each side
+ * before reaching a higher value or the end of the series.
+ */
+double prominence(const double *x, dim_t n, dim_t peak) {
+    auto leftMin = x[peak];
+    for (auto i = peak; i >= 0 && x[i] <= x[peak]; i--) leftMin = std::min(leftMin, x[i]);
+
+    auto rightMin = x[peak];
+    for (auto i = peak; i < n && x[i] <= x[peak]; i++) rightMin = std::min(rightMin, x[i]);
+
+    return x[peak] - std::max(leftMin, rightMin);
+}
+
+/**
+ * Local maxima whose prominence is at least minProminence; flat peaks are reported at their middle position.
+ */
+std::vector<unsigned int> prominentPeaks(const double *x, dim_t n, double minProminence) {
+    std::vector<unsigned int> found;
+    for (dim_t i = 1; i < n - 1; i++) {
+        if (x[i - 1] >= x[i]) continue;
+
+        auto ahead = i + 1;
+        while (ahead < n - 1 && x[ahead] == x[i]) ahead++;
+
+        if (x[ahead] < x[i]) {
+            auto peak = (i + ahead - 1) / 2;
+            if (prominence(x, n, peak) >= minProminence) found.push_back(static_cast<unsigned int>(peak));
+            i = ahead;
+        }
+    }
+    return found;
+}
+
+/**
+ * Value at the given percentile of x[begin, end), interpolating linearly between the closest ranks.
+ */
+double scoreAtPercentile(const double *x, dim_t begin, dim_t end, double percentile) {
+    std::vector<double> sorted(x + begin, x + end);
+    std::sort(sorted.begin(), sorted.end());
+
+    auto idx = percentile / 100.0 * static_cast<double>(sorted.size() - 1);
+    auto i = static_cast<size_t>(idx);
+    if (static_cast<double>(i) == idx) return sorted[i];
+    return sorted[i] + (sorted[i + 1] - sorted[i]) * (idx - static_cast<double>(i));
+}
+
+typedef struct ridge_line {
+    std::vector<dim_t> rows;
+    std::vector<dim_t> cols;
+    int gap;
+} ridge_line_t;
+
+/**
+ * Follows the relative maxima of the (widths, n) matrix of coefficients c from the largest width with a maximum
+ * down to the first one, linking each maximum to the closest line, provided it ended within a quarter of the
+ * width of the row.  Lines missing more than gapThreshold consecutive rows are closed.
+ */
+std::vector<ridge_line_t> ridgeLines(const double *c, dim_t widths, dim_t n, double gapThreshold) {
+    auto isMax = [&](dim_t row, dim_t col) {
+        if (col < 1 || col > n - 2) return false;
+        auto v = c[row + col * widths];
+        return v > c[row + (col - 1) * widths] && v > c[row + (col + 1) * widths];
+    };
+
+    dim_t start = widths - 1;
+    while (start >= 0) {
+        dim_t col = 1;
+        while (col < n - 1 && !isMax(start, col)) col++;
+        if (col < n - 1) break;
+        start--;
+    }
+
+    std::vector<ridge_line_t> open, closed;
+    if (start < 0) return closed;
+
+    for (dim_t col = 1; col < n - 1; col++)
+        if (isMax(start, col)) open.push_back({{start}, {col}, 0});
+
+    for (auto row = start - 1; row >= 0; row--) {
+        // widths go from 1 to widths, and the lines may deviate up to a quarter of the width of the row
+        auto maxDistance = static_cast<double>(row + 1) / 4.0;
+
+        std::vector<dim_t> previous;
+        for (auto &line : open) {
+            line.gap++;
+            previous.push_back(line.cols.back());
+        }
+
+        for (dim_t col = 1; col < n - 1; col++) {
+            if (!isMax(row, col)) continue;
+
+            size_t closest = 0;
+            dim_t best = -1;
+            for (size_t k = 0; k < previous.size(); k++) {
+                auto d = std::abs(col - previous[k]);
+                if (best < 0 || d < best) {
+                    best = d;
+                    closest = k;
+                }
+            }
+
+            if (best >= 0 && static_cast<double>(best) <= maxDistance) {
+                open[closest].rows.push_back(row);
+                open[closest].cols.push_back(col);
+                open[closest].gap = 0;
+            } else {
+                open.push_back({{row}, {col}, 0});
+            }
+        }
+
+        for (auto k = static_cast<dim_t>(open.size()) - 1; k >= 0; k--) {
+            if (open[k].gap > gapThreshold) {
+                closed.push_back(open[k]);
+                open.erase(open.begin() + k);
+            }
+        }
+    }
+
+    closed.insert(closed.end(), open.begin(), open.end());
+    return closed;
+}
+
+/**
+ * Positions, in ascending order, of the ridge lines that span at least a quarter of the widths and whose
+ * coefficient at the smallest width stands out of the noise of the first row.
+ */
+std::vector<unsigned int> ridgePeaks(const double *c, dim_t widths, dim_t n) {
+    auto lines = ridgeLines(c, widths, n, 1.0);
+
+    auto minLength = static_cast<size_t>(std::ceil(static_cast<double>(widths) / 4.0));
+    auto window = static_cast<dim_t>(std::ceil(static_cast<double>(n) / 20.0));
+    auto half = window / 2;
+    auto odd = window % 2;
+
+    std::vector<double> firstRow(static_cast<size_t>(n));
+    for (dim_t col = 0; col < n; col++) firstRow[col] = c[col * widths];
+
+    std::vector<unsigned int> found;
+    for (const auto &line : lines) {
+        if (line.rows.size() < minLength) continue;
+
+        // rows are visited downwards, thus the last point of the line is the one with the smallest width
+        auto row = line.rows.back();
+        auto col = line.cols.back();
+        auto noise = scoreAtPercentile(firstRow.data(), std::max<dim_t>(col - half, 0),
+                                       std::min(col + half + odd, n), 10.0);
+        if (std::abs(c[row + col * widths] / noise) >= 1.0) found.push_back(static_cast<unsigned int>(col));
+    }
+
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+}  // namespace
+
+namespace gauss::features {
+
+peaks_t findPeaks(const af::array &tss, const peak_options_t &options) {
+    auto n = tss.dims(0);
+    auto columns = tss.dims(1);
+    std::vector<std::vector<unsigned int>> found(static_cast<size_t>(columns));
+
+    switch (options.mode) {
+        case PeakMode::SUPPORT:
+            if (options.support < 1)
+                throw std::invalid_argument("The support of the peaks must be greater than zero");
+            return supportPeaks(tss, options.support, options.locations);
+
+        case PeakMode::PROMINENCE: {
+            auto values = gauss::vectorutil::get<double>(tss.as(af::dtype::f64));
+            gauss::parallel::parallelFor(0, columns, [&](dim_t c) {
+                found[c] = prominentPeaks(values.data() + c * n, n, options.prominence);
+            });
+            return fromLists(found, options.locations);
+        }
+
+        case PeakMode::CWT_RIDGE: {
+            if (options.maxWidth < 1)
+                throw std::invalid_argument("The maximum width must be greater than zero");
+
+            auto type = tss.type() == af::dtype::f64 ? af::dtype::f64 : af::dtype::f32;
+            auto widths = static_cast<dim_t>(options.maxWidth);
+            auto range = af::iota(af::dim4(widths), af::dim4(1), type) + 1;
+            auto block = std::max<dim_t>(1, RIDGE_BLOCK_CELLS / std::max<dim_t>(1, widths * n));
+
+            for (dim_t first = 0; first < columns; first += block) {
+                auto last = std::min(first + block, columns) - 1;
+                auto batch = tss(af::span, af::seq(static_cast<double>(first), static_cast<double>(last))).as(type);
+                auto coefficients = gauss::vectorutil::get<double>(gauss::fft::cwt(batch, range).as(af::dtype::f64));
+
+                gauss::parallel::parallelFor(first, last + 1, [&](dim_t c) {
+                    found[c] = ridgePeaks(coefficients.data() + (c - first) * widths * n, widths, n);
+                });
+            }
+            return fromLists(found, options.locations);
+        }
+    }
+
+    throw std::invalid_argument("Unknown peak mode");
+}
+
+}  // namespace gauss::features
@@ -0,0 +1,313 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/ragged.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
+
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using gauss::ragged_array;
+
+/**
+ * Position of the series of every value, built by accumulating a mark at the start of each series but the first.
+ */
+af::array segmentKeys(const af::array &offsets, dim_t series, dim_t elements) {
+    if (series == 1) return af::constant(0, elements, af::dtype::s32);
+
+    af::array marks = af::constant(0, elements, af::dtype::s32);
+    marks(offsets(af::seq(1, static_cast<double>(series - 1)))) = 1;
+    return af::accum(marks);
+}
+
+/**
+ * Sums values by series, yielding a (1, series) row.
+ */
+af::array sumBySeries(const ragged_array &tss, const af::array &values) {
+    af::array keys, sums;
+    af::sumByKey(keys, sums, tss.keys(), values);
+    return af::moddims(sums, 1, tss.size());
+}
+
+/**
+ * Repeats each entry of a (1, series) row as many times as values in its series.
+ */
+af::array perValue(const ragged_array &tss, const af::array &row) { return af::lookup(af::flat(row), tss.keys()); }
+
+af::array lengths(const ragged_array &tss, af::dtype type) {
+    return af::moddims(af::diff1(tss.offsets()), 1, tss.size()).as(type);
+}
+
+/**
+ * Sum of the squared deviations from the mean of every series.
+ */
+af::array squaredDeviations(const ragged_array &tss) {
+    auto centered = tss.values() - perValue(tss, gauss::features::mean(tss));
+    return sumBySeries(tss, centered * centered);
+}
+
+/**
+ * Absolute differences between consecutive values of the same series; the first value of each series has none,
+ * and gets a zero.
+ */
+af::array absoluteChanges(const ragged_array &tss) {
+    auto &values = tss.values();
+    auto n = tss.elements();
+    if (n < 2) return af::constant(0, n, values.type());
+
+    auto tail = af::seq(1, static_cast<double>(n - 1));
+    auto head = af::seq(0, static_cast<double>(n - 2));
+    auto sameSeries = tss.keys()(tail) == tss.keys()(head);
+    auto changes = af::abs(values(tail) - values(head)) * sameSeries.as(values.type());
+    return af::join(0, af::constant(0, 1, values.type()), changes);
+}
+
+/**
+ * Runs algo on the host buffers of the collections, for the pairs (i, j) selected by wanted.
+ */
+template <typename Wanted>
+std::vector<double> hostDistances(const gauss::distances::distance_algorithm_t &algo, const ragged_array &xa,
+                                  const ragged_array &xb, Wanted wanted) {
+    auto rows = xa.size();
+    auto cols = xb.size();
+    auto a = gauss::vectorutil::get<double>(xa.values().as(af::dtype::f64));
+    auto b = gauss::vectorutil::get<double>(xb.values().as(af::dtype::f64));
+    auto startA = gauss::vectorutil::get<unsigned int>(xa.offsets());
+    auto startB = gauss::vectorutil::get<unsigned int>(xb.offsets());
+    auto &pair = algo.compute_pair.value();
+
+    std::vector<double> result(static_cast<size_t>(rows * cols), 0.0);
+    gauss::parallel::parallelFor(0, rows, [&](dim_t i) {
+        for (dim_t j = 0; j < cols; j++) {
+            if (!wanted(i, j)) continue;
+            result[i + j * rows] = pair(a.data() + startA[i], xa.length(i), b.data() + startB[j], xb.length(j));
+        }
+    });
+    return result;
+}
+
+/**
+ * Series of a collection sharing the same length: their positions in the collection and a (length, series)
+ * matrix with their values, so the dense kernels compare whole groups at once.
+ */
+struct length_group {
+    af::array positions;
+    af::array series;
+};
+
+std::vector<length_group> groupByLength(const ragged_array &tss) {
+    std::map<dim_t, std::vector<unsigned int>> members;
+    for (dim_t i = 0; i < tss.size(); i++) members[tss.length(i)].push_back(static_cast<unsigned int>(i));
+
+    std::vector<unsigned int> starts(static_cast<size_t>(tss.size()), 0);
+    for (dim_t i = 1; i < tss.size(); i++)
+        starts[i] = starts[i - 1] + static_cast<unsigned int>(tss.length(i - 1));
+
+    std::vector<length_group> groups;
+    for (const auto &[len, positions] : members) {
+        auto count = static_cast<dim_t>(positions.size());
+        std::vector<unsigned int> index;
+        index.reserve(static_cast<size_t>(len * count));
+        for (auto i : positions)
+            for (dim_t k = 0; k < len; k++) index.push_back(starts[i] + static_cast<unsigned int>(k));
+
+        length_group group;
+        group.positions = af::array(count, positions.data());
+        group.series = af::moddims(af::lookup(tss.values(), af::array(len * count, index.data())), len, count);
+        groups.push_back(std::move(group));
+    }
+    return groups;
+}
+
+void checkAlgorithm(const gauss::distances::distance_algorithm_t &algo) {
+    if (algo.same_length)
+        throw std::invalid_argument("Ragged collections require a distance algorithm accepting different lengths");
+}
+
+}  // namespace
+
+namespace gauss {
+
+ragged_array::ragged_array(const af::array &values, const af::array &offsets) {
+    if (!offsets.isvector() || offsets.elements() < 2)
+        throw std::invalid_argument("The offsets must be a vector with at least two entries");
+
+    if (!values.isvector() && !values.isscalar())
+        throw std::invalid_argument("The values must be a vector");
+
+    auto bounds = gauss::vectorutil::get<long long>(offsets.as(af::dtype::s64));
+    if (bounds.front() != 0 || bounds.back() != values.elements())
+        throw std::invalid_argument("The offsets must start at zero and end at the number of values");
+
+    for (size_t i = 1; i < bounds.size(); i++) {
+        if (bounds[i] <= bounds[i - 1])
+            throw std::invalid_argument("Every series in a ragged collection must hold at least one value");
+    }
+
+    _values = af::flat(values);
+    _offsets = af::flat(offsets).as(af::dtype::u32);
+    _bounds.assign(bounds.begin(), bounds.end());
+    _keys = segmentKeys(_offsets, size(), elements());
+}
+
+ragged_array::ragged_array(const af::array &values, const af::array &offsets, const af::array &keys,
+                           std::vector<dim_t> bounds)
+    : _values(values), _offsets(offsets), _keys(keys), _bounds(std::move(bounds)) {}
+
+ragged_array ragged_array::fromSeries(const std::vector<af::array> &series) {
+    if (series.empty())
+        throw std::invalid_argument("A ragged collection requires at least one series");
+
+    std::vector<unsigned int> offsets(series.size() + 1, 0);
+    for (size_t i = 0; i < series.size(); i++)
+        offsets[i + 1] = offsets[i] + static_cast<unsigned int>(series[i].elements());
+
+    af::array values(offsets.back(), series.front().type());
+    for (size_t i = 0; i < series.size(); i++) {
+        if (series[i].elements() == 0)
+            throw std::invalid_argument("Every series in a ragged collection must hold at least one value");
+        values(af::seq(offsets[i], offsets[i + 1] - 1.0)) = af::flat(series[i]);
+    }
+
+    return ragged_array(values, af::array(static_cast<dim_t>(offsets.size()), offsets.data()));
+}
+
+af::array ragged_array::series(dim_t i) const {
+    return _values(af::seq(static_cast<double>(_bounds[i]), static_cast<double>(_bounds[i + 1] - 1)));
+}
+
+ragged_array ragged_array::withValues(const af::array &values) const {
+    if (values.elements() != elements())
+        throw std::invalid_argument("The number of values does not match the offsets of the collection");
+    return ragged_array(af::flat(values), _offsets, _keys, _bounds);
+}
+
+}  // namespace gauss
+
+namespace gauss::features {
+
+af::array absEnergy(const ragged_array &tss) { return sumBySeries(tss, tss.values() * tss.values()); }
+
+af::array absoluteSumOfChanges(const ragged_array &tss) { return sumBySeries(tss, absoluteChanges(tss)); }
+
+af::array countAboveMean(const ragged_array &tss) {
+    auto above = tss.values() > perValue(tss, mean(tss));
+    return sumBySeries(tss, above.as(af::dtype::u32));
+}
+
+af::array countBelowMean(const ragged_array &tss) {
+    auto below = tss.values() < perValue(tss, mean(tss));
+    return sumBySeries(tss, below.as(af::dtype::u32));
+}
+
+af::array length(const ragged_array &tss) { return lengths(tss, af::dtype::s32); }
+
+af::array maximum(const ragged_array &tss) {
+    af::array keys, maxima;
+    af::maxByKey(keys, maxima, tss.keys(), tss.values());
+    return af::moddims(maxima, 1, tss.size());
+}
+
+af::array mean(const ragged_array &tss) {
+    return sumBySeries(tss, tss.values()) / lengths(tss, tss.values().type());
+}
+
+af::array meanAbsoluteChange(const ragged_array &tss) {
+    // as in the dense version, the sum is divided by the length of the series
+    return absoluteSumOfChanges(tss) / lengths(tss, tss.values().type());
+}
+
+af::array minimum(const ragged_array &tss) {
+    af::array keys, minima;
+    af::minByKey(keys, minima, tss.keys(), tss.values());
+    return af::moddims(minima, 1, tss.size());
+}
+
+af::array standardDeviation(const ragged_array &tss) { return af::sqrt(variance(tss)); }
+
+af::array sumValues(const ragged_array &tss) { return sumBySeries(tss, tss.values()); }
+
+af::array variance(const ragged_array &tss) {
+    return squaredDeviations(tss) / lengths(tss, tss.values().type());
+}
+
+}  // namespace gauss::features
+
+namespace gauss::normalization {
+
+ragged_array znorm(const ragged_array &tss, const int ddof) {
+    auto type = tss.values().type();
+    auto mean = gauss::features::mean(tss);
+    auto stdev = af::sqrt(squaredDeviations(tss) / (lengths(tss, type) - static_cast<double>(ddof)));
+
+    // near zero deviations are clipped, as done by the dense version
+    auto eps = (type == af::dtype::f64) ? 1e-8 : 1e-4;
+    stdev(af::abs(stdev) < eps) = eps;
+
+    return tss.withValues((tss.values() - perValue(tss, mean)) / perValue(tss, stdev));
+}
+
+}  // namespace gauss::normalization
+
+namespace gauss::distances {
+
+af::array compute(const distance_algorithm_t &algo, const ragged_array &xa) {
+    checkAlgorithm(algo);
+
+    auto n = xa.size();
+    auto type = algo.resultType.value_or(xa.values().type());
+
+    if (algo.compute_pair.has_value()) {
+        auto symmetric = algo.is_symmetric;
+        auto result = hostDistances(algo, xa, xa, [&](dim_t i, dim_t j) { return !symmetric || i < j; });
+        if (symmetric) {
+            for (dim_t i = 0; i < n; i++)
+                for (dim_t j = i + 1; j < n; j++) result[j + i * n] = result[i + j * n];
+        }
+        return af::array(n, n, result.data()).as(type);
+    }
+
+    // series are grouped by length and every pair of groups is run by the dense kernel, so the number of device
+    // calls depends on the number of distinct lengths rather than on the number of series
+    af::array result = af::constant(0.0, n, n, type);
+    auto groups = groupByLength(xa);
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t h = algo.is_symmetric ? g : 0; h < groups.size(); h++) {
+            auto block = g == h ? compute(algo, groups[g].series) : compute(algo, groups[g].series, groups[h].series);
+            result(groups[g].positions, groups[h].positions) = block.as(type);
+            if (algo.is_symmetric && g != h)
+                result(groups[h].positions, groups[g].positions) = af::transpose(block).as(type);
+        }
+    }
+    return result;
+}
+
+af::array compute(const distance_algorithm_t &algo, const ragged_array &xa, const ragged_array &xb) {
+    checkAlgorithm(algo);
+
+    auto type = algo.resultType.value_or(xa.values().type());
+
+    if (algo.compute_pair.has_value()) {
+        auto result = hostDistances(algo, xa, xb, [](dim_t, dim_t) { return true; });
+        return af::array(xa.size(), xb.size(), result.data()).as(type);
+    }
+
+    af::array result = af::constant(0.0, xa.size(), xb.size(), type);
+    auto groupsA = groupByLength(xa);
+    auto groupsB = groupByLength(xb);
+    for (const auto &a : groupsA) {
+        for (const auto &b : groupsB) result(a.positions, b.positions) = compute(algo, a.series, b.series).as(type);
+    }
+    return result;
+}
+
+}  // namespace gauss::distances
@@ -7,7 +7,6 @@
 
 #include <gauss/internal/scopedHostPtr.h>
 #include <gauss/regression.h>
-#include <gauss/statistics.h>
 
 #include <boost/math/distributions/students_t.hpp>
 
@@ -20,22 +19,12 @@ void gauss::regression::linear(const af::array &xss, const af::array &yss, af::a
     af::array meanX = af::mean(xss, 0);
     af::array meanY = af::mean(yss, 0);
 
-    af::array sumSquares = af::array(2, 2, xss.dims(1), xss.type());
-
-    // Assuming xss and yss contain the same number of time series
-    for (int i = 0; i < xss.dims(1); i++) {
-        sumSquares(af::span, af::span, i) =
-            gauss::statistics::covariance(af::join(1, xss(af::span, i), yss(af::span, i)));
-    }
-
-    af::array ssxm = sumSquares(0, 0, af::span);
-    ssxm = af::reorder(ssxm, 0, 2, 1, 3);
-    af::array ssxym = sumSquares(0, 1, af::span);
-    ssxym = af::reorder(ssxym, 0, 2, 1, 3);
-    af::array ssyxm = sumSquares(1, 0, af::span);
-    ssyxm = af::reorder(ssyxm, 0, 2, 1, 3);
-    af::array ssym = sumSquares(1, 1, af::span);
-    ssym = af::reorder(ssym, 0, 2, 1, 3);
+    // Sums of squares and cross products of the deviations from the mean, for all the time series at once
+    af::array centeredX = xss - af::tile(meanX, static_cast<unsigned int>(n));
+    af::array centeredY = yss - af::tile(meanY, static_cast<unsigned int>(n));
+    af::array ssxm = af::sum(centeredX * centeredX, 0);
+    af::array ssxym = af::sum(centeredX * centeredY, 0);
+    af::array ssym = af::sum(centeredY * centeredY, 0);
 
     af::array rNum = ssxym;
 
@@ -0,0 +1,336 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <gauss/rolling.h>
+#include <gauss/internal/parallel.h>
+#include <gauss/internal/vectorUtil.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using gauss::features::Feature;
+
+/**
+ * Power sums of the values in a window, shifted by a constant close to them to limit cancellation.  The shift is
+ * chosen again on every reset, so it follows the values of series with a trend or a level shift.
+ */
+class power_sums {
+public:
+    void add(double x) { accumulate(x, 1.0); }
+
+    void remove(double x) { accumulate(x, -1.0); }
+
+    void reset(double shift) {
+        _shift = shift;
+        _count = _s1 = _s2 = _s3 = _s4 = 0.0;
+    }
+
+    double sum() const { return _s1 + _count * _shift; }
+
+    double energy() const { return _s2 + 2.0 * _shift * _s1 + _count * _shift * _shift; }
+
+    double mean() const { return _shift + _s1 / _count; }
+
+    /**
+     * Second, third and fourth central moments, divided by the number of values.
+     */
+    void centralMoments(double &m2, double &m3, double &m4) const {
+        auto m = _s1 / _count;
+        auto a2 = _s2 / _count;
+        auto a3 = _s3 / _count;
+        auto a4 = _s4 / _count;
+        m2 = std::max(a2 - m * m, 0.0);
+        m3 = a3 - 3.0 * m * a2 + 2.0 * m * m * m;
+        m4 = a4 - 4.0 * m * a3 + 6.0 * m * m * a2 - 3.0 * m * m * m * m;
+    }
+
+private:
+    void accumulate(double x, double sign) {
+        auto d = x - _shift;
+        auto d2 = d * d;
+        _count += sign;
+        _s1 += sign * d;
+        _s2 += sign * d2;
+        _s3 += sign * d2 * d;
+        _s4 += sign * d2 * d2;
+    }
+
+    double _shift = 0.0;
+    double _count = 0.0, _s1 = 0.0, _s2 = 0.0, _s3 = 0.0, _s4 = 0.0;
+};
+
+/**
+ * Candidates to be the extreme of a window, in order of position; the front is the current extreme.  When ties
+ * are resolved in favour of the latest value, equal candidates are replaced by newer ones.
+ */
+template <typename Better>
+class monotonic_deque {
+public:
+    monotonic_deque(const double *x, bool latest) : _x(x), _latest(latest) {}
+
+    void push(dim_t i) {
+        while (!_positions.empty() && (Better()(_x[i], _x[_positions.back()]) ||
+                                       (_latest && _x[i] == _x[_positions.back()])))
+            _positions.pop_back();
+        _positions.push_back(i);
+    }
+
+    void expire(dim_t start) {
+        while (!_positions.empty() && _positions.front() < start) _positions.pop_front();
+    }
+
+    dim_t front() const { return _positions.front(); }
+
+private:
+    const double *_x;
+    bool _latest;
+    std::deque<dim_t> _positions;
+};
+
+/**
+ * Fenwick tree counting the values of a window by their rank among all the values of the series.
+ */
+class rank_counter {
+public:
+    explicit rank_counter(const double *x, dim_t n) : _sorted(x, x + n), _tree(static_cast<size_t>(n) + 1, 0) {
+        std::sort(_sorted.begin(), _sorted.end());
+        _sorted.erase(std::unique(_sorted.begin(), _sorted.end()), _sorted.end());
+    }
+
+    void add(double x, dim_t delta) {
+        for (auto i = rank(x) + 1; i < static_cast<dim_t>(_tree.size()); i += i & -i) _tree[i] += delta;
+    }
+
+    /**
+     * Number of values strictly lower than v.
+     */
+    dim_t lower(double v) const {
+        return prefix(std::lower_bound(_sorted.begin(), _sorted.end(), v) - _sorted.begin());
+    }
+
+    /**
+     * Number of values lower or equal than v.
+     */
+    dim_t lowerOrEqual(double v) const {
+        return prefix(std::upper_bound(_sorted.begin(), _sorted.end(), v) - _sorted.begin());
+    }
+
+private:
+    dim_t rank(double x) const { return std::lower_bound(_sorted.begin(), _sorted.end(), x) - _sorted.begin(); }
+
+    dim_t prefix(dim_t ranks) const {
+        dim_t total = 0;
+        for (auto i = ranks; i > 0; i -= i & -i) total += _tree[i];
+        return total;
+    }
+
+    std::vector<double> _sorted;
+    std::vector<dim_t> _tree;
+};
+
+/**
+ * Longest run of consecutive values above (or below) the threshold in [start, end).
+ */
+double longestStrike(const double *x, dim_t start, dim_t end, double threshold, bool above) {
+    dim_t longest = 0, current = 0;
+    for (auto i = start; i < end; i++) {
+        current = (above ? x[i] > threshold : x[i] < threshold) ? current + 1 : 0;
+        longest = std::max(longest, current);
+    }
+    return static_cast<double>(longest);
+}
+
+/**
+ * Evaluates the features over all the windows of a single series; out is a column major (windows, features)
+ * buffer.
+ */
+void rollingSeries(const double *x, dim_t n, dim_t window, dim_t step, const std::vector<Feature> &features,
+                   bool ranks, double *out) {
+    auto windows = (n - window) / step + 1;
+    auto len = static_cast<double>(window);
+
+    power_sums sums;
+    monotonic_deque<std::greater<double>> firstMax(x, false), lastMax(x, true);
+    monotonic_deque<std::less<double>> firstMin(x, false), lastMin(x, true);
+    std::vector<rank_counter> counter;
+    if (ranks) counter.emplace_back(x, n);
+
+    // next position to enter the window, and position where the sums were last rebuilt
+    dim_t next = 0;
+    dim_t rebuilt = 0;
+
+    for (dim_t w = 0; w < windows; w++) {
+        auto start = w * step;
+        auto end = start + window;
+
+        if (start - rebuilt >= window || next <= start) {
+            // rebuilding the sums once per window length keeps the rounding errors from piling up; they are
+            // shifted by the mean of the current window, which stays close to the values until the next rebuild
+            double shift = 0.0;
+            for (auto i = start; i < end; i++) shift += x[i];
+            sums.reset(shift / len);
+            for (auto i = start; i < std::min(next, end); i++) sums.add(x[i]);
+            rebuilt = start;
+        } else {
+            for (auto i = start - step; i < start; i++) sums.remove(x[i]);
+        }
+
+        if (ranks) {
+            auto previous = w == 0 ? 0 : start - step;
+            for (auto i = previous; i < std::min(start, next); i++) counter[0].add(x[i], -1);
+        }
+
+        for (auto i = std::max(next, start); i < end; i++) {
+            sums.add(x[i]);
+            firstMax.push(i);
+            lastMax.push(i);
+            firstMin.push(i);
+            lastMin.push(i);
+            if (ranks) counter[0].add(x[i], 1);
+        }
+        next = end;
+
+        firstMax.expire(start);
+        lastMax.expire(start);
+        firstMin.expire(start);
+        lastMin.expire(start);
+
+        double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+        sums.centralMoments(m2, m3, m4);
+        auto mean = sums.mean();
+
+        for (size_t f = 0; f < features.size(); f++) {
+            double value;
+            switch (features[f]) {
+                case Feature::ABS_ENERGY:
+                    value = sums.energy();
+                    break;
+                case Feature::COUNT_ABOVE_MEAN:
+                    value = static_cast<double>(window - counter[0].lowerOrEqual(mean));
+                    break;
+                case Feature::COUNT_BELOW_MEAN:
+                    value = static_cast<double>(counter[0].lower(mean));
+                    break;
+                case Feature::FIRST_LOCATION_OF_MAXIMUM:
+                    value = static_cast<double>(firstMax.front() - start) / len;
+                    break;
+                case Feature::FIRST_LOCATION_OF_MINIMUM:
+                    value = static_cast<double>(firstMin.front() - start) / len;
+                    break;
+                case Feature::KURTOSIS: {
+                    // same definition as statistics::kurtosis
+                    auto a = (len * (len + 1)) / ((len - 1) * (len - 2) * (len - 3));
+                    auto c = (3 * (len - 1) * (len - 1)) / ((len - 2) * (len - 3));
+                    value = a * (len * m4 / (m2 * m2)) - c;
+                    break;
+                }
+                case Feature::LAST_LOCATION_OF_MAXIMUM:
+                    value = static_cast<double>(lastMax.front() - start + 1) / len;
+                    break;
+                case Feature::LAST_LOCATION_OF_MINIMUM:
+                    value = static_cast<double>(lastMin.front() - start + 1) / len;
+                    break;
+                case Feature::LONGEST_STRIKE_ABOVE_MEAN:
+                    value = longestStrike(x, start, end, mean, true);
+                    break;
+                case Feature::LONGEST_STRIKE_BELOW_MEAN:
+                    value = longestStrike(x, start, end, mean, false);
+                    break;
+                case Feature::MAXIMUM:
+                    value = x[firstMax.front()];
+                    break;
+                case Feature::MEAN:
+                    value = mean;
+                    break;
+                case Feature::MINIMUM:
+                    value = x[firstMin.front()];
+                    break;
+                case Feature::SKEWNESS:
+                    // same definition as statistics::skewness
+                    value = (len * len / ((len - 1) * (len - 2))) * m3 / std::pow(m2, 1.5);
+                    break;
+                case Feature::STANDARD_DEVIATION:
+                    value = std::sqrt(m2);
+                    break;
+                case Feature::SUM_VALUES:
+                    value = sums.sum();
+                    break;
+                case Feature::VARIANCE:
+                    value = m2;
+                    break;
+                default:
+                    throw std::invalid_argument("Feature not supported on rolling windows");
+            }
+            out[w + static_cast<dim_t>(f) * windows] = value;
+        }
+    }
+}
+
+}  // namespace
+
+namespace gauss::features {
+
+af::array rollingFeatures(const af::array &tss, dim_t window, dim_t step, const std::vector<Feature> &features) {
+    auto n = tss.dims(0);
+    auto columns = tss.dims(1);
+
+    if (window < 1 || window > n)
+        throw std::invalid_argument("The window must be between one and the length of the time series");
+
+    if (step < 1)
+        throw std::invalid_argument("The step must be greater than zero");
+
+    if (features.empty())
+        throw std::invalid_argument("At least one feature is required");
+
+    auto ranks = false;
+    for (auto feature : features) {
+        switch (feature) {
+            case Feature::COUNT_ABOVE_MEAN:
+            case Feature::COUNT_BELOW_MEAN:
+                ranks = true;
+                break;
+            case Feature::ABS_ENERGY:
+            case Feature::FIRST_LOCATION_OF_MAXIMUM:
+            case Feature::FIRST_LOCATION_OF_MINIMUM:
+            case Feature::KURTOSIS:
+            case Feature::LAST_LOCATION_OF_MAXIMUM:
+            case Feature::LAST_LOCATION_OF_MINIMUM:
+            case Feature::LONGEST_STRIKE_ABOVE_MEAN:
+            case Feature::LONGEST_STRIKE_BELOW_MEAN:
+            case Feature::MAXIMUM:
+            case Feature::MEAN:
+            case Feature::MINIMUM:
+            case Feature::SKEWNESS:
+            case Feature::STANDARD_DEVIATION:
+            case Feature::SUM_VALUES:
+            case Feature::VARIANCE:
+                break;
+            default:
+                throw std::invalid_argument("Feature not supported on rolling windows");
+        }
+    }
+
+    auto windows = (n - window) / step + 1;
+    auto nf = static_cast<dim_t>(features.size());
+    auto values = gauss::vectorutil::get<double>(tss.as(af::dtype::f64));
+    std::vector<double> result(static_cast<size_t>(windows * nf * columns));
+
+    gauss::parallel::parallelFor(0, columns, [&](dim_t c) {
+        rollingSeries(values.data() + c * n, n, window, step, features, ranks, result.data() + c * windows * nf);
+    });
+
+    return af::array(windows, nf, columns, result.data()).as(tss.type());
+}
+
+}  // namespace gauss::features
@@ -7,10 +7,12 @@
 
 #include <gauss/statistics.h>
 #include <gauss/linalg.h>
+#include <algorithm>
 #include <variant>
 #include <optional>
 #include <iostream>
 #include <cmath>
+#include <stdexcept>
 
 af::array arange(double start, double stop, double step, const af::dtype &dtype)
 {
@@ -18,43 +20,204 @@ af::array arange(double start, double stop, double step, const af::dtype &dtype)
     return start + (af::iota(len, af::dim4(1), dtype) * step);
 }
 
+namespace
+{
+
+    // number of values of a series reduced together before the partial moments are merged
+    constexpr dim_t MOMENTS_CHUNK = 1 << 14;
+
+    /**
+     * Moments of every column of values, each one a chunk of the same series, up to the given order (2, 3 or 4).
+     * The power sums are taken from the values shifted by the first one of their column, and the central sums
+     * are derived from them, so every order costs a single fused reduction over the chunks.
+     */
+    gauss::statistics::moments_t chunkMoments(const af::array &values, const int order)
+    {
+        auto k = static_cast<double>(values.dims(0));
+        auto pivot = values.row(0);
+        auto d = values - af::tile(pivot, static_cast<unsigned int>(values.dims(0)));
+        auto s1 = af::sum(d, 0);
+        auto s2 = af::sum(d * d, 0);
+        auto delta = s1 / k;
+
+        gauss::statistics::moments_t m;
+        m.count = af::constant(k, s1.dims(), values.type());
+        m.mean = pivot + delta;
+        m.m2 = s2 - s1 * delta;
+        if (order >= 3) {
+            auto s3 = af::sum(d * d * d, 0);
+            m.m3 = s3 - 3.0 * delta * s2 + 2.0 * k * delta * delta * delta;
+            if (order >= 4) {
+                auto s4 = af::sum(d * d * d * d, 0);
+                auto delta2 = delta * delta;
+                m.m4 = s4 - 4.0 * delta * s3 + 6.0 * delta2 * s2 - 3.0 * k * delta2 * delta2;
+            }
+        }
+        return m;
+    }
+
+    /**
+     * Applies fn to every array of m.
+     */
+    template <typename Fn>
+    gauss::statistics::moments_t transform(const gauss::statistics::moments_t &m, Fn fn)
+    {
+        gauss::statistics::moments_t result;
+        result.count = fn(m.count);
+        result.mean = fn(m.mean);
+        result.m2 = fn(m.m2);
+        if (!m.m3.isempty()) result.m3 = fn(m.m3);
+        if (!m.m4.isempty()) result.m4 = fn(m.m4);
+        return result;
+    }
+
+    /**
+     * Stacks the rows of b below the ones of a.
+     */
+    gauss::statistics::moments_t stack(const gauss::statistics::moments_t &a, const gauss::statistics::moments_t &b)
+    {
+        gauss::statistics::moments_t result;
+        result.count = af::join(0, a.count, b.count);
+        result.mean = af::join(0, a.mean, b.mean);
+        result.m2 = af::join(0, a.m2, b.m2);
+        if (!a.m3.isempty()) result.m3 = af::join(0, a.m3, b.m3);
+        if (!a.m4.isempty()) result.m4 = af::join(0, a.m4, b.m4);
+        return result;
+    }
+
+    gauss::statistics::moments_t rows(const gauss::statistics::moments_t &m, const af::seq &selection)
+    {
+        return transform(m, [&](const af::array &a) { return a(selection, af::span); });
+    }
+
+    /**
+     * Moments of the series along dim, up to the given order.  Series are cut in chunks of MOMENTS_CHUNK values,
+     * whose moments are reduced on the device all at once and then merged pairwise with mergeMoments.
+     */
+    gauss::statistics::moments_t centralMoments(const af::array &tss, const unsigned int dim, const int order)
+    {
+        if (tss.iscomplex())
+            throw std::invalid_argument("Moments require a real input array");
+
+        auto type = tss.type() == af::dtype::f64 ? af::dtype::f64 : af::dtype::f32;
+        auto reduced = tss.dims();
+        reduced[dim] = 1;
+
+        // series laid out as columns; the order of the rest of dimensions is kept,
+        // thus the result only needs to be reshaped back
+        af::array x = tss.as(type);
+        if (dim != 0) {
+            unsigned int axes[4] = {dim, 0, 0, 0};
+            for (unsigned int d = 0, k = 1; d < 4; d++)
+                if (d != dim) axes[k++] = d;
+            x = af::reorder(x, axes[0], axes[1], axes[2], axes[3]);
+        }
+        auto n = x.dims(0);
+        auto series = static_cast<dim_t>(reduced.elements());
+        x = af::moddims(x, n, series);
+
+        // one row per chunk: the full chunks of every series, plus the trailing values, if any
+        auto full = n / MOMENTS_CHUNK;
+        auto remainder = n % MOMENTS_CHUNK;
+        gauss::statistics::moments_t m;
+        if (full > 0) {
+            auto chunks = af::moddims(x(af::seq(static_cast<double>(full * MOMENTS_CHUNK)), af::span),
+                                      MOMENTS_CHUNK, full * series);
+            m = transform(chunkMoments(chunks, order),
+                          [&](const af::array &a) { return af::moddims(a, full, series); });
+        }
+        if (remainder > 0) {
+            auto first = static_cast<double>(full * MOMENTS_CHUNK);
+            auto tail = chunkMoments(x(af::seq(first, static_cast<double>(n - 1)), af::span), order);
+            m = full > 0 ? stack(m, tail) : tail;
+        }
+
+        // merge the chunks pairwise, halving the number of rows every round
+        while (m.count.dims(0) > 1) {
+            auto count = m.count.dims(0);
+            auto half = count / 2;
+            auto merged = gauss::statistics::mergeMoments(rows(m, af::seq(0, 2.0 * half - 2, 2)),
+                                                          rows(m, af::seq(1, 2.0 * half - 1, 2)));
+            m = count % 2 == 1 ? stack(merged, rows(m, af::seq(count - 1.0, count - 1.0))) : merged;
+        }
+
+        return transform(m, [&](const af::array &a) { return af::moddims(a, reduced); });
+    }
+
+}
+
 namespace gauss::statistics
 {
 
+    moments_t moments(const af::array &tss, const unsigned int dim)
+    {
+        return centralMoments(tss, dim, 4);
+    }
+
+    moments_t mergeMoments(const moments_t &a, const moments_t &b)
+    {
+        auto total = a.count + b.count;
+        auto delta = b.mean - a.mean;
+        auto d2 = delta * delta;
+        auto weight = a.count * b.count / total;
+
+        moments_t merged;
+        merged.count = total;
+        merged.mean = a.mean + delta * b.count / total;
+        merged.m2 = a.m2 + b.m2 + d2 * weight;
+        // higher orders are only merged when both sides hold them
+        if (a.m3.isempty() || b.m3.isempty()) return merged;
+        merged.m3 = a.m3 + b.m3 + d2 * delta * weight * (a.count - b.count) / total +
+                    3.0 * delta * (a.count * b.m2 - b.count * a.m2) / total;
+        if (a.m4.isempty() || b.m4.isempty()) return merged;
+        merged.m4 = a.m4 + b.m4 + 
+                    d2 * d2 * weight * (a.count * a.count - a.count * b.count + b.count * b.count) / (total * total) +
+                    6.0 * d2 * (a.count * a.count * b.m2 + b.count * b.count * a.m2) / (total * total) +
+                    4.0 * delta * (a.count * b.m3 - b.count * a.m3) / total;
+        return merged;
+    }
+
     /**
      * In standard statistical practice, ddof=1 provides an unbiased estimator of the variance 
      * of a hypothetical infinite population. ddof=0 provides a maximum likelihood estimate 
      * of the variance for normally distributed variables.
      */
-    af::array stdev(const af::array &tss, const unsigned int ddof, const unsigned int dim)
+    af::array stdev(const moments_t &m, const unsigned int ddof)
     {
-        auto l = tss.dims(dim);
-        auto tile_dims = af::dim4(1,1,1,1);
-        tile_dims[dim] = l;
-
-        auto mean = af::mean(tss, dim);
-        auto mean_tiled = af::tile(mean, tile_dims);
-        auto diff = tss - mean_tiled;
-
-        auto diff2 = af::pow(diff, 2.0);
-        auto sigma = af::sum(diff2, dim);
-        auto sigma_adj = sigma / (static_cast<double>(l) - ddof);
-        return af::sqrt(sigma_adj);
+        return af::sqrt(var(m, ddof));
     }
 
-    af::array var(const af::array &tss, const unsigned int ddof, const unsigned int dim)
+    af::array var(const moments_t &m, const unsigned int ddof)
     {
-        auto l = tss.dims(dim);
-        auto tile_dims = af::dim4(1,1,1,1);
-        tile_dims[dim] = l;
+        return m.m2 / (m.count - static_cast<double>(ddof));
+    }
 
-        auto mean = af::mean(tss, dim);
-        auto mean_tiled = af::tile(mean, tile_dims);
-        auto diff = tss - mean_tiled;
+    af::array skewness(const moments_t &m)
+    {
+        const auto &n = m.count;
+        auto m3 = m.m3 / n;
+        auto s3 = af::pow(m.m2 / n, 1.5);
+        return (n * n / ((n - 1.0) * (n - 2.0))) * m3 / s3;
+    }
 
-        auto diff2 = af::pow(diff, 2.0);
-        auto sigma = af::sum(diff2, dim);
-        return sigma / (static_cast<double>(l) - ddof);
+    af::array kurtosis(const moments_t &m)
+    {
+        const auto &n = m.count;
+        auto a = (n * (n + 1.0)) / ((n - 1.0) * (n - 2.0) * (n - 3.0));
+        auto s2 = m.m2 / n;
+        auto b = m.m4 / (s2 * s2);
+        auto c = (3.0 * (n - 1.0) * (n - 1.0)) / ((n - 2.0) * (n - 3.0));
+        return a * b - c;
+    }
+
+    af::array stdev(const af::array &tss, const unsigned int ddof, const unsigned int dim)
+    {
+        return stdev(centralMoments(tss, dim, 2), ddof);
+    }
+
+    af::array var(const af::array &tss, const unsigned int ddof, const unsigned int dim)
+    {
+        return var(centralMoments(tss, dim, 2), ddof);
     }
 
     af::array moment(const af::array &tss, unsigned int k, const unsigned int dim)
@@ -65,31 +228,12 @@ namespace gauss::statistics
 
     af::array skewness(const af::array &tss, const unsigned int dim)
     {
-        auto n = static_cast<double>(tss.dims(dim));
-        auto l = tss.dims(dim);
-        auto tile_dims = af::dim4(1,1,1,1);
-        tile_dims[dim] = l;
-
-        af::array tssMinusMean = (tss - af::tile(af::mean(tss, dim), tile_dims));
-        af::array m3 = moment(tssMinusMean, 3, dim);
-        af::array s3 = af::pow(statistics::stdev(tss, 0, dim), 3);
-        return (std::pow(n, 2.0) / ((n - 1) * (n - 2))) * m3 / s3;
+        return skewness(centralMoments(tss, dim, 3));
     }
 
     af::array kurtosis(const af::array &tss, const unsigned int dim)
     {
-        auto l = tss.dims(dim);
-        auto n = static_cast<double>(tss.dims(dim));
-        auto a = (n * (n + 1)) / ((n - 1) * (n - 2) * (n - 3));
-
-        auto tile_dims = af::dim4(1,1,1,1);
-        tile_dims[dim] = l;
-
-        af::array tssMinusMean = (tss - af::tile(af::mean(tss, dim), tile_dims));
-        af::array sstdev = af::tile(statistics::stdev(tss, 0, dim), tile_dims);
-        af::array b = af::sum(af::pow(tssMinusMean / sstdev, 4), 0);
-        auto c = (3 * std::pow(n - 1, 2)) / ((n - 2) * (n - 3));
-        return a * b - c;
+        return kurtosis(moments(tss, dim));
     }
 
 
@@ -290,6 +290,77 @@ namespace pygauss {
         }
     }
 
+    namespace distances {
+
+        /**
+         * Distance algorithms exposed to python
+         */
+        typedef enum {
+            Additive_Symm_Chi,
+            Avg_L1_Linf,
+            Bhattacharyya,
+            Canberra,
+            Chebyshev,
+            Clark,
+            Cosine,
+            Czekanowski,
+            DDTW,
+            Dice,
+            Divergence,
+            DTW,
+            ERP,
+            Euclidean,
+            Fidelity,
+            Gower,
+            Hamming,
+            Harmonic_mean,
+            Hellinger,
+            Innerproduct,
+            Intersection,
+            Jaccard,
+            Jeffrey,
+            Jensen_Difference,
+            Jensen_Shannon,
+            K_Divergence,
+            Kulczynski,
+            Kullback,
+            Kumar_Johnson,
+            Kumar_Hassebrook,
+            LCSS,
+            Lorentzian,
+            Manhattan,
+            Matusita,
+            Max_Symmetric_Chi,
+            Min_Symmetric_Chi,
+            Minkowski,
+            Motyka,
+            MPDist,
+            MSM,
+            Neyman,
+            Pearson,
+            Prob_Symmetric_Chi,
+            Ruzicka,
+            SBD,
+            Soergel,
+            Sorensen,
+            Square_Chord,
+            Squared_Chi,
+            Squared_Euclidean,
+            Taneja,
+            Topsoe,
+            Tanimoto,
+            TWE,
+            Vicis_Wave_Hedges,
+            Wave_Hedges,
+            WDTW
+        } distance_types;
+
+        /**
+         * Builds the distance algorithm of the given type, reading its parameters from kwargs
+         */
+        gauss::distances::distance_algorithm_t enumToAlgo(distance_types dst, py::kwargs kwargs);
+    }
+
     namespace bindings {
         
         void device_operations(py::module &m);
@@ -327,6 +398,10 @@ namespace pygauss {
         void gauss_dimensionality_functions(py::module &m);
 
         void clustering_functions(py::module &m);
+
+        void gauss_feature_functions(py::module &m);
+
+        void gauss_ragged_functions(py::module &m);
     }
 
 
@@ -11,10 +11,225 @@
 #include <pybind11/numpy.h>
 #include <pygauss.h>
 
+#include <string>
+
 namespace py = pybind11;
 
 void pygauss::bindings::clustering_functions(py::module &m) {
 
+    py::enum_<gauss::clustering::Linkage>(m, "Linkage", "Linkage criteria for hierarchical clustering")
+            .value("Single", gauss::clustering::Linkage::SINGLE, "")
+            .value("Complete", gauss::clustering::Linkage::COMPLETE, "")
+            .value("Average", gauss::clustering::Linkage::AVERAGE, "")
+            .value("Ward", gauss::clustering::Linkage::WARD, "")
+            .export_values();
+
+    m.def(
+        "linkage_precomputed",
+        [](const py::object &data, const gauss::clustering::Linkage method) {
+            auto dist = arraylike::as_array_checked(data);
+            return gauss::clustering::linkage(dist, method);
+        },
+        py::arg("dist").none(false),
+        py::arg("method").none(false));
+
+    m.def(
+        "linkage",
+        [](const py::object &data, const gauss::clustering::Linkage method,
+           const pygauss::distances::distance_types dst, py::kwargs &kwargs) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+
+            auto algo = pygauss::distances::enumToAlgo(dst, kwargs);
+            return gauss::clustering::linkage(algo, tss, method);
+        },
+        py::arg("tss").none(false),
+        py::arg("method").none(false),
+        py::arg("dst").none(false));
+
+    m.def(
+        "kmeans_classify",
+        [](const py::object &data, const py::object &obj_centroids) {
+            auto tss = arraylike::as_array_checked(data);
+            auto centroids = arraylike::as_array_checked(obj_centroids);
+
+            arraylike::ensure_floating(tss);
+            arraylike::ensure_floating(centroids);
+
+            return gauss::clustering::kMeansClassify(tss, centroids);
+        },
+        py::arg("data").none(false),
+        py::arg("obj_centroids").none(false));
+
+    m.def(
+        "kmeans_calibrate",
+        [](const py::object &data, const int k, const py::object &obj_centroids, const float tolerance, 
+           const int max_iterations, std::optional<af::randomEngine> &engine, const std::string &algorithm) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+
+            af::array lbls;
+            af::array centroids;
+
+            if (!obj_centroids.is_none()) {
+                centroids = arraylike::as_array_checked(obj_centroids);
+                if (centroids.type() != tss.type())
+                    centroids = centroids.as(tss.type());
+            }
+
+            if (algorithm == "lloyd")
+                gauss::clustering::kMeans(tss, k, centroids, lbls, tolerance, max_iterations, engine);
+            else if (algorithm == "hamerly")
+                gauss::clustering::kMeansHamerly(tss, k, centroids, lbls, tolerance, max_iterations, engine);
+            else
+                throw std::invalid_argument("Unknown k-means algorithm: " + algorithm);
+
+            return py::make_tuple(lbls, centroids);
+        },
+        py::arg("tss").none(false),
+        py::arg("k").none(false),
+        py::arg("centroids") = py::none(),
+        py::arg("tolerance") = 1e-10,
+        py::arg("max_iterations") = 100,
+        py::arg("engine") = py::none(),
+        py::arg("algorithm") = "lloyd");
+
+    m.def(
+        "minibatch_kmeans_update",
+        [](const py::object &data, const int k, const py::object &obj_centroids, const py::object &obj_counts,
+           const dim_t seen, std::optional<af::randomEngine> &engine) {
+            auto chunk = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(chunk);
+
+            gauss::clustering::minibatch_kmeans_state_t state;
+            state.seen = seen;
+            if (!obj_centroids.is_none()) {
+                if (obj_counts.is_none())
+                    throw std::invalid_argument("Centroids and counts must be given together");
+
+                state.centroids = arraylike::as_array_checked(obj_centroids);
+                if (state.centroids.type() != chunk.type())
+                    state.centroids = state.centroids.as(chunk.type());
+
+                state.counts = arraylike::as_array_checked(obj_counts).as(af::dtype::f64);
+                if (state.counts.elements() != k)
+                    throw std::invalid_argument("There must be a count per centroid");
+                state.counts = af::moddims(state.counts, 1, k);
+            }
+
+            af::array lbls;
+            gauss::clustering::miniBatchKMeans(state, chunk, k, lbls, engine);
+            return py::make_tuple(lbls, state.centroids, state.counts, state.seen);
+        },
+        py::arg("chunk").none(false),
+        py::arg("k").none(false),
+        py::arg("centroids") = py::none(),
+        py::arg("counts") = py::none(),
+        py::arg("seen") = 0,
+        py::arg("engine") = py::none());
+
+    m.def(
+        "dbscan",
+        [](const py::object &data, const double eps, const int min_samples,
+           const pygauss::distances::distance_types dst, py::kwargs &kwargs) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+
+            af::array lbls;
+            af::array core;
+            auto algo = pygauss::distances::enumToAlgo(dst, kwargs);
+            gauss::clustering::dbscan(algo, tss, eps, min_samples, lbls, core);
+            return py::make_tuple(lbls, core);
+        },
+        py::arg("tss").none(false),
+        py::arg("eps").none(false),
+        py::arg("min_samples").none(false),
+        py::arg("dst").none(false));
+
+    m.def(
+        "hdbscan",
+        [](const py::object &data, const int min_cluster_size, const int min_samples,
+           const pygauss::distances::distance_types dst, py::kwargs &kwargs) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+
+            auto algo = pygauss::distances::enumToAlgo(dst, kwargs);
+            return gauss::clustering::hdbscan(algo, tss, min_cluster_size, min_samples);
+        },
+        py::arg("tss").none(false),
+        py::arg("min_cluster_size").none(false),
+        py::arg("min_samples").none(false),
+        py::arg("dst").none(false));
+
+    m.def(
+        "kmeans_restarts",
+        [](const py::object &data, const int k, const int n_init, const unsigned long long seed, const float tolerance,
+           const int max_iterations, const std::string &algorithm) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+
+            if (algorithm != "lloyd" && algorithm != "hamerly")
+                throw std::invalid_argument("Unknown k-means algorithm: " + algorithm);
+
+            af::array lbls;
+            af::array centroids;
+            auto inertia = gauss::clustering::kMeansRestarts(tss, k, centroids, lbls, n_init, seed, tolerance,
+                                                             max_iterations, algorithm == "hamerly");
+            return py::make_tuple(lbls, centroids, inertia);
+        },
+        py::arg("tss").none(false),
+        py::arg("k").none(false),
+        py::arg("n_init").none(false),
+        py::arg("seed") = 0,
+        py::arg("tolerance") = 1e-10,
+        py::arg("max_iterations") = 100,
+        py::arg("algorithm") = "lloyd");
+
+    m.def(
+        "kmedoids_precomputed",
+        [](const py::object &data, const int k, const py::object &obj_medoids, const int max_iterations,
+           const unsigned int seed) {
+            auto dist = arraylike::as_array_checked(data);
+
+            af::array medoids;
+            af::array lbls;
+            if (!obj_medoids.is_none())
+                medoids = arraylike::as_array_checked(obj_medoids);
+
+            gauss::clustering::kMedoids(dist, k, medoids, lbls, max_iterations, seed);
+            return py::make_tuple(lbls, medoids);
+        },
+        py::arg("dist").none(false),
+        py::arg("k").none(false),
+        py::arg("medoids") = py::none(),
+        py::arg("max_iterations") = 100,
+        py::arg("seed") = 0);
+
+    m.def(
+        "kmedoids",
+        [](const py::object &data, const int k, const pygauss::distances::distance_types dst,
+           const py::object &obj_medoids, const int max_iterations, const unsigned int seed, const dim_t cache_rows,
+           py::kwargs &kwargs) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+
+            af::array medoids;
+            af::array lbls;
+            if (!obj_medoids.is_none())
+                medoids = arraylike::as_array_checked(obj_medoids);
+
+            auto algo = pygauss::distances::enumToAlgo(dst, kwargs);
+            gauss::clustering::kMedoids(algo, tss, k, medoids, lbls, max_iterations, seed, cache_rows);
+            return py::make_tuple(lbls, medoids);
+        },
+        py::arg("tss").none(false),
+        py::arg("k").none(false),
+        py::arg("dst").none(false),
+        py::arg("medoids") = py::none(),
+        py::arg("max_iterations") = 100,
+        py::arg("seed") = 0,
+        py::arg("cache_rows") = 4096);
+
     m.def(
         "kshape_classify",
         [](const py::object &data, const py::object &obj_centroids) {
@@ -29,9 +244,33 @@ void pygauss::bindings::clustering_functions(py::module &m) {
         py::arg("data").none(false),
         py::arg("obj_centroids").none(false));
 
+    py::class_<gauss::clustering::kshape_classifier>(m, "KShapeClassifier")
+        .def(py::init([](const py::object &obj_centroids, const dim_t batch_size) {
+                 auto centroids = arraylike::as_array_checked(obj_centroids);
+                 arraylike::ensure_floating(centroids);
+                 return gauss::clustering::kshape_classifier(centroids, batch_size);
+             }),
+             py::arg("centroids").none(false),
+             py::arg("batch_size") = 64)
+        .def(
+            "classify",
+            [](const gauss::clustering::kshape_classifier &self, const py::object &data) {
+                auto tss = arraylike::as_array_checked(data);
+                arraylike::ensure_floating(tss);
+
+                af::array similarity;
+                auto lbls = self.classify(tss, similarity);
+                return py::make_tuple(lbls, similarity);
+            },
+            py::arg("data").none(false))
+        .def_property_readonly("length", &gauss::clustering::kshape_classifier::length)
+        .def_property_readonly("clusters", &gauss::clustering::kshape_classifier::clusters)
+        .def_property_readonly("batch_size", &gauss::clustering::kshape_classifier::batchSize);
+
     m.def(
         "kshape_calibrate",
-        [](const py::object &data, const int k, const py::object &labels, const int max_iterations, const bool rnd_labels) {
+        [](const py::object &data, const int k, const py::object &labels, const int max_iterations, const bool rnd_labels,
+           std::optional<af::randomEngine> &engine) {
             auto tss = arraylike::as_array_checked(data);
             arraylike::ensure_floating(tss);
 
@@ -41,12 +280,31 @@ void pygauss::bindings::clustering_functions(py::module &m) {
             if (!labels.is_none())
                 lbls = arraylike::as_array_checked(labels);
             
-            gauss::clustering::kshape_calibrate(tss, k, centroids, lbls, max_iterations, rnd_labels);
+            gauss::clustering::kshape_calibrate(tss, k, centroids, lbls, max_iterations, rnd_labels, engine);
             return py::make_tuple(lbls, centroids);
         },
         py::arg("tss").none(false),
         py::arg("k").none(false),
         py::arg("labels") = py::none(),
         py::arg("max_iterations") = 100,
-        py::arg("rnd_labels") = false);
+        py::arg("rnd_labels") = false,
+        py::arg("engine") = py::none());
+
+    m.def(
+        "kshape_restarts",
+        [](const py::object &data, const int k, const int n_init, const unsigned long long seed,
+           const int max_iterations) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+
+            af::array lbls;
+            af::array centroids;
+            auto inertia = gauss::clustering::kshape_restarts(tss, k, centroids, lbls, n_init, seed, max_iterations);
+            return py::make_tuple(lbls, centroids, inertia);
+        },
+        py::arg("tss").none(false),
+        py::arg("k").none(false),
+        py::arg("n_init").none(false),
+        py::arg("seed") = 0,
+        py::arg("max_iterations") = 100);
 }
\ No newline at end of file
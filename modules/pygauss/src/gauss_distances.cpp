@@ -10,68 +10,38 @@
 
 #include <pygauss.h>
 
+#include <sstream>
 #include <utility>
 
 namespace py = pybind11;
 namespace gdist = gauss::distances;
 
-typedef enum {
-    Additive_Symm_Chi, 
-    Avg_L1_Linf, 
-    Bhattacharyya, 
-    Canberra, 
-    Chebyshev, 
-    Clark, 
-    Cosine, 
-    Czekanowski, 
-    Dice, 
-    Divergence, 
-    DTW, 
-    Euclidean, 
-    Fidelity, 
-    Gower, 
-    Hamming, 
-    Harmonic_mean, 
-    Hellinger, 
-    Innerproduct, 
-    Intersection, 
-    Jaccard, 
-    Jeffrey, 
-    Jensen_Difference, 
-    Jensen_Shannon, 
-    K_Divergence, 
-    Kulczynski, 
-    Kullback, 
-    Kumar_Johnson, 
-    Kumar_Hassebrook, 
-    Lorentzian, 
-    Manhattan, 
-    Matusita, 
-    Max_Symmetric_Chi, 
-    Min_Symmetric_Chi, 
-    Minkowski, 
-    Motyka,
-    MPDist, 
-    Neyman, 
-    Pearson, 
-    Prob_Symmetric_Chi, 
-    Ruzicka,
-    SBD, 
-    Soergel, 
-    Sorensen, 
-    Square_Chord, 
-    Squared_Chi, 
-    Squared_Euclidean, 
-    Taneja, 
-    Topsoe, 
-    Tanimoto,
-    Vicis_Wave_Hedges, 
-    Wave_Hedges
-} distance_types;
+using pygauss::distances::distance_types;
+using pygauss::distances::enumToAlgo;
 
 
 
-gauss::distances::distance_algorithm_t enumToAlgo(distance_types dst,py::kwargs kwargs) {
+/**
+ * Reads an optional floating point parameter from kwargs
+ */
+double kwargOr(const py::kwargs &kwargs, const char *name, double defaultValue) {
+  auto key = py::str(name);
+  if (kwargs && kwargs.contains(key))
+    return kwargs[key].cast<double>();
+  return defaultValue;
+}
+
+/**
+ * Builds the options shared by elastic distances from kwargs
+ */
+gauss::distances::elastic_options_t elasticOptions(const py::kwargs &kwargs) {
+  gauss::distances::elastic_options_t opts;
+  opts.window = kwargOr(kwargs, "window", opts.window);
+  opts.cutoff = kwargOr(kwargs, "cutoff", opts.cutoff);
+  return opts;
+}
+
+gauss::distances::distance_algorithm_t pygauss::distances::enumToAlgo(distance_types dst, py::kwargs kwargs) {
   switch(dst) {
     case distance_types::Tanimoto:
           return gauss::distances::tanimoto();
@@ -99,8 +69,25 @@ gauss::distances::distance_algorithm_t enumToAlgo(distance_types dst,py::kwargs
           return gauss::distances::dice();
     case distance_types::Divergence:
           return gauss::distances::divergence();
+    case distance_types::DDTW:
+          return gauss::distances::ddtw(elasticOptions(kwargs));
     case distance_types::DTW:
-          return gauss::distances::dtw();
+          return gauss::distances::dtw(elasticOptions(kwargs));
+    case distance_types::ERP:
+          return gauss::distances::erp(kwargOr(kwargs, "g", 0.0), elasticOptions(kwargs));
+    case distance_types::LCSS:
+          {
+          auto key = py::str("epsilon");
+          if (!kwargs || !kwargs.contains(key)) throw std::invalid_argument("LCSS requires parameter epsilon");
+          return gauss::distances::lcss(kwargs[key].cast<double>(), elasticOptions(kwargs));
+        }
+    case distance_types::MSM:
+          return gauss::distances::msm(kwargOr(kwargs, "c", 1.0), elasticOptions(kwargs));
+    case distance_types::TWE:
+          return gauss::distances::twe(kwargOr(kwargs, "nu", 0.001), kwargOr(kwargs, "lambda_", 1.0),
+                                       elasticOptions(kwargs));
+    case distance_types::WDTW:
+          return gauss::distances::wdtw(kwargOr(kwargs, "g", 0.05), elasticOptions(kwargs));
     case distance_types::Euclidean:
           return gauss::distances::euclidean();
     case distance_types::Fidelity:
@@ -205,9 +192,11 @@ void pygauss::bindings::gauss_distance_functions(py::module &m) {
         .value("Clark", distance_types::Clark, "")
         .value("Cosine", distance_types::Cosine, "")
         .value("Czekanowski", distance_types::Czekanowski, "")
+        .value("DDTW", distance_types::DDTW, "")
         .value("Dice", distance_types::Dice, "")
         .value("Divergence", distance_types::Divergence, "")
         .value("DTW", distance_types::DTW, "")
+        .value("ERP", distance_types::ERP, "")
         .value("Euclidean", distance_types::Euclidean, "")
         .value("Fidelity", distance_types::Fidelity, "")
         .value("Gower", distance_types::Gower, "")
@@ -225,6 +214,7 @@ void pygauss::bindings::gauss_distance_functions(py::module &m) {
         .value("Kullback", distance_types::Kullback, "")
         .value("Kumar_Johnson", distance_types::Kumar_Johnson, "")
         .value("Kumar_Hassebrook", distance_types::Kumar_Hassebrook, "")
+        .value("LCSS", distance_types::LCSS, "")
         .value("Lorentzian", distance_types::Lorentzian, "")
         .value("Manhattan", distance_types::Manhattan, "")
         .value("Matusita", distance_types::Matusita, "")
@@ -233,6 +223,7 @@ void pygauss::bindings::gauss_distance_functions(py::module &m) {
         .value("Minkowski", distance_types::Minkowski, "")
         .value("Motyka", distance_types::Motyka, "")
         .value("MPDist", distance_types::MPDist, "")
+        .value("MSM", distance_types::MSM, "")
         .value("Neyman", distance_types::Neyman, "")
         .value("Pearson", distance_types::Pearson, "")
         .value("Prob_Symmetric_Chi", distance_types::Prob_Symmetric_Chi, "")
@@ -246,8 +237,10 @@ void pygauss::bindings::gauss_distance_functions(py::module &m) {
         .value("Taneja", distance_types::Taneja, "")
         .value("Topsoe", distance_types::Topsoe, "")
         .value("Tanimoto", distance_types::Tanimoto, "")
+        .value("TWE", distance_types::TWE, "")
         .value("Vicis_Wave_Hedges", distance_types::Vicis_Wave_Hedges, "")
         .value("Wave_Hedges", distance_types::Wave_Hedges, "")
+        .value("WDTW", distance_types::WDTW, "")
         .export_values();
 
   m.def("pdist",
@@ -270,4 +263,64 @@ void pygauss::bindings::gauss_distance_functions(py::module &m) {
     py::arg("dst").none(false)
     );
 
-}
\ No newline at end of file
+  m.def("cdist_knn",
+    [](const py::object& xa, const py::object& xb, const int k, const distance_types distType, const dim_t block_size, py::kwargs kwargs) {
+        auto left = arraylike::as_array_checked(xa);
+        auto right = arraylike::as_array_checked(xb);
+        auto [dist, idx] = gauss::distances::knn(enumToAlgo(distType, kwargs), left, right, k, block_size);
+        return py::make_tuple(dist, idx);
+    },
+    py::arg("xa").none(false),
+    py::arg("xb").none(false),
+    py::arg("k").none(false),
+    py::arg("dst").none(false),
+    py::arg("block_size") = 1024
+    );
+
+  py::class_<gdist::metric_index>(m, "MetricIndex")
+    .def(py::init([](const py::object& array_like, const distance_types distType, const dim_t leaf_size, const unsigned int seed, py::kwargs kwargs) {
+        auto data = arraylike::as_array_checked(array_like);
+        return gdist::metric_index(enumToAlgo(distType, kwargs), data, leaf_size, seed);
+      }),
+      py::arg("array_like").none(false),
+      py::arg("dst").none(false),
+      py::arg("leaf_size") = 64,
+      py::arg("seed") = 0
+    )
+    .def("knn", 
+      [](const gdist::metric_index &self, const py::object& queries, const int k) {
+        auto q = arraylike::as_array_checked(queries);
+        auto [dist, idx] = self.knn(q, k);
+        return py::make_tuple(dist, idx);
+      },
+      py::arg("queries").none(false),
+      py::arg("k").none(false)
+    )
+    .def("range", 
+      [](const gdist::metric_index &self, const py::object& queries, const double radius) {
+        auto q = arraylike::as_array_checked(queries);
+        auto [dist, idx, offsets] = self.range(q, radius);
+        return py::make_tuple(dist, idx, offsets);
+      },
+      py::arg("queries").none(false),
+      py::arg("radius").none(false)
+    )
+    .def("to_bytes", 
+      [](const gdist::metric_index &self) {
+        std::ostringstream out(std::ios::binary);
+        self.save(out);
+        return py::bytes(out.str());
+      })
+    .def_static("from_bytes",
+      [](const py::bytes& state, const py::object& array_like, const distance_types distType, py::kwargs kwargs) {
+        auto data = arraylike::as_array_checked(array_like);
+        std::istringstream in(std::string(state), std::ios::binary);
+        return gdist::metric_index::load(in, enumToAlgo(distType, kwargs), data);
+      },
+      py::arg("state").none(false),
+      py::arg("array_like").none(false),
+      py::arg("dst").none(false)
+    )
+    .def_property_readonly("size", &gdist::metric_index::size);
+
+}
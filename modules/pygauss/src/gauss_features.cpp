@@ -0,0 +1,128 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <arrayfire.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <pygauss.h>
+
+#include <utility>
+#include <vector>
+
+namespace py = pybind11;
+namespace gfeat = gauss::features;
+
+void pygauss::bindings::gauss_feature_functions(py::module &m) {
+
+    py::enum_<gfeat::Feature>(m, "Feature", "Features computed by a FeatureSet")
+            .value("AbsEnergy", gfeat::Feature::ABS_ENERGY, "")
+            .value("AbsoluteSumOfChanges", gfeat::Feature::ABSOLUTE_SUM_OF_CHANGES, "")
+            .value("ApproximateEntropy", gfeat::Feature::APPROXIMATE_ENTROPY, "")
+            .value("BinnedEntropy", gfeat::Feature::BINNED_ENTROPY, "")
+            .value("C3", gfeat::Feature::C3, "")
+            .value("CidCe", gfeat::Feature::CID_CE, "")
+            .value("CountAboveMean", gfeat::Feature::COUNT_ABOVE_MEAN, "")
+            .value("CountBelowMean", gfeat::Feature::COUNT_BELOW_MEAN, "")
+            .value("EnergyRatioByChunks", gfeat::Feature::ENERGY_RATIO_BY_CHUNKS, "")
+            .value("FftAggregatedCentroid", gfeat::Feature::FFT_AGGREGATED_CENTROID, "")
+            .value("FftAggregatedVariance", gfeat::Feature::FFT_AGGREGATED_VARIANCE, "")
+            .value("FftAggregatedSkew", gfeat::Feature::FFT_AGGREGATED_SKEW, "")
+            .value("FftAggregatedKurtosis", gfeat::Feature::FFT_AGGREGATED_KURTOSIS, "")
+            .value("FftCoefficientReal", gfeat::Feature::FFT_COEFFICIENT_REAL, "")
+            .value("FftCoefficientImag", gfeat::Feature::FFT_COEFFICIENT_IMAG, "")
+            .value("FftCoefficientAbs", gfeat::Feature::FFT_COEFFICIENT_ABS, "")
+            .value("FftCoefficientAngle", gfeat::Feature::FFT_COEFFICIENT_ANGLE, "")
+            .value("FirstLocationOfMaximum", gfeat::Feature::FIRST_LOCATION_OF_MAXIMUM, "")
+            .value("FirstLocationOfMinimum", gfeat::Feature::FIRST_LOCATION_OF_MINIMUM, "")
+            .value("HasDuplicates", gfeat::Feature::HAS_DUPLICATES, "")
+            .value("HasDuplicateMax", gfeat::Feature::HAS_DUPLICATE_MAX, "")
+            .value("HasDuplicateMin", gfeat::Feature::HAS_DUPLICATE_MIN, "")
+            .value("IndexMassQuantile", gfeat::Feature::INDEX_MASS_QUANTILE, "")
+            .value("Kurtosis", gfeat::Feature::KURTOSIS, "")
+            .value("LargeStandardDeviation", gfeat::Feature::LARGE_STANDARD_DEVIATION, "")
+            .value("LastLocationOfMaximum", gfeat::Feature::LAST_LOCATION_OF_MAXIMUM, "")
+            .value("LastLocationOfMinimum", gfeat::Feature::LAST_LOCATION_OF_MINIMUM, "")
+            .value("Length", gfeat::Feature::LENGTH, "")
+            .value("LinearTrendPvalue", gfeat::Feature::LINEAR_TREND_PVALUE, "")
+            .value("LinearTrendRvalue", gfeat::Feature::LINEAR_TREND_RVALUE, "")
+            .value("LinearTrendIntercept", gfeat::Feature::LINEAR_TREND_INTERCEPT, "")
+            .value("LinearTrendSlope", gfeat::Feature::LINEAR_TREND_SLOPE, "")
+            .value("LinearTrendStderr", gfeat::Feature::LINEAR_TREND_STDERR, "")
+            .value("LongestStrikeAboveMean", gfeat::Feature::LONGEST_STRIKE_ABOVE_MEAN, "")
+            .value("LongestStrikeBelowMean", gfeat::Feature::LONGEST_STRIKE_BELOW_MEAN, "")
+            .value("Maximum", gfeat::Feature::MAXIMUM, "")
+            .value("Mean", gfeat::Feature::MEAN, "")
+            .value("MeanAbsoluteChange", gfeat::Feature::MEAN_ABSOLUTE_CHANGE, "")
+            .value("MeanChange", gfeat::Feature::MEAN_CHANGE, "")
+            .value("MeanSecondDerivativeCentral", gfeat::Feature::MEAN_SECOND_DERIVATIVE_CENTRAL, "")
+            .value("Median", gfeat::Feature::MEDIAN, "")
+            .value("Minimum", gfeat::Feature::MINIMUM, "")
+            .value("NumberCrossingM", gfeat::Feature::NUMBER_CROSSING_M, "")
+            .value("NumberCwtPeaks", gfeat::Feature::NUMBER_CWT_PEAKS, "")
+            .value("NumberPeaks", gfeat::Feature::NUMBER_PEAKS, "")
+            .value("PercentageOfReoccurringDatapointsToAllDatapoints", gfeat::Feature::PERCENTAGE_OF_REOCCURRING_DATAPOINTS_TO_ALL_DATAPOINTS, "")
+            .value("PercentageOfReoccurringValuesToAllValues", gfeat::Feature::PERCENTAGE_OF_REOCCURRING_VALUES_TO_ALL_VALUES, "")
+            .value("RangeCount", gfeat::Feature::RANGE_COUNT, "")
+            .value("RatioBeyondRSigma", gfeat::Feature::RATIO_BEYOND_R_SIGMA, "")
+            .value("RatioValueNumberToTimeSeriesLength", gfeat::Feature::RATIO_VALUE_NUMBER_TO_TIME_SERIES_LENGTH, "")
+            .value("SampleEntropy", gfeat::Feature::SAMPLE_ENTROPY, "")
+            .value("Skewness", gfeat::Feature::SKEWNESS, "")
+            .value("SpktWelchDensity", gfeat::Feature::SPKT_WELCH_DENSITY, "")
+            .value("StandardDeviation", gfeat::Feature::STANDARD_DEVIATION, "")
+            .value("SumOfReoccurringDatapoints", gfeat::Feature::SUM_OF_REOCCURRING_DATAPOINTS, "")
+            .value("SumOfReoccurringValues", gfeat::Feature::SUM_OF_REOCCURRING_VALUES, "")
+            .value("SumValues", gfeat::Feature::SUM_VALUES, "")
+            .value("SymmetryLooking", gfeat::Feature::SYMMETRY_LOOKING, "")
+            .value("TimeReversalAsymmetryStatistic", gfeat::Feature::TIME_REVERSAL_ASYMMETRY_STATISTIC, "")
+            .value("ValueCount", gfeat::Feature::VALUE_COUNT, "")
+            .value("Variance", gfeat::Feature::VARIANCE, "")
+            .value("VarianceLargerThanStandardDeviation", gfeat::Feature::VARIANCE_LARGER_THAN_STANDARD_DEVIATION, "")
+            .export_values();
+
+    py::class_<gfeat::FeatureSet>(m, "FeatureSet")
+        .def(py::init([](const std::vector<std::pair<gfeat::Feature, std::vector<double>>> &specs) {
+                std::vector<gfeat::feature_spec_t> list;
+                for (const auto &[feature, params] : specs) list.push_back({feature, params});
+                return gfeat::FeatureSet(list);
+            }),
+            py::arg("specs").none(false)
+        )
+        .def("compute",
+            [](const gfeat::FeatureSet &self, const py::object &array_like, const dim_t block_size) {
+                auto tss = arraylike::as_array_checked(array_like);
+                return self.compute(tss, block_size);
+            },
+            py::arg("array_like").none(false),
+            py::arg("block_size") = 1024
+        )
+        .def("__len__", &gfeat::FeatureSet::size);
+
+    m.def(
+        "compute_feature",
+        [](const py::object &array_like, const gfeat::Feature feature, const std::vector<double> &params) {
+            auto tss = arraylike::as_array_checked(array_like);
+            return gfeat::computeFeature(tss, {feature, params});
+        },
+        py::arg("array_like").none(false),
+        py::arg("feature").none(false),
+        py::arg("params") = std::vector<double>()
+    );
+
+    m.def(
+        "rolling_features",
+        [](const py::object &array_like, const dim_t window, const dim_t step,
+           const std::vector<gfeat::Feature> &features) {
+            auto tss = arraylike::as_array_checked(array_like);
+            return gfeat::rollingFeatures(tss, window, step, features);
+        },
+        py::arg("array_like").none(false),
+        py::arg("window").none(false),
+        py::arg("step").none(false),
+        py::arg("features").none(false)
+    );
+}
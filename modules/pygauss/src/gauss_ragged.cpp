@@ -0,0 +1,107 @@
+/* Copyright (c) 2021 Grumpy Cat Software S.L.
+ *
+ * This Source Code is licensed under the MIT 2.0 license.
+ * the terms can be found in  LICENSE.md at the root of
+ * this project, or at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <arrayfire.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <pygauss.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace py = pybind11;
+namespace gfeat = gauss::features;
+
+using pygauss::distances::distance_types;
+using pygauss::distances::enumToAlgo;
+
+void pygauss::bindings::gauss_ragged_functions(py::module &m) {
+
+    py::class_<gauss::ragged_array>(m, "RaggedArray")
+        .def(py::init([](const std::vector<py::object> &series) {
+                std::vector<af::array> list;
+                for (const auto &s : series) list.push_back(arraylike::as_array_checked(s));
+                return gauss::ragged_array::fromSeries(list);
+            }),
+            py::arg("series").none(false)
+        )
+        .def(py::init([](const py::object &values, const py::object &offsets) {
+                return gauss::ragged_array(arraylike::as_array_checked(values), arraylike::as_array_checked(offsets));
+            }),
+            py::arg("values").none(false),
+            py::arg("offsets").none(false)
+        )
+        .def_property_readonly("values", &gauss::ragged_array::values)
+        .def_property_readonly("offsets", &gauss::ragged_array::offsets)
+        .def("series", &gauss::ragged_array::series, py::arg("index").none(false))
+        .def("length", &gauss::ragged_array::length, py::arg("index").none(false))
+        .def("__len__", &gauss::ragged_array::size);
+
+    m.def(
+        "ragged_feature",
+        [](const gauss::ragged_array &tss, const gfeat::Feature feature) {
+            switch (feature) {
+                case gfeat::Feature::ABS_ENERGY:
+                    return gfeat::absEnergy(tss);
+                case gfeat::Feature::ABSOLUTE_SUM_OF_CHANGES:
+                    return gfeat::absoluteSumOfChanges(tss);
+                case gfeat::Feature::COUNT_ABOVE_MEAN:
+                    return gfeat::countAboveMean(tss);
+                case gfeat::Feature::COUNT_BELOW_MEAN:
+                    return gfeat::countBelowMean(tss);
+                case gfeat::Feature::LENGTH:
+                    return gfeat::length(tss);
+                case gfeat::Feature::MAXIMUM:
+                    return gfeat::maximum(tss);
+                case gfeat::Feature::MEAN:
+                    return gfeat::mean(tss);
+                case gfeat::Feature::MEAN_ABSOLUTE_CHANGE:
+                    return gfeat::meanAbsoluteChange(tss);
+                case gfeat::Feature::MINIMUM:
+                    return gfeat::minimum(tss);
+                case gfeat::Feature::STANDARD_DEVIATION:
+                    return gfeat::standardDeviation(tss);
+                case gfeat::Feature::SUM_VALUES:
+                    return gfeat::sumValues(tss);
+                case gfeat::Feature::VARIANCE:
+                    return gfeat::variance(tss);
+                default:
+                    throw std::invalid_argument("Feature not supported on ragged collections");
+            }
+        },
+        py::arg("tss").none(false),
+        py::arg("feature").none(false)
+    );
+
+    m.def(
+        "ragged_znorm",
+        [](const gauss::ragged_array &tss, const int ddof) { return gauss::normalization::znorm(tss, ddof); },
+        py::arg("tss").none(false),
+        py::arg("ddof") = 0
+    );
+
+    m.def(
+        "ragged_pdist",
+        [](const gauss::ragged_array &tss, const distance_types distType, py::kwargs kwargs) {
+            return gauss::distances::compute(enumToAlgo(distType, kwargs), tss);
+        },
+        py::arg("tss").none(false),
+        py::arg("distType").none(false)
+    );
+
+    m.def(
+        "ragged_cdist",
+        [](const gauss::ragged_array &xa, const gauss::ragged_array &xb, const distance_types distType,
+           py::kwargs kwargs) {
+            return gauss::distances::compute(enumToAlgo(distType, kwargs), xa, xb);
+        },
+        py::arg("xa").none(false),
+        py::arg("xb").none(false),
+        py::arg("distType").none(false)
+    );
+}
@@ -62,4 +62,6 @@ PYBIND11_MODULE(_pygauss, m) {
     gauss_normalization_functions(m);
     gauss_dimensionality_functions(m);
     clustering_functions(m);
+    gauss_feature_functions(m);
+    gauss_ragged_functions(m);
 }
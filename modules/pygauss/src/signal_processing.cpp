@@ -21,6 +21,15 @@ void pygauss::bindings::signal_processing_functions(py::module &m)
             .value("Forward", gauss::fft::Norm::Forward, "signal -> freq: 1.0/n, freq -> signal: 1.0")
             .export_values();
 
+    py::enum_<gauss::fft::Wavelet>(m, "Wavelet", "Gauss CWT mother wavelets")
+            .value("Ricker", gauss::fft::Wavelet::Ricker, "Ricker or mexican hat wavelet")
+            .value("Morlet", gauss::fft::Wavelet::Morlet, "Complex Morlet wavelet");
+
+    py::enum_<gauss::fft::SpectralWindow>(m, "SpectralWindow", "Gauss spectral estimation windows")
+            .value("Hann", gauss::fft::SpectralWindow::Hann, "Periodic Hann window")
+            .value("Hamming", gauss::fft::SpectralWindow::Hamming, "Periodic Hamming window")
+            .value("Boxcar", gauss::fft::SpectralWindow::Boxcar, "Rectangular window");
+
     m.def(
         "fft",
         [](const py::object &signal, const std::variant<gauss::fft::Norm, double>& norm, const std::optional<af::dim4>& shape) {
@@ -114,5 +123,29 @@ void pygauss::bindings::signal_processing_functions(py::module &m)
         },
         py::arg("x").none(false),
         py::arg("axes") = py::none());
-}
 
+    m.def("cwt",
+        [](const py::object &signal, const py::object &widths, const gauss::fft::Wavelet wavelet, const double omega0) {
+            af::array s = arraylike::as_array_checked(signal);
+            arraylike::ensure_floating(s);
+            af::array w = arraylike::as_array_checked(widths);
+            return gauss::fft::cwt(s, w, wavelet, omega0);
+        },
+        py::arg("signal").none(false),
+        py::arg("widths").none(false),
+        py::arg("wavelet") = gauss::fft::Wavelet::Ricker,
+        py::arg("omega0") = 5.0);
+
+    m.def("welch",
+        [](const py::object &signal, const dim_t segment_length, const std::optional<dim_t> &overlap,
+           const gauss::fft::SpectralWindow window, const double fs) {
+            af::array s = arraylike::as_array_checked(signal);
+            arraylike::ensure_floating(s);
+            return gauss::fft::welch(s, segment_length, overlap, window, fs);
+        },
+        py::arg("signal").none(false),
+        py::arg("segment_length").none(false),
+        py::arg("overlap") = std::nullopt,
+        py::arg("window") = gauss::fft::SpectralWindow::Hann,
+        py::arg("fs") = 1.0);
+}
\ No newline at end of file
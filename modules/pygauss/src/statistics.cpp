@@ -12,6 +12,8 @@
 
 #include <pygauss.h>
 
+#include <stdexcept>
+
 namespace py = pybind11;
 namespace gs = gauss::statistics;
 
@@ -144,6 +146,33 @@ void pygauss::bindings::statistic_functions(py::module &m)
         py::arg("k").none(false),
         py::arg("dim") = 0);
 
+    m.def(
+        "moments",
+        [](const py::object &data, const unsigned int dim) {
+            auto tss = arraylike::as_array_checked(data);
+            arraylike::ensure_floating(tss);
+            auto result = gs::moments(tss, dim);
+            return py::make_tuple(result.count, result.mean, result.m2, result.m3, result.m4);
+        },
+        py::arg("data").none(false),
+        py::arg("dim") = 0);
+
+    m.def(
+        "merge_moments",
+        [](const py::tuple &a, const py::tuple &b) {
+            auto unpack = [](const py::tuple &t) {
+                if (t.size() != 5)
+                    throw std::invalid_argument("Moments are made of count, mean, m2, m3 and m4");
+                return gs::moments_t{arraylike::as_array_checked(t[0]), arraylike::as_array_checked(t[1]),
+                                     arraylike::as_array_checked(t[2]), arraylike::as_array_checked(t[3]),
+                                     arraylike::as_array_checked(t[4])};
+            };
+            auto result = gs::mergeMoments(unpack(a), unpack(b));
+            return py::make_tuple(result.count, result.mean, result.m2, result.m3, result.m4);
+        },
+        py::arg("a").none(false),
+        py::arg("b").none(false));
+
 
 
     m.def(
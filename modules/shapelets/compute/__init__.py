@@ -69,8 +69,10 @@ from . import matrixprofile
 from . import normalization
 from . import dimensionality
 from . import clustering
+from . import features
+from . import ragged
 
-__all__ = ["random", "fft", "distances", "matrixprofile", "normalization", "dimensionality", "clustering"]
+__all__ = ["random", "fft", "distances", "matrixprofile", "normalization", "dimensionality", "clustering", "features", "ragged"]
 
 # direct imports
 from . import _device
@@ -202,6 +202,57 @@ def moment(data: ArrayLike, k: int, dim: int = 0) -> ShapeletsArray:
     return _pygauss.moment(data, k, dim)
 
 
+class Moments(NamedTuple):
+    count: ShapeletsArray
+    mean: ShapeletsArray
+    m2: ShapeletsArray
+    m3: ShapeletsArray
+    m4: ShapeletsArray
+
+
+def moments(data: ArrayLike, dim: int = 0) -> Moments:
+    r"""
+    Computes the count, the mean and the sums of the second, third and fourth powers of the 
+    deviations from the mean of every sequence found along a dimension.
+
+    Parameters
+    ----------
+    data: ArrayLike
+        Input data
+    
+    dim: int, defaults to 0
+        Dimension to iterate through 
+
+    Returns
+    -------
+    Moments
+        A named tuple whose arrays hold one entry per sequence.  Moments of disjoint parts of 
+        the same sequences are combined with :obj:`merge_moments`.
+    """
+    return Moments(*_pygauss.moments(data, dim))
+
+
+def merge_moments(a: Moments, b: Moments) -> Moments:
+    r"""
+    Combines the moments of two disjoint parts of the same sequences, as returned by 
+    :obj:`moments`, as if they had been computed over both parts together.
+
+    Parameters
+    ----------
+    a: Moments
+        Moments of the first part.
+    
+    b: Moments
+        Moments of the second part.
+
+    Returns
+    -------
+    Moments
+        The moments of the union of both parts.
+    """
+    return Moments(*_pygauss.merge_moments(tuple(a), tuple(b)))
+
+
 def kurtosis(data: ArrayLike, dim: int = 0) -> ShapeletsArray:
     r"""
     Calculates the sample kurtosis of data, calculated with the adjusted Fisher-Pearson standardized moment
@@ -597,7 +648,7 @@ def topk_min(data: ArrayLike, k: int, dim: int = 0) -> TopKResult:
 
 
 __all__ = [
-    "mean", "median", "std", "var", "moment",
+    "mean", "median", "std", "var", "moment", "moments", "merge_moments", "Moments",
     "kurtosis", "skewness", "cov", "corrcoef", "xcorr", "xcov",
     "acorr", "acov", "topk_max", "topk_min",
     "XCoResults", "TopKResult", "XCorrScale"
@@ -4,12 +4,642 @@
 # the terms can be found in  LICENSE.md at the root of
 # this project, or at http://mozilla.org/MPL/2.0/.
 
-from typing import Optional
+from __future__ import annotations
+from typing import Iterable, Optional, Tuple, Union
 import warnings
+
+try:
+    from typing import Literal
+except ImportError:
+    from typing_extensions import Literal
+
 from .__basic_typing import ArrayLike
 from ._array_obj import ShapeletsArray
 
 from shapelets.compute import _pygauss
+from . import distances as _distances
+from .random import ShapeletsRandomEngine
+
+
+LinkageMethod = Literal['single', 'complete', 'average', 'ward']
+
+
+def __convert_linkage(method: LinkageMethod):
+    if method == 'single':
+        return _pygauss.Linkage.Single
+    elif method == 'complete':
+        return _pygauss.Linkage.Complete
+    elif method == 'average':
+        return _pygauss.Linkage.Average
+    elif method == 'ward':
+        return _pygauss.Linkage.Ward
+    else:
+        raise ValueError("Unknown linkage method")
+
+
+_convert_linkage = __convert_linkage
+
+
+def linkage(X: ArrayLike, method: LinkageMethod = 'single', metric: str = 'euclidean', **kwargs) -> ShapeletsArray:
+    """
+    Hierarchical agglomerative clustering.
+
+    Uses the nearest neighbour chain algorithm [1]_, which runs in quadratic time and 
+    only keeps the condensed distance matrix in memory; the distances are computed and 
+    updated within the library, without going through Python.
+
+    Parameters
+    ----------
+    X: ArrayLike
+        Columnar matrix, NxM, representing M timeseries with N observations or, when the 
+        metric is ``precomputed``, either the square matrix returned by 
+        :obj:`~shapelets.compute.distances.pdist` or its condensed form (the entries 
+        above the diagonal, row by row).
+
+    method: str (default: 'single')
+        Linkage criterion: ``single``, ``complete``, ``average`` or ``ward``.
+
+    metric: DistanceType or 'precomputed' (default: 'euclidean')
+        Distance between time series, which must be symmetric.
+
+    **kwargs:
+        Parameters of the metric, for example, ``w`` for ``mpdist``.
+
+    Returns
+    -------
+    ShapeletsArray
+        A (M-1)x4 linkage matrix, in the same format as ``scipy.cluster.hierarchy.linkage``, 
+        so it can be used with ``dendrogram`` or ``fcluster``.
+
+    References
+    ----------
+    .. [1] | `Modern hierarchical, agglomerative clustering algorithms. <https://arxiv.org/abs/1109.2378>`_
+           | Daniel Müllner. 2011.
+
+    Examples
+    --------
+    >>> import shapelets.compute as sc
+    >>> from scipy.cluster.hierarchy import fcluster
+    >>> data = sc.random.randn((64, 1000))
+    >>> Z = sc.clustering.linkage(data, 'ward')
+    >>> labels = fcluster(Z, 4, criterion='maxclust')
+    """
+    if metric == 'precomputed':
+        return _pygauss.linkage_precomputed(X, __convert_linkage(method))
+
+    return _pygauss.linkage(X, __convert_linkage(method), _distances._convert_dst_type(metric), **kwargs)
+
+
+class KMeans():
+    """
+    K-Means clustering.
+
+    Implementation of Lloyd's algorithm [1]_ whose initial centroids are chosen as per 
+    k-means++ [2]_.  Distances to the centroids are computed in blocks as matrix products 
+    and the centroids are updated through a segmented reduction over the labels.
+
+    Parameters
+    ----------
+    k: int
+        Number of clusters.
+
+    tolerance: float (default: 1e-10)
+        The algorithm stops when the accumulated displacement of the centroids between two 
+        iterations is below this value.
+
+    max_iterations: int (default: 100)
+        Maximum number of iterations.
+
+    engine: ShapeletsRandomEngine (default: None)
+        Random engine used to choose the initial centroids; when not set, the default 
+        engine is used.  Provide an engine with a fixed seed for reproducible results.
+
+    algorithm: str (default: 'lloyd')
+        ``lloyd`` compares every series against all the centroids on each iteration, 
+        whereas ``hamerly`` [3]_ keeps bounds on those distances, derived from the 
+        triangle inequality, and skips the comparisons that cannot change a label.  
+        Both produce the same labels; ``hamerly`` is usually much faster for large 
+        number of clusters or series.
+
+    n_init: int (default: 1)
+        Number of k-means++ seedings to run when no initial centroids are given.  The 
+        restarts run concurrently and the one with the lowest inertia is kept.
+
+    seed: int (default: 0)
+        Seed of the first restart when ``n_init`` is greater than one; restart ``r`` uses 
+        ``seed + r``, so results are reproducible.
+
+    Attributes
+    ----------
+    labels_: ShapeletsArray
+        Computed labels for the training set.
+    
+    centroids_: ShapeletsArray
+        Computed centroids implied from the training set.
+
+    inertia_: float
+        Sum of squared distances of the series to their centroids, when fitted with 
+        ``n_init`` greater than one.
+
+    Notes
+    -----
+    Time series are expected in columnar layout, that is, if presented with a NxM matrix, data 
+    will be interpreted as M time series of N elements.
+
+    References
+    ----------
+    .. [1] | `Least squares quantization in PCM. <https://doi.org/10.1109/TIT.1982.1056489>`_
+           | S. Lloyd. 1982.
+           | IEEE Transactions on Information Theory, 28, 2, 129-137.
+
+    .. [2] | `k-means++: the advantages of careful seeding. <https://dl.acm.org/doi/10.5555/1283383.1283494>`_
+           | David Arthur and Sergei Vassilvitskii. 2007.
+           | Proceedings of the eighteenth annual ACM-SIAM symposium on Discrete algorithms, 1027-1035.
+
+    .. [3] | `Making k-means even faster. <https://doi.org/10.1137/1.9781611972801.12>`_
+           | Greg Hamerly. 2010.
+           | Proceedings of the 2010 SIAM International Conference on Data Mining, 130-140.
+
+    """
+
+    def __init__(self, k: int, tolerance: float = 1e-10, max_iterations: int = 100,
+                 engine: Optional[ShapeletsRandomEngine] = None,
+                 algorithm: Literal['lloyd', 'hamerly'] = 'lloyd', n_init: int = 1, seed: int = 0) -> None:
+        """
+        Creates a new instace
+        """
+        if (k <= 0):
+            raise ValueError("The number of clusters must be a integer greater than 0")
+
+        if algorithm not in ('lloyd', 'hamerly'):
+            raise ValueError("Unknown algorithm " + str(algorithm))
+
+        self.k = k
+        self.tolerance = tolerance
+        self.max_iterations = max_iterations
+        self.engine = engine
+        self.algorithm = algorithm
+        self.n_init = n_init
+        self.seed = seed
+        self.labels_ = None
+        self.centroids_ = None
+        self.inertia_ = None
+
+    def fit(self, X: ArrayLike, centroids: Optional[ArrayLike] = None):
+        """
+        Computes centroids and implied labels from a training set
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+        
+        centroids: ArrayLike (default: None)
+            Columnar matrix, Nxk, with the initial centroids.  When not set, they are 
+            chosen with k-means++.
+        """
+        if centroids is None and self.n_init > 1:
+            result = _pygauss.kmeans_restarts(X, self.k, self.n_init, self.seed, self.tolerance, self.max_iterations,
+                                              self.algorithm)
+            self.inertia_ = result[2]
+        else:
+            result = _pygauss.kmeans_calibrate(X, self.k, centroids, self.tolerance, self.max_iterations, self.engine,
+                                               self.algorithm)
+            self.inertia_ = None
+
+        self.labels_ = result[0]
+        self.centroids_ = result[1]
+
+    def fit_predict(self, X: ArrayLike, centroids: Optional[ArrayLike] = None) -> ShapeletsArray:
+        """
+        Computes centroids from a training set and returns the implied labels
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+        
+        centroids: ArrayLike (default: None)
+            Columnar matrix, Nxk, with the initial centroids.
+
+        Returns
+        -------
+        ShapeletsArray
+            Implied labels after running the fitting algorithm.    
+        """
+        self.fit(X, centroids)
+        return self.labels_
+
+    def predict(self, X: ArrayLike) -> ShapeletsArray:
+        """
+        Predict the closest cluster each time series in X belongs to.
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+
+        Returns
+        -------
+        ShapeletsArray
+            A columnar array, Mx1, indicating the closest cluster to each series in X.
+        """
+        if self.centroids_ is None:
+            raise ValueError("No centroids available for prediction")
+
+        return _pygauss.kmeans_classify(X, self.centroids_)
+
+
+class MiniBatchKMeans():
+    """
+    Mini-batch K-Means clustering.
+
+    Implementation of the mini-batch k-means of [1]_, which consumes the data in chunks 
+    of series.  Each series of a chunk is assigned to its closest centroid and every 
+    centroid then moves towards the series it got, with a learning rate of one over the 
+    number of series it has absorbed so far.
+
+    Since only a chunk is held in memory at any given time, it is possible to cluster 
+    datasets that do not fit in memory (for example, from a ``numpy.memmap``) or to keep 
+    updating a model as new data arrives.
+
+    Parameters
+    ----------
+    k: int
+        Number of clusters.
+
+    batch_size: int (default: 1024)
+        Number of series per chunk when ``fit`` is given a matrix.
+
+    engine: ShapeletsRandomEngine (default: None)
+        Random engine used to choose the initial centroids from the first chunk, 
+        which must hold at least k series.
+
+    Attributes
+    ----------
+    centroids_: ShapeletsArray
+        Current centroids.
+
+    counts_: ShapeletsArray
+        Number of series absorbed by each centroid.
+
+    n_seen_: int
+        Number of series processed.
+
+    Notes
+    -----
+    The state of the model is fully described by ``centroids_``, ``counts_`` and ``n_seen_``; 
+    they can be persisted and given back to the constructor to resume the training.
+
+    References
+    ----------
+    .. [1] | `Web-scale k-means clustering. <https://doi.org/10.1145/1772690.1772862>`_
+           | D. Sculley. 2010.
+           | Proceedings of the 19th international conference on World Wide Web, 1177-1178.
+
+    """
+
+    def __init__(self, k: int, batch_size: int = 1024, engine: Optional[ShapeletsRandomEngine] = None,
+                 centroids: Optional[ArrayLike] = None, counts: Optional[ArrayLike] = None, n_seen: int = 0) -> None:
+        """
+        Creates a new instance, optionally resuming from a previous state
+        """
+        if (k <= 0):
+            raise ValueError("The number of clusters must be a integer greater than 0")
+
+        if (batch_size <= 0):
+            raise ValueError("The batch size must be a integer greater than 0")
+
+        if (centroids is None) != (counts is None):
+            raise ValueError("Centroids and counts must be given together")
+
+        self.k = k
+        self.batch_size = batch_size
+        self.engine = engine
+        self.centroids_ = centroids
+        self.counts_ = counts
+        self.n_seen_ = n_seen
+
+    def partial_fit(self, X: ArrayLike) -> ShapeletsArray:
+        """
+        Updates the model with a chunk of series
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+
+        Returns
+        -------
+        ShapeletsArray
+            Labels of the series in X, as assigned before the update.
+        """
+        labels, self.centroids_, self.counts_, self.n_seen_ = _pygauss.minibatch_kmeans_update(
+            X, self.k, self.centroids_, self.counts_, self.n_seen_, self.engine)
+        return labels
+
+    def fit(self, X: Union[ArrayLike, Iterable[ArrayLike]], epochs: int = 1):
+        """
+        Updates the model with all the series in X
+
+        Parameters
+        ----------
+        X: ArrayLike or an iterable of ArrayLike
+            Either a columnar matrix, which is consumed in chunks of ``batch_size`` series, 
+            or an iterable (for example, a generator) producing columnar chunks.
+
+        epochs: int (default: 1)
+            Number of passes over X when it is a matrix.
+        """
+        if hasattr(X, 'shape'):
+            columns = X.shape[1] if len(X.shape) > 1 else 1
+            for _ in range(epochs):
+                for start in range(0, columns, self.batch_size):
+                    self.partial_fit(X[:, start:start + self.batch_size])
+        else:
+            for chunk in X:
+                self.partial_fit(chunk)
+
+    def predict(self, X: ArrayLike) -> ShapeletsArray:
+        """
+        Predict the closest cluster each time series in X belongs to.
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+
+        Returns
+        -------
+        ShapeletsArray
+            A columnar array, Mx1, indicating the closest cluster to each series in X.
+        """
+        if self.centroids_ is None:
+            raise ValueError("No centroids available for prediction")
+
+        return _pygauss.kmeans_classify(X, self.centroids_)
+
+
+class DBSCAN():
+    """
+    Density based clustering (DBSCAN) [1]_.
+
+    Series with at least ``min_samples`` series (themselves included) within a radius 
+    ``eps`` are core series; clusters are groups of core series reachable from each other 
+    through their neighbourhoods, plus the series in the neighbourhood of those core 
+    series.  The remaining series are labelled as noise.
+
+    The neighbourhoods are found with a :obj:`~shapelets.compute.distances.MetricIndex` 
+    when the metric satisfies the triangle inequality, or by computing the distances in 
+    blocks otherwise, so the full distance matrix is never held in memory.
+
+    Parameters
+    ----------
+    eps: float
+        Radius of the neighbourhoods.
+
+    min_samples: int (default: 5)
+        Number of series in the neighbourhood of a core series, including itself.
+
+    metric: DistanceType (default: 'euclidean')
+        Distance between time series.
+
+    **kwargs:
+        Parameters of the metric, for example, ``w`` for ``mpdist``.
+
+    Attributes
+    ----------
+    labels_: ShapeletsArray
+        Cluster of every series, or -1 for noise.
+
+    core_: ShapeletsArray
+        Boolean mask flagging the core series.
+
+    References
+    ----------
+    .. [1] | `A density-based algorithm for discovering clusters in large spatial databases with noise. 
+             <https://dl.acm.org/doi/10.5555/3001460.3001507>`_
+           | Martin Ester, Hans-Peter Kriegel, Jörg Sander and Xiaowei Xu. 1996.
+           | Proceedings of the Second International Conference on Knowledge Discovery and Data Mining, 226–231.
+
+    """
+
+    def __init__(self, eps: float, min_samples: int = 5, metric: str = 'euclidean', **kwargs) -> None:
+        """
+        Creates a new instance
+        """
+        self.eps = eps
+        self.min_samples = min_samples
+        self.metric = metric
+        self.kwargs = kwargs
+        self.labels_ = None
+        self.core_ = None
+
+    def fit(self, X: ArrayLike):
+        """
+        Computes the clusters of a set of time series
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+        """
+        self.labels_, self.core_ = _pygauss.dbscan(X, self.eps, self.min_samples,
+                                                   _distances._convert_dst_type(self.metric), **self.kwargs)
+
+    def fit_predict(self, X: ArrayLike) -> ShapeletsArray:
+        """
+        Computes the clusters of a set of time series and returns their labels
+        """
+        self.fit(X)
+        return self.labels_
+
+
+class HDBSCAN():
+    """
+    Hierarchical density based clustering (HDBSCAN) [1]_.
+
+    Builds the hierarchy of density based clusters from the minimum spanning tree of the 
+    mutual reachability distances and keeps the most stable clusters, so, unlike 
+    :obj:`DBSCAN`, no radius has to be chosen and clusters of varying density are found.
+
+    Parameters
+    ----------
+    min_cluster_size: int (default: 5)
+        Smallest number of series considered a cluster.
+
+    min_samples: int (default: None)
+        Number of neighbours, including the series itself, that defines the core distance 
+        of a series.  Defaults to ``min_cluster_size``.
+
+    metric: DistanceType (default: 'euclidean')
+        Distance between time series, which must be symmetric.
+
+    **kwargs:
+        Parameters of the metric, for example, ``w`` for ``mpdist``.
+
+    Attributes
+    ----------
+    labels_: ShapeletsArray
+        Cluster of every series, or -1 for noise.
+
+    References
+    ----------
+    .. [1] | `Density-based clustering based on hierarchical density estimates. 
+             <https://doi.org/10.1007/978-3-642-37456-2_14>`_
+           | Ricardo J. G. B. Campello, Davoud Moulavi and Joerg Sander. 2013.
+           | Advances in Knowledge Discovery and Data Mining, 160–172.
+
+    """
+
+    def __init__(self, min_cluster_size: int = 5, min_samples: Optional[int] = None, metric: str = 'euclidean',
+                 **kwargs) -> None:
+        """
+        Creates a new instance
+        """
+        self.min_cluster_size = min_cluster_size
+        self.min_samples = min_samples
+        self.metric = metric
+        self.kwargs = kwargs
+        self.labels_ = None
+
+    def fit(self, X: ArrayLike):
+        """
+        Computes the clusters of a set of time series
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+        """
+        min_samples = self.min_cluster_size if self.min_samples is None else self.min_samples
+        self.labels_ = _pygauss.hdbscan(X, self.min_cluster_size, min_samples,
+                                        _distances._convert_dst_type(self.metric), **self.kwargs)
+
+    def fit_predict(self, X: ArrayLike) -> ShapeletsArray:
+        """
+        Computes the clusters of a set of time series and returns their labels
+        """
+        self.fit(X)
+        return self.labels_
+
+
+class KMedoids():
+    """
+    K-Medoids clustering.
+
+    Implementation of FasterPAM [1]_, which works with arbitrary dissimilarities, like 
+    ``dtw``, ``sbd`` or ``mpdist``, and chooses actual series as the representatives 
+    (medoids) of the clusters.
+
+    Parameters
+    ----------
+    k: int
+        Number of clusters.
+
+    metric: DistanceType or 'precomputed' (default: 'euclidean')
+        When set to ``precomputed``, ``fit`` expects either the square matrix returned 
+        by :obj:`~shapelets.compute.distances.pdist` or its condensed form (the entries 
+        above the diagonal, row by row).  Otherwise, the distances are computed on 
+        demand and only ``cache_rows`` rows of the distance matrix are kept in memory.
+
+    max_iterations: int (default: 100)
+        Maximum number of passes over the swap candidates.
+
+    seed: int (default: 0)
+        Seed used to draw the initial medoids.
+
+    cache_rows: int (default: 4096)
+        Number of rows of distances kept in memory when the metric is not precomputed.
+
+    **kwargs:
+        Parameters of the metric, for example, ``w`` for ``mpdist``.
+
+    Attributes
+    ----------
+    labels_: ShapeletsArray
+        Position, in ``medoids_``, of the closest medoid of every series.
+
+    medoids_: ShapeletsArray
+        Column indices of the medoids in the training set.
+
+    References
+    ----------
+    .. [1] | `Fast and eager k-medoids clustering: O(k) runtime improvement of the PAM, CLARA, and CLARANS 
+             algorithms. <https://doi.org/10.1016/j.is.2021.101804>`_
+           | Erich Schubert and Peter J. Rousseeuw. 2021.
+           | Information Systems, 101, 101804.
+
+    """
+
+    def __init__(self, k: int, metric: str = 'euclidean', max_iterations: int = 100, seed: int = 0,
+                 cache_rows: int = 4096, **kwargs) -> None:
+        """
+        Creates a new instance
+        """
+        if (k <= 0):
+            raise ValueError("The number of clusters must be a integer greater than 0")
+
+        self.k = k
+        self.metric = metric
+        self.max_iterations = max_iterations
+        self.seed = seed
+        self.cache_rows = cache_rows
+        self.kwargs = kwargs
+        self.labels_ = None
+        self.medoids_ = None
+        self.medoid_series_ = None
+
+    def fit(self, X: ArrayLike, medoids: Optional[ArrayLike] = None):
+        """
+        Computes the medoids and implied labels from a training set
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations or, when the 
+            metric is ``precomputed``, their distances.
+
+        medoids: ArrayLike (default: None)
+            Column indices of the initial medoids; drawn at random when not set.
+        """
+        if self.metric == 'precomputed':
+            result = _pygauss.kmedoids_precomputed(X, self.k, medoids, self.max_iterations, self.seed)
+            self.medoid_series_ = None
+        else:
+            result = _pygauss.kmedoids(X, self.k, _distances._convert_dst_type(self.metric), medoids,
+                                       self.max_iterations, self.seed, self.cache_rows, **self.kwargs)
+            self.medoid_series_ = X[:, result[1]]
+
+        self.labels_ = result[0]
+        self.medoids_ = result[1]
+
+    def fit_predict(self, X: ArrayLike, medoids: Optional[ArrayLike] = None) -> ShapeletsArray:
+        """
+        Computes the medoids from a training set and returns the implied labels
+        """
+        self.fit(X, medoids)
+        return self.labels_
+
+    def predict(self, X: ArrayLike) -> ShapeletsArray:
+        """
+        Predict the closest medoid each time series in X belongs to.
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+
+        Returns
+        -------
+        ShapeletsArray
+            A columnar array, Mx1, indicating the closest medoid to each series in X.
+        """
+        if self.medoid_series_ is None:
+            raise ValueError("No medoid series available for prediction")
+
+        _, idx = _distances.knn(X, self.medoid_series_, 1, self.metric, **self.kwargs)
+        return idx
 
 
 class KShape():
@@ -32,6 +662,15 @@ class KShape():
     max_iterations: int (default: 100)
         Maximum number of iterations.
 
+    n_init: int (default: 1)
+        Number of random labelings to start from when no labels are given.  The restarts 
+        run concurrently, sharing the normalised series and their spectra, and the one 
+        with the lowest inertia is kept.
+
+    seed: int (default: 0)
+        Seed of the first restart when ``n_init`` is greater than one; restart ``r`` uses 
+        ``seed + r``, so results are reproducible.
+
     Attributes
     ----------
     labels_: ShapeletsArray
@@ -40,6 +679,10 @@ class KShape():
     centroids_: ShapeletsArray
         Computed centroids implied from the training set.
 
+    inertia_: float
+        Sum of shape based distances of the series to their centroids, when fitted with 
+        ``n_init`` greater than one.
+
     Notes
     -----
     Time series are expected in columnar layout, that is, if presented with a NxM matrix, data 
@@ -58,7 +701,8 @@ class KShape():
 
     """
 
-    def __init__(self, k: int, rnd_labels: bool = False, max_iterations: int = 100) -> None:
+    def __init__(self, k: int, rnd_labels: bool = False, max_iterations: int = 100, n_init: int = 1,
+                 seed: int = 0) -> None:
         """
         Creates a new instace
         """
@@ -68,8 +712,11 @@ class KShape():
         self.k = k
         self.max_iterations = max_iterations
         self.rnd_labels = rnd_labels
+        self.n_init = n_init
+        self.seed = seed
         self.labels_ = None
         self.centroids_ = None
+        self.inertia_ = None
 
     def fit(self, X: ArrayLike, labels: Optional[ArrayLike] = None):
         """
@@ -91,7 +738,13 @@ class KShape():
         Once this method is invoked, centroids will be computed and stored in ``centroids_``
 
         """
-        result = _pygauss.kshape_calibrate(X, self.k, labels, self.max_iterations, self.rnd_labels)
+        if labels is None and self.n_init > 1:
+            result = _pygauss.kshape_restarts(X, self.k, self.n_init, self.seed, self.max_iterations)
+            self.inertia_ = result[2]
+        else:
+            result = _pygauss.kshape_calibrate(X, self.k, labels, self.max_iterations, self.rnd_labels)
+            self.inertia_ = None
+
         self.labels_ = result[0]
         self.centroids_ = result[1]
 
@@ -134,6 +787,86 @@ class KShape():
 
         return _pygauss.kshape_classify(X, self.centroids_)
 
+    def compile(self, batch_size: int = 64) -> KShapeClassifier:
+        """
+        Builds a :obj:`KShapeClassifier` over the fitted centroids, suited to score 
+        small batches of new series with low latency.
+
+        Parameters
+        ----------
+        batch_size: int (default: 64)
+            Number of series scored together.
+        """
+        if self.centroids_ is None:
+            raise ValueError("The model has not been fitted")
+
+        return KShapeClassifier(self.centroids_, batch_size)
+
+
+class KShapeClassifier():
+    """
+    Classifier for fixed k-shape centroids.
+
+    The spectra and norms of the centroids are computed once, when the classifier is 
+    built, and new series are scored in batches of a fixed size, so repeated calls reuse 
+    the same device buffers and compiled kernels.  This makes it suitable for online 
+    scoring, where small batches of series are classified against the same centroids.
+
+    Parameters
+    ----------
+    centroids: ArrayLike
+        Columnar matrix with the (znorm) centroids, as found in ``KShape.centroids_``.
+
+    batch_size: int (default: 64)
+        Number of series scored together; the last batch of a call is padded.
+
+    Examples
+    --------
+    >>> import shapelets.compute as sc
+    >>> ks = sc.clustering.KShape(4, n_init=5)
+    >>> ks.fit(training)
+    >>> classifier = ks.compile()
+    >>> labels = classifier.predict(window)
+    """
+
+    def __init__(self, centroids: ArrayLike, batch_size: int = 64) -> None:
+        self._classifier = _pygauss.KShapeClassifier(centroids, batch_size)
+
+    @property
+    def batch_size(self) -> int:
+        """
+        Number of series scored together
+        """
+        return self._classifier.batch_size
+
+    def predict(self, X: ArrayLike) -> ShapeletsArray:
+        """
+        Finds the closest centroid to each series in X.
+
+        Parameters
+        ----------
+        X: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+
+        Returns
+        -------
+        ShapeletsArray
+            A columnar array, Mx1, with the label of each series.
+        """
+        return self._classifier.classify(X)[0]
+
+    def score(self, X: ArrayLike) -> Tuple[ShapeletsArray, ShapeletsArray]:
+        """
+        Finds the closest centroid to each series in X and the normalised cross correlation 
+        to it.
+
+        Returns
+        -------
+        Tuple[ShapeletsArray, ShapeletsArray]
+            Two Mx1 columnar arrays, with the labels and the correlations.
+        """
+        return self._classifier.classify(X)
+
     def plot_centroids(self, title: Optional[str] = None, txt_legend: Optional[ArrayLike] = None):
         """
         Utility method to render centroids
@@ -5,7 +5,7 @@
 # this project, or at http://mozilla.org/MPL/2.0/.
 
 from __future__ import annotations
-from typing import Optional
+from typing import Optional, Tuple
 
 try:
     from typing import Literal
@@ -25,13 +25,13 @@ from . import _pygauss
 
 DistanceType = Literal['additive_symm_chi', 'avg_l1_linf', 'bhattacharyya', 'canberra',
                        'chebyshev', 'clark', 'cosine', 'czekanowski', 'dice', 'divergence',
-                       'dtw', 'euclidean', 'fidelity', 'gower', 'hamming', 'harmonic_mean', 'hellinger',
+                       'ddtw', 'dtw', 'erp', 'euclidean', 'fidelity', 'gower', 'hamming', 'harmonic_mean', 'hellinger',
                        'innerproduct', ' intersection', 'jaccard', 'jeffrey', 'jensen_difference', 'jensen_shannon',
-                       'k_divergence', 'kulczynski', 'kullback', 'kumar_johnson', 'kumar_hassebrook', 'lorentzian',
-                       'manhattan', 'matusita', 'minkowski', 'mpdist',
+                       'k_divergence', 'kulczynski', 'kullback', 'kumar_johnson', 'kumar_hassebrook', 'lcss', 'lorentzian',
+                       'manhattan', 'matusita', 'minkowski', 'mpdist', 'msm',
                        'neyman', 'pearson', 'prob_symmetric_chi', 'sbd', 'soergel', 'sorensen', 'square_chord',
                        'squared_chi', 'squared_euclidean', 'taneja', 'topsoe', 'wave_hedges',
-                       'ruzicka', 'motyka', 'tanimoto']
+                       'ruzicka', 'motyka', 'tanimoto', 'twe', 'wdtw']
 
 __dst_map = {
     'additive_symm_chi': _pygauss.DistanceType.Additive_Symm_Chi,
@@ -44,7 +44,9 @@ __dst_map = {
     'czekanowski': _pygauss.DistanceType.Czekanowski,
     'dice': _pygauss.DistanceType.Dice,
     'divergence': _pygauss.DistanceType.Divergence,
+    'ddtw': _pygauss.DistanceType.DDTW,
     'dtw': _pygauss.DistanceType.DTW,
+    'erp': _pygauss.DistanceType.ERP,
     'euclidean': _pygauss.DistanceType.Euclidean,
     'fidelity': _pygauss.DistanceType.Fidelity,
     'gower': _pygauss.DistanceType.Gower,
@@ -62,11 +64,13 @@ __dst_map = {
     'kullback': _pygauss.DistanceType.Kullback,
     'kumar_johnson': _pygauss.DistanceType.Kumar_Johnson,
     'kumar_hassebrook': _pygauss.DistanceType.Kumar_Hassebrook,
+    'lcss': _pygauss.DistanceType.LCSS,
     'lorentzian': _pygauss.DistanceType.Lorentzian,
     'manhattan': _pygauss.DistanceType.Manhattan,
     'matusita': _pygauss.DistanceType.Matusita,
     'minkowski': _pygauss.DistanceType.Minkowski,
     'mpdist': _pygauss.DistanceType.MPDist,
+    'msm': _pygauss.DistanceType.MSM,
     'neyman': _pygauss.DistanceType.Neyman,
     'pearson': _pygauss.DistanceType.Pearson,
     'prob_symmetric_chi': _pygauss.DistanceType.Prob_Symmetric_Chi,
@@ -81,7 +85,9 @@ __dst_map = {
     'wave_hedges': _pygauss.DistanceType.Wave_Hedges,
     'ruzicka': _pygauss.DistanceType.Ruzicka,
     'motyka': _pygauss.DistanceType.Motyka,
-    'tanimoto': _pygauss.DistanceType.Tanimoto
+    'tanimoto': _pygauss.DistanceType.Tanimoto,
+    'twe': _pygauss.DistanceType.TWE,
+    'wdtw': _pygauss.DistanceType.WDTW
 }
 
 
@@ -91,6 +97,10 @@ def __convert_dst_type(type: DistanceType):
     raise ValueError("Unknown distance type")
 
 
+# Alias that is not subject to name mangling within class bodies
+_convert_dst_type = __convert_dst_type
+
+
 # TODO: This construct is possible; one can send it through kwargs
 #       and get it executed directly from the c++ side.
 # class CustomDistanceFn(TypedDict):
@@ -221,6 +231,150 @@ def cdist(xa: ArrayLike, xb: ArrayLike, metric: DistanceType, **kwargs) -> Shape
     return _pygauss.cdist(xa, xb, __convert_dst_type(metric), **kwargs)
 
 
+def knn(xa: ArrayLike, xb: ArrayLike, k: int, metric: DistanceType, block_size: int = 1024,
+        **kwargs) -> Tuple[ShapeletsArray, ShapeletsArray]:
+    """
+    Finds the k nearest column vectors in xb for every column vector in xa.
+
+    The result is equivalent to sorting every row of :obj:`~shapelets.compute.distances.cdist` 
+    and keeping the first k entries, but the full (AxB) matrix is never materialized: 
+    xb is processed in blocks of ``block_size`` columns and only the best k candidates 
+    per row are kept between blocks.
+
+    Parameters
+    ----------
+    xa: 2-D matrix, nxA
+        A column vectors of length n.
+    
+    xb: 2-D matrix, mxB
+        B column vectors of length m.
+
+    k: int
+        Number of neighbours to return; it must be in the range [1, B].
+
+    metric: DistanceType
+        Selects the distance or similarity function to run. 
+
+    block_size: int (default: 1024)
+        Number of columns of xb processed at once.  
+
+    Returns
+    -------
+    Tuple[ShapeletsArray, ShapeletsArray]
+        Two new 2-D matrices (Axk); the first one contains the distances, sorted in 
+        ascending order for each row, and the second one the indices of the 
+        corresponding columns in xb.
+
+    Examples
+    --------
+    >>> import shapelets.compute as sc
+    >>> a = sc.array([[0, 0, 1], [0, 1, 0], [1, 0, 0]], dtype="float32")
+    >>> b = sc.array([
+    ...     [0, 0, 0, 0, 1, 1, 1, 1], 
+    ...     [0, 0, 1, 1, 0, 0, 1, 1], 
+    ...     [0, 1, 0, 1, 0, 1, 0, 1]], dtype="float32")
+    >>> d, i = sc.distances.knn(a, b, 2, 'manhattan', block_size=3)
+    >>> d.display()
+    [3 2 1 1]
+        0.0000     1.0000 
+        0.0000     1.0000 
+        0.0000     1.0000 
+    """
+    return _pygauss.cdist_knn(xa, xb, k, __convert_dst_type(metric), block_size, **kwargs)
+
+
+class MetricIndex:
+    """
+    Vantage point tree index for nearest neighbour and range queries.
+
+    The index organizes the column vectors of a library of time series so that 
+    queries only need to evaluate a fraction of the distances that a full 
+    :obj:`~shapelets.compute.distances.cdist` would require.  It is only available 
+    for metrics, that is, distances that fulfil the triangle inequality: 
+    ``euclidean``, ``manhattan``, ``chebyshev``, ``minkowski`` (with p >= 1), 
+    ``gower``, ``avg_l1_linf`` and ``hamming``.
+
+    Parameters
+    ----------
+    data: 2-D matrix, nxM
+        M column vectors of length n to be indexed.
+
+    metric: DistanceType
+        Selects the distance function.
+
+    leaf_size: int (default: 64)
+        Maximum number of columns evaluated together at the leaves of the tree.
+
+    seed: int (default: 0)
+        Seed used to select the vantage points.
+
+    Notes
+    -----
+    Queries with multiple columns are resolved concurrently.
+
+    References
+    ----------
+    | [1] **Data structures and algorithms for nearest neighbor search in general metric spaces**
+    |     Yianilos P.N.
+    |     Proceedings of the fourth annual ACM-SIAM Symposium on Discrete algorithms. 1993.
+    """
+
+    def __init__(self, data: ArrayLike, metric: DistanceType, leaf_size: int = 64, seed: int = 0, **kwargs) -> None:
+        self._data = data
+        self._metric = metric
+        self._kwargs = kwargs
+        self._index = _pygauss.MetricIndex(data, _convert_dst_type(metric), leaf_size, seed, **kwargs)
+
+    @property
+    def size(self) -> int:
+        """
+        Number of indexed time series
+        """
+        return self._index.size
+
+    def knn(self, queries: ArrayLike, k: int) -> Tuple[ShapeletsArray, ShapeletsArray]:
+        """
+        Finds the k nearest indexed columns for every column in queries.
+
+        Returns
+        -------
+        Tuple[ShapeletsArray, ShapeletsArray]
+            Two matrices (Qxk) with the distances, in ascending order per row, and the 
+            indices of the matching columns.
+        """
+        return self._index.knn(queries, k)
+
+    def range(self, queries: ArrayLike, radius: float) -> Tuple[ShapeletsArray, ShapeletsArray, ShapeletsArray]:
+        """
+        Finds all the indexed columns within ``radius`` of every column in queries.
+
+        Returns
+        -------
+        Tuple[ShapeletsArray, ShapeletsArray, ShapeletsArray]
+            Distances and indices of all matches, plus a vector of Q+1 offsets such 
+            as the matches of the i-th query are found in ``[offsets[i], offsets[i+1])``.
+        """
+        return self._index.range(queries, radius)
+
+    def to_bytes(self) -> bytes:
+        """
+        Serializes the structure of the index.  The indexed data is not included.
+        """
+        return self._index.to_bytes()
+
+    @classmethod
+    def from_bytes(cls, state: bytes, data: ArrayLike, metric: DistanceType, **kwargs) -> MetricIndex:
+        """
+        Restores an index serialized with ``to_bytes`` over the same data and metric.
+        """
+        result = cls.__new__(cls)
+        result._data = data
+        result._metric = metric
+        result._kwargs = kwargs
+        result._index = _pygauss.MetricIndex.from_bytes(state, data, _convert_dst_type(metric), **kwargs)
+        return result
+
+
 def euclidean(a: ArrayLike, b: ArrayLike) -> ShapeletsArray:
     r"""
     Compute euclidian distance between each pair of the two collections of inputs.
@@ -1922,8 +2076,10 @@ def mpdist(a: ArrayLike, b: ArrayLike, w: int, threshold: float = 0.05) -> Shape
     common outside of benchmark datasets.
 
     This function will compute the MPDist distance for every column vector 
-    in xa against all column vectors in xb.  If the length of the column vectors is 
-    not the same, the smaller vectors will be padded with zeros.
+    in xa against all column vectors in xb, which may have different lengths.  
+    The subsequence statistics of every series are computed only once and the 
+    distances between subsequences are evaluated, in batches of columns, as a 
+    single matrix product.
 
     Parameters
     ----------
@@ -1950,11 +2106,134 @@ def mpdist(a: ArrayLike, b: ArrayLike, w: int, threshold: float = 0.05) -> Shape
     return _pygauss.cdist(a, b, _pygauss.DistanceType.MPDist, w=w, threshold=threshold)
 
 
-def dtw(a: ArrayLike, b: ArrayLike) -> ShapeletsArray:
+def dtw(a: ArrayLike, b: ArrayLike, window: float = 1.0, cutoff: float = float('inf')) -> ShapeletsArray:
     r"""
     Calculates the Dynamic Time Warping Distance.
+
+    Parameters
+    ----------
+    a: 2-D matrix, nxA
+        A column vectors of length n.
+    
+    b: 2-D matrix, mxB
+        B column vectors of length m.
+
+    window: float (default: 1.0)
+        Width of the Sakoe-Chiba band, as a fraction of the length of the longest 
+        series.  The default value leaves the warping path unconstrained.
+
+    cutoff: float (default: inf)
+        Early abandoning threshold; pairs whose distance is known to be greater 
+        than this value are reported as ``inf``.
+
+    Notes
+    -----
+    All elastic distances (``dtw``, ``ddtw``, ``wdtw``, ``erp``, ``lcss``, ``msm`` and 
+    ``twe``) share the same dynamic programming core, which keeps two rows of the cost 
+    matrix per pair and runs pairs concurrently on the host threads.
+    """
+    return _pygauss.cdist(a, b, _pygauss.DistanceType.DTW, window=window, cutoff=cutoff)
+
+
+def ddtw(a: ArrayLike, b: ArrayLike, window: float = 1.0, cutoff: float = float('inf')) -> ShapeletsArray:
+    r"""
+    Calculates the Derivative Dynamic Time Warping Distance.
+
+    It runs :obj:`~shapelets.compute.distances.dtw` over an estimate of the first derivative 
+    of the series, so the alignment follows the shape rather than the values.
+
+    References
+    ----------
+    | [1] **Derivative Dynamic Time Warping**
+    |     Keogh E.J., Pazzani M.J.
+    |     Proceedings of the 2001 SIAM International Conference on Data Mining. 2001.
+    """
+    return _pygauss.cdist(a, b, _pygauss.DistanceType.DDTW, window=window, cutoff=cutoff)
+
+
+def wdtw(a: ArrayLike, b: ArrayLike, g: float = 0.05, window: float = 1.0,
+         cutoff: float = float('inf')) -> ShapeletsArray:
+    r"""
+    Calculates the Weighted Dynamic Time Warping Distance.
+
+    Each squared difference is weighted by a logistic function of the phase difference 
+    between the points, whose steepness is controlled by ``g``.
+
+    References
+    ----------
+    | [1] **Weighted dynamic time warping for time series classification**
+    |     Jeong Y.S., Jeong M.K., Omitaomu O.A.
+    |     Pattern Recognition, 44, 9. 2011.
+    """
+    return _pygauss.cdist(a, b, _pygauss.DistanceType.WDTW, g=g, window=window, cutoff=cutoff)
+
+
+def erp(a: ArrayLike, b: ArrayLike, g: float = 0.0, window: float = 1.0,
+        cutoff: float = float('inf')) -> ShapeletsArray:
+    r"""
+    Calculates the Edit Distance with Real Penalty (ERP).
+
+    Gaps are penalized by the distance of the skipped point to the constant ``g``.  When 
+    the warping path is unconstrained, ERP is a metric.
+
+    References
+    ----------
+    | [1] **On the marriage of Lp-norms and edit distance**
+    |     Chen L., Ng R.
+    |     Proceedings of the 30th VLDB Conference. 2004.
+    """
+    return _pygauss.cdist(a, b, _pygauss.DistanceType.ERP, g=g, window=window, cutoff=cutoff)
+
+
+def lcss(a: ArrayLike, b: ArrayLike, epsilon: float, window: float = 1.0) -> ShapeletsArray:
+    r"""
+    Calculates the Longest Common Subsequence distance (LCSS).
+
+    Two points match when their absolute difference is less or equal to ``epsilon``; the 
+    distance is one minus the length of the longest common subsequence divided by the 
+    length of the shortest series.
+
+    References
+    ----------
+    | [1] **Discovering similar multidimensional trajectories**
+    |     Vlachos M., Kollios G., Gunopulos D.
+    |     Proceedings 18th International Conference on Data Engineering. 2002.
+    """
+    return _pygauss.cdist(a, b, _pygauss.DistanceType.LCSS, epsilon=epsilon, window=window)
+
+
+def msm(a: ArrayLike, b: ArrayLike, c: float = 1.0, window: float = 1.0,
+        cutoff: float = float('inf')) -> ShapeletsArray:
+    r"""
+    Calculates the Move-Split-Merge distance (MSM).
+
+    ``c`` is the constant cost of the split and merge operations.  When the warping path 
+    is unconstrained, MSM is a metric.
+
+    References
+    ----------
+    | [1] **The Move-Split-Merge Metric for Time Series**
+    |     Stefan A., Athitsos V., Das G.
+    |     IEEE Transactions on Knowledge and Data Engineering, 25, 6. 2013.
+    """
+    return _pygauss.cdist(a, b, _pygauss.DistanceType.MSM, c=c, window=window, cutoff=cutoff)
+
+
+def twe(a: ArrayLike, b: ArrayLike, nu: float = 0.001, lambda_: float = 1.0, window: float = 1.0,
+        cutoff: float = float('inf')) -> ShapeletsArray:
+    r"""
+    Calculates the Time Warp Edit distance (TWE).
+
+    ``nu`` controls the stiffness of the warping and ``lambda_``, the lambda of the paper, 
+    the constant penalty of deletions.  When the warping path is unconstrained, TWE is a metric.
+
+    References
+    ----------
+    | [1] **Time Warp Edit Distance with Stiffness Adjustment for Time Series Matching**
+    |     Marteau P.F.
+    |     IEEE Transactions on Pattern Analysis and Machine Intelligence, 31, 2. 2009.
     """
-    return _pygauss.cdist(a, b, _pygauss.DistanceType.DTW)
+    return _pygauss.cdist(a, b, _pygauss.DistanceType.TWE, nu=nu, lambda_=lambda_, window=window, cutoff=cutoff)
 
 
 def sbd(a: ArrayLike, b: ArrayLike) -> ShapeletsArray:
@@ -1963,6 +2242,11 @@ def sbd(a: ArrayLike, b: ArrayLike) -> ShapeletsArray:
     
     It computes the normalized cross-correlation and it returns 1.0 minus the value 
     that maximizes the correlation value between each pair of time series.
+
+    Cross correlations are evaluated in the frequency domain: every series is transformed 
+    only once, with zero padding up to an efficient transform length, and the products of 
+    the spectra are brought back to the time domain in large batches.  Series in ``a`` and 
+    ``b`` may have different lengths.
     """
     return _pygauss.cdist(a, b, _pygauss.DistanceType.SBD)
 
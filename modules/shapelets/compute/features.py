@@ -0,0 +1,150 @@
+# Copyright (c) 2021 Grumpy Cat Software S.L.
+#
+# This Source Code is licensed under the MIT 2.0 license.
+# the terms can be found in  LICENSE.md at the root of
+# this project, or at http://mozilla.org/MPL/2.0/.
+
+from __future__ import annotations
+from typing import Iterable, Sequence, Tuple, Union
+
+from .__basic_typing import ArrayLike
+from ._array_obj import ShapeletsArray
+
+from . import _pygauss
+
+Feature = _pygauss.Feature
+
+FeatureLike = Union[Feature, str]
+
+
+def __convert_feature(feature: FeatureLike) -> Feature:
+    if isinstance(feature, Feature):
+        return feature
+    name = "".join(w.capitalize() for w in str(feature).split('_'))
+    if name not in Feature.__members__:
+        raise ValueError("Unknown feature " + str(feature))
+    return Feature.__members__[name]
+
+
+_convert_feature = __convert_feature
+
+
+def feature(tss: ArrayLike, feature: FeatureLike, params: Sequence[float] = ()) -> ShapeletsArray:
+    """
+    Computes a single feature of a set of time series.
+
+    The value is computed straight from the function implementing the feature, without
+    sharing any intermediate result; it is the reference of the values returned by
+    :obj:`FeatureSet`.
+
+    Parameters
+    ----------
+    tss: ArrayLike
+        Columnar matrix, NxM, representing M timeseries with N observations.
+
+    feature: Feature or str
+        Feature to compute, either as a member of :obj:`Feature` or by its name in snake
+        case (``abs_energy``, ``energy_ratio_by_chunks``...).
+
+    params: Sequence[float] (default: ())
+        Parameters of the feature, if any.
+
+    Returns
+    -------
+    ShapeletsArray
+        A 1xM row with the value of the feature for each series.
+    """
+    return _pygauss.compute_feature(tss, __convert_feature(feature), [float(p) for p in params])
+
+
+def rolling(tss: ArrayLike, window: int, features: Sequence[FeatureLike], step: int = 1) -> ShapeletsArray:
+    """
+    Computes features over sliding windows of a set of time series.
+
+    Windows are never materialised: they are visited in order and the features are
+    updated as values enter and leave them.  Only the following features are supported:
+    ``abs_energy``, ``count_above_mean``, ``count_below_mean``, the first and last
+    locations of the maximum and minimum, ``kurtosis``, ``longest_strike_above_mean``,
+    ``longest_strike_below_mean``, ``maximum``, ``mean``, ``minimum``, ``skewness``,
+    ``standard_deviation``, ``sum_values`` and ``variance``.
+
+    Parameters
+    ----------
+    tss: ArrayLike
+        Columnar matrix, NxM, representing M timeseries with N observations.
+
+    window: int
+        Length of the windows.
+
+    features: Sequence
+        Features to compute, as :obj:`Feature` members or their names in snake case.
+
+    step: int (default: 1)
+        Distance between the starts of consecutive windows.
+
+    Returns
+    -------
+    ShapeletsArray
+        A (windows, features, M) array, where the i-th window of each series starts at
+        position ``i * step``.
+    """
+    return _pygauss.rolling_features(tss, window, step, [__convert_feature(f) for f in features])
+
+
+class FeatureSet():
+    """
+    Computes a list of features over many time series in one go.
+
+    Intermediate results shared by several features (the mean, the variance, a sorted
+    copy of the series, the spectrum...) are computed only once and released as soon as
+    no other feature needs them.  Series are processed in blocks of columns, which bounds
+    the memory required regardless of the number of series.
+
+    Parameters
+    ----------
+    specs: Iterable
+        Features to compute, either as bare features (:obj:`Feature` members or their names
+        in snake case) or as ``(feature, params)`` tuples for those that take parameters.
+
+    Examples
+    --------
+    >>> import shapelets.compute as sc
+    >>> fs = sc.features.FeatureSet(['mean', ('energy_ratio_by_chunks', (4, 1))])
+    >>> values = fs.compute(sc.random.randn((100, 10)))
+    >>> values.shape
+    (2, 10)
+    """
+
+    def __init__(self, specs: Iterable[Union[FeatureLike, Tuple[FeatureLike, Sequence[float]]]]):
+        parsed = []
+        for spec in specs:
+            if isinstance(spec, tuple):
+                f, params = spec
+            else:
+                f, params = spec, ()
+            parsed.append((_convert_feature(f), [float(p) for p in params]))
+        self.__set = _pygauss.FeatureSet(parsed)
+
+    def __len__(self) -> int:
+        return len(self.__set)
+
+    def compute(self, tss: ArrayLike, block_size: int = 1024) -> ShapeletsArray:
+        """
+        Computes all the features.
+
+        Parameters
+        ----------
+        tss: ArrayLike
+            Columnar matrix, NxM, representing M timeseries with N observations.
+
+        block_size: int (default: 1024)
+            Maximum number of series evaluated at once.
+
+        Returns
+        -------
+        ShapeletsArray
+            A matrix with one row per feature, in the order given when the set was built,
+            and one column per series.
+        """
+        return self.__set.compute(tss, block_size)
+
@@ -18,6 +18,8 @@ from .__basic_typing import ArrayLike, ShapeLike
 from . import _pygauss
 
 NormType = Literal['backward', 'ortho', 'forward']
+WaveletType = Literal['ricker', 'morlet']
+WindowType = Literal['hann', 'hamming', 'boxcar']
 
 
 def __convertNorm(norm=None):
@@ -31,6 +33,26 @@ def __convertNorm(norm=None):
         return float(norm)
 
 
+def __convertWavelet(wavelet):
+    if wavelet == 'ricker':
+        return _pygauss.Wavelet.Ricker
+    elif wavelet == 'morlet':
+        return _pygauss.Wavelet.Morlet
+    else:
+        raise ValueError(f"Unknown wavelet {wavelet}")
+
+
+def __convertWindow(window):
+    if window == 'hann':
+        return _pygauss.SpectralWindow.Hann
+    elif window == 'hamming':
+        return _pygauss.SpectralWindow.Hamming
+    elif window == 'boxcar':
+        return _pygauss.SpectralWindow.Boxcar
+    else:
+        raise ValueError(f"Unknown window {window}")
+
+
 def ifft(c: ArrayLike, shape: Optional[ShapeLike] = None,
          norm: Optional[Union[NormType, float]] = None) -> ShapeletsArray:
     r"""
@@ -342,6 +364,87 @@ def fftshift(x: ArrayLike, axes: Optional[Union[int, List[int]]] = None) -> Shap
     return _pygauss.fftshift(x, axes)
 
 
+def cwt(signal: ArrayLike, widths: ArrayLike, wavelet: WaveletType = 'ricker', omega0: float = 5.0) -> ShapeletsArray:
+    r"""
+    Continuous wavelet transform.
+
+    All the widths and signals are transformed at once, with a single batched product in the frequency domain.
+
+    Parameters
+    ----------
+    signal: ArrayLike
+        Column vector or matrix whose columns are the signals, all of the same length.
+
+    widths: ArrayLike
+        Widths (scales) of the wavelet, all of them greater than zero.
+
+    wavelet: WaveletType, defaults to 'ricker'
+        Mother wavelet: 'ricker' (mexican hat) or 'morlet'; the latter is the complex Morlet wavelet, normalised
+        to have the same energy at every width.
+
+    omega0: float, defaults to 5.0
+        Central frequency of the Morlet wavelet.
+
+    Returns
+    -------
+    ShapeletsArray
+        A (widths, n, signals) array with the scalogram of each signal, complex for the Morlet wavelet.  The
+        coefficients for a width are those obtained by convolving the signal with the wavelet sampled on
+        ``min(10 * width, n)`` points, as ``scipy.signal.cwt`` does.
+
+    Examples
+    --------
+    >>> import shapelets.compute as sc
+    >>> x = sc.random.randn((256, 10))
+    >>> sc.fft.cwt(x, sc.arange(1, 31)).shape
+    (30, 256, 10)
+    """
+    return _pygauss.cwt(signal, widths, __convertWavelet(wavelet), omega0)
+
+
+def welch(signal: ArrayLike, segment_length: int = 256, overlap: Optional[int] = None,
+          window: WindowType = 'hann', fs: float = 1.0) -> ShapeletsArray:
+    r"""
+    Estimates the power spectral density using Welch's method.
+
+    The signals are split in overlapping segments, which are detrended (mean removed) and tapered with the
+    window; the periodograms of all the segments are averaged.  The segments of all the signals are transformed
+    at once, with a single batched real FFT.
+
+    Parameters
+    ----------
+    signal: ArrayLike
+        Column vector or matrix whose columns are the signals, all of the same length.
+
+    segment_length: int, defaults to 256
+        Length of each segment; it cannot exceed the length of the signals.
+
+    overlap: Optional int, defaults to None
+        Points shared by consecutive segments.  When not set, half the segment length.
+
+    window: WindowType, defaults to 'hann'
+        Periodic window applied to every segment: 'hann', 'hamming' or 'boxcar'.
+
+    fs: float, defaults to 1.0
+        Sampling frequency.
+
+    Returns
+    -------
+    ShapeletsArray
+        A (segment_length // 2 + 1, signals) array with the one sided power spectral density of each signal, at
+        the frequencies given by ``rfftfreq(segment_length, 1 / fs)``.  Values match ``scipy.signal.welch`` with
+        its default density scaling.
+
+    Examples
+    --------
+    >>> import shapelets.compute as sc
+    >>> x = sc.random.randn((1024, 10))
+    >>> sc.fft.welch(x, 128).shape
+    (65, 10)
+    """
+    return _pygauss.welch(signal, segment_length, overlap, __convertWindow(window), fs)
+
+
 __all__ = [
     "fft",
     "ifft",
@@ -351,5 +454,9 @@ __all__ = [
     "rfftfreq",
     "spectral_derivative",
     "fftshift",
-    "NormType"
+    "cwt",
+    "welch",
+    "NormType",
+    "WaveletType",
+    "WindowType"
 ]
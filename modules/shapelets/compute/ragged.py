@@ -0,0 +1,97 @@
+# Copyright (c) 2021 Grumpy Cat Software S.L.
+#
+# This Source Code is licensed under the MIT 2.0 license.
+# the terms can be found in  LICENSE.md at the root of
+# this project, or at http://mozilla.org/MPL/2.0/.
+
+from __future__ import annotations
+
+from ._array_obj import ShapeletsArray
+
+from . import _pygauss
+from . import distances as _distances
+from . import features as _features
+
+RaggedArray = _pygauss.RaggedArray
+"""
+Collection of time series of different lengths, stored as a single vector with the values of
+all the series, one after the other, and a vector of offsets, so the i-th series is found in
+``values[offsets[i]:offsets[i + 1]]``.
+
+It is built either from a list of vectors or from its values and offsets.
+"""
+
+
+def feature(tss: RaggedArray, feature: _features.FeatureLike) -> ShapeletsArray:
+    """
+    Computes a feature of every series in a ragged collection, without padding them.
+
+    Only the following features are supported: ``abs_energy``, ``absolute_sum_of_changes``,
+    ``count_above_mean``, ``count_below_mean``, ``length``, ``maximum``, ``mean``,
+    ``mean_absolute_change``, ``minimum``, ``standard_deviation``, ``sum_values`` and
+    ``variance``.
+
+    Parameters
+    ----------
+    tss: RaggedArray
+        Collection of series.
+
+    feature: Feature or str
+        Feature to compute.
+
+    Returns
+    -------
+    ShapeletsArray
+        A row vector with the value of the feature for each series.
+    """
+    return _pygauss.ragged_feature(tss, _features._convert_feature(feature))
+
+
+def znorm(tss: RaggedArray, ddof: int = 0) -> RaggedArray:
+    """
+    Adjusts every series of a ragged collection for zero mean and one as standard deviation.
+
+    Parameters
+    ----------
+    tss: RaggedArray
+        Collection of series.
+
+    ddof: int (default: 0)
+        Degrees of freedom for the standard deviation.
+
+    Returns
+    -------
+    RaggedArray
+        A collection with the same offsets.
+    """
+    return _pygauss.ragged_znorm(tss, ddof)
+
+
+def pdist(tss: RaggedArray, metric: _distances.DistanceType, **kwargs) -> ShapeletsArray:
+    """
+    Distances between every pair of series in a ragged collection.
+
+    Only metrics accepting series of different lengths are supported: the elastic family,
+    ``mpdist`` and ``sbd``.
+
+    Returns
+    -------
+    ShapeletsArray
+        A square matrix with as many rows as series.
+    """
+    return _pygauss.ragged_pdist(tss, _distances._convert_dst_type(metric), **kwargs)
+
+
+def cdist(xa: RaggedArray, xb: RaggedArray, metric: _distances.DistanceType, **kwargs) -> ShapeletsArray:
+    """
+    Distances between every series in ``xa`` and every series in ``xb``.
+
+    Only metrics accepting series of different lengths are supported: the elastic family,
+    ``mpdist`` and ``sbd``.
+
+    Returns
+    -------
+    ShapeletsArray
+        A matrix with one row per series in ``xa`` and one column per series in ``xb``.
+    """
+    return _pygauss.ragged_cdist(xa, xb, _distances._convert_dst_type(metric), **kwargs)
@@ -0,0 +1,258 @@
+# Copyright (c) 2021 Grumpy Cat Software S.L.
+#
+# This Source Code is licensed under the MIT 2.0 license.
+# the terms can be found in  LICENSE.md at the root of
+# this project, or at http://mozilla.org/MPL/2.0/.
+
+import shapelets.compute as sc
+import numpy as np
+
+
+def __blobs(rng, centers, per_cluster, scale=0.1):
+    data = [c[:, None] + scale * rng.normal(size=(len(c), per_cluster)) for c in centers]
+    return np.concatenate(data, axis=1), np.repeat(np.arange(len(centers)), per_cluster)
+
+
+def __lloyd_reference(data, centroids, iterations):
+    centroids = centroids.copy()
+    for _ in range(iterations):
+        d = ((data[:, None, :] - centroids[:, :, None]) ** 2).sum(axis=0)
+        labels = d.argmin(axis=0)
+        for c in range(centroids.shape[1]):
+            if np.any(labels == c):
+                centroids[:, c] = data[:, labels == c].mean(axis=1)
+    d = ((data[:, None, :] - centroids[:, :, None]) ** 2).sum(axis=0)
+    return d.argmin(axis=0), centroids
+
+
+def test_kmeans_separated_clusters():
+    rng = np.random.default_rng(0)
+    centers = [np.full(8, v) for v in (-10.0, 0.0, 10.0, 20.0)]
+    data, truth = __blobs(rng, centers, 50)
+
+    km = sc.clustering.KMeans(4, engine=sc.random.random_engine(seed=7))
+    labels = np.array(km.fit_predict(data)).ravel()
+
+    # k-means++ seeding must recover the clusters, up to a permutation of the labels
+    for c in range(4):
+        assert len(np.unique(labels[truth == c])) == 1
+    assert len(np.unique(labels)) == 4
+    assert np.array_equal(np.array(km.predict(data)).ravel(), labels)
+
+
+def test_kmeans_matches_lloyd():
+    rng = np.random.default_rng(1)
+    data = rng.normal(size=(6, 300))
+    initial = data[:, :5].copy()
+
+    km = sc.clustering.KMeans(5, tolerance=0.0, max_iterations=10)
+    km.fit(data, initial)
+
+    labels, centroids = __lloyd_reference(data, initial, 10)
+    assert np.array_equal(np.array(km.labels_).ravel(), labels)
+    assert km.centroids_.same_as(centroids)
+
+
+def test_kmeans_hamerly_matches_lloyd():
+    rng = np.random.default_rng(2)
+    centers = [rng.normal(scale=3.0, size=16) for _ in range(12)]
+    data, _ = __blobs(rng, centers, 40, scale=1.0)
+    initial = data[:, ::40].copy()
+
+    lloyd = sc.clustering.KMeans(12, tolerance=0.0, max_iterations=50)
+    lloyd.fit(data, initial)
+
+    hamerly = sc.clustering.KMeans(12, tolerance=0.0, max_iterations=50, algorithm='hamerly')
+    hamerly.fit(data, initial)
+
+    assert np.array_equal(np.array(hamerly.labels_).ravel(), np.array(lloyd.labels_).ravel())
+    assert hamerly.centroids_.same_as(lloyd.centroids_)
+
+
+def test_minibatch_kmeans_streaming():
+    rng = np.random.default_rng(3)
+    centers = [np.full(8, v) for v in (-10.0, 0.0, 10.0)]
+    data, truth = __blobs(rng, centers, 200)
+    order = rng.permutation(data.shape[1])
+    data, truth = data[:, order], truth[order]
+
+    mbk = sc.clustering.MiniBatchKMeans(3, batch_size=64, engine=sc.random.random_engine(seed=3))
+    mbk.fit(data)
+    assert mbk.n_seen_ == 600
+
+    # every centroid is the running mean of the series it absorbed
+    assert np.isclose(np.array(mbk.counts_).sum(), 600)
+    labels = np.array(mbk.predict(data)).ravel()
+    for c in range(3):
+        assert len(np.unique(labels[truth == c])) == 1
+
+    # resume from a persisted state with a generator of chunks
+    resumed = sc.clustering.MiniBatchKMeans(3, centroids=np.array(mbk.centroids_), counts=np.array(mbk.counts_),
+                                            n_seen=mbk.n_seen_)
+    resumed.fit(data[:, i:i + 100] for i in range(0, 600, 100))
+    assert resumed.n_seen_ == 1200
+    assert np.array_equal(np.array(resumed.predict(data)).ravel(), labels)
+
+
+def __znorm(x, ddof):
+    return (x - x.mean(axis=0)) / x.std(axis=0, ddof=ddof)
+
+
+def __shape_extraction_reference(subset):
+    m = subset.shape[0]
+    p = np.eye(m) - 1.0 / m
+    _, vectors = np.linalg.eigh(p @ subset @ subset.T @ p)
+    c = vectors[:, -1]
+    if np.linalg.norm(subset[:, 0] - c) >= np.linalg.norm(subset[:, 0] + c):
+        c = -c
+    return __znorm(c, 1)
+
+
+def test_kshape_shape_extraction():
+    rng = np.random.default_rng(4)
+    t = np.linspace(0, 4 * np.pi, 64)
+    shapes = [np.sin(t), np.sign(np.sin(t)), t % np.pi]
+    data = np.concatenate([s[:, None] + 0.3 * rng.normal(size=(64, 20)) for s in shapes], axis=1)
+    labels = np.repeat(np.arange(3), 20).astype(np.uint32)
+
+    ks = sc.clustering.KShape(3, max_iterations=0)
+    ks.fit(data, labels)
+
+    normalized = __znorm(data, 1)
+    expected = np.stack([__shape_extraction_reference(normalized[:, labels == c]) for c in range(3)], axis=1)
+    assert ks.centroids_.same_as(expected)
+
+
+def test_kshape_classify_ncc():
+    rng = np.random.default_rng(5)
+    data = rng.normal(size=(40, 50))
+    centroids = __znorm(rng.normal(size=(40, 4)), 1)
+
+    normalized = __znorm(data, 1)
+    ncc = np.array([[np.correlate(normalized[:, i], centroids[:, c], mode='full').max() /
+                     (np.linalg.norm(normalized[:, i]) * np.linalg.norm(centroids[:, c]))
+                     for c in range(4)] for i in range(50)])
+
+    ks = sc.clustering.KShape(4)
+    ks.centroids_ = centroids
+    assert np.array_equal(np.array(ks.predict(data)).ravel(), ncc.argmax(axis=1))
+
+
+def test_kmedoids_optimal_cost():
+    import itertools
+    rng = np.random.default_rng(6)
+    centers = [np.full(6, v) for v in (-4.0, 0.0, 4.0)]
+    data, _ = __blobs(rng, centers, 5, scale=0.5)
+    dist = np.sqrt(((data[:, :, None] - data[:, None, :]) ** 2).sum(axis=0))
+
+    best = min(dist[:, list(m)].min(axis=1).sum() for m in itertools.combinations(range(15), 3))
+    condensed = dist[np.triu_indices(15, 1)]
+
+    km = sc.clustering.KMedoids(3, metric='precomputed')
+    km.fit(condensed)
+    medoids = np.array(km.medoids_).ravel()
+    assert np.isclose(dist[:, medoids].min(axis=1).sum(), best)
+    assert np.array_equal(np.array(km.labels_).ravel(), dist[:, medoids].argmin(axis=1))
+
+    # condensed matrices given as a row are accepted as well
+    row = sc.clustering.KMedoids(3, metric='precomputed')
+    row.fit(condensed.reshape(1, -1))
+    assert np.array_equal(np.array(row.medoids_).ravel(), medoids)
+
+    lazy = sc.clustering.KMedoids(3, metric='euclidean', cache_rows=4)
+    lazy.fit(data)
+    medoids = np.array(lazy.medoids_).ravel()
+    assert np.isclose(dist[:, medoids].min(axis=1).sum(), best)
+    assert np.array_equal(np.array(lazy.predict(data)).ravel(), np.array(lazy.labels_).ravel())
+
+
+def test_linkage_matches_scipy():
+    from scipy.cluster.hierarchy import linkage
+    from scipy.spatial.distance import pdist
+    rng = np.random.default_rng(7)
+    data = rng.normal(size=(6, 40))
+    condensed = pdist(data.T)
+
+    for method in ('single', 'complete', 'average', 'ward'):
+        expected = linkage(condensed, method)
+        precomputed = np.array(sc.clustering.linkage(condensed, method, metric='precomputed'))
+        computed = np.array(sc.clustering.linkage(data, method))
+        row = np.array(sc.clustering.linkage(condensed.reshape(1, -1), method, metric='precomputed'))
+        assert np.allclose(precomputed, expected)
+        assert np.allclose(computed, expected)
+        assert np.allclose(row, expected)
+
+
+def __assert_partition(labels, truth):
+    for c in np.unique(truth):
+        members = labels[truth == c]
+        assert np.all(members == members[0]) and members[0] >= 0
+        assert not np.any(labels[truth != c] == members[0])
+
+
+def test_density_clustering_with_noise():
+    rng = np.random.default_rng(8)
+    centers = [np.full(4, v) for v in (-10.0, 0.0, 10.0)]
+    data, truth = __blobs(rng, centers, 15, scale=0.2)
+    outliers = np.array([[40.0, -40.0], [40.0, -40.0], [-40.0, 40.0], [0.0, 0.0]])
+    data = np.concatenate([data, outliers], axis=1)
+
+    db = sc.clustering.DBSCAN(2.0, min_samples=4)
+    labels = np.array(db.fit_predict(data)).ravel()
+    __assert_partition(labels[:45], truth)
+    assert np.all(labels[45:] == -1)
+    assert np.all(np.array(db.core_).ravel()[:45])
+
+    # a metric without the triangle inequality goes through the blocked range queries
+    sq = sc.clustering.DBSCAN(4.0, min_samples=4, metric='squared_euclidean')
+    assert np.array_equal(np.array(sq.fit_predict(data)).ravel(), labels)
+
+    hdb = sc.clustering.HDBSCAN(min_cluster_size=5)
+    labels = np.array(hdb.fit_predict(data)).ravel()
+    __assert_partition(labels[:45], truth)
+    assert np.all(labels[45:] == -1)
+
+
+def test_restarts_are_reproducible():
+    rng = np.random.default_rng(9)
+    centers = [np.full(8, v) for v in (-10.0, 0.0, 10.0, 20.0)]
+    data, truth = __blobs(rng, centers, 20)
+
+    km = sc.clustering.KMeans(4, n_init=6, seed=3)
+    labels = np.array(km.fit_predict(data)).ravel()
+    __assert_partition(labels, truth)
+
+    d = ((data[:, None, :] - np.array(km.centroids_)[:, :, None]) ** 2).sum(axis=0)
+    assert np.isclose(km.inertia_, d.min(axis=0).sum())
+
+    again = sc.clustering.KMeans(4, n_init=6, seed=3, algorithm='hamerly')
+    __assert_partition(np.array(again.fit_predict(data)).ravel(), truth)
+
+    t = np.linspace(0, 4 * np.pi, 48)
+    shapes = np.concatenate([s[:, None] + 0.1 * rng.normal(size=(48, 10)) for s in (np.sin(t), np.sign(np.sin(t)))],
+                            axis=1)
+    first = sc.clustering.KShape(2, n_init=4, seed=1)
+    second = sc.clustering.KShape(2, n_init=4, seed=1)
+    assert np.array_equal(np.array(first.fit_predict(shapes)), np.array(second.fit_predict(shapes)))
+    assert np.isclose(first.inertia_, second.inertia_)
+
+
+def test_kshape_compiled_classifier():
+    rng = np.random.default_rng(10)
+    data = rng.normal(size=(40, 150))
+    centroids = __znorm(rng.normal(size=(40, 4)), 1)
+
+    ks = sc.clustering.KShape(4)
+    ks.centroids_ = centroids
+    expected = np.array(ks.predict(data)).ravel()
+
+    classifier = ks.compile(batch_size=64)
+    assert classifier.batch_size == 64
+    assert np.array_equal(np.array(classifier.predict(data)).ravel(), expected)
+
+    labels, similarity = classifier.score(data[:, :5])
+    normalized = __znorm(data[:, :5], 1)
+    ncc = [np.correlate(normalized[:, i], centroids[:, expected[i]], mode='full').max() /
+           (np.linalg.norm(normalized[:, i]) * np.linalg.norm(centroids[:, expected[i]])) for i in range(5)]
+    assert np.array_equal(np.array(labels).ravel(), expected[:5])
+    assert np.allclose(np.array(similarity).ravel(), ncc, atol=1e-5)
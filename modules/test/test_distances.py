@@ -8,6 +8,7 @@ import shapelets.compute as sc
 from shapelets.compute.distances import DistanceType
 import os
 import numpy as np
+import pytest
 
 
 def test_dist_euclidean():
@@ -186,6 +187,22 @@ def test_dist_sbd():
     ])
 
 
+def test_dist_sbd_unequal_lengths():
+    rng = np.random.default_rng(1)
+    a = rng.normal(size=(17, 5))
+    b = rng.normal(size=(11, 9))
+
+    expected = np.zeros((5, 9))
+    for i in range(5):
+        for j in range(9):
+            cc = np.correlate(a[:, i], b[:, j], mode='full')
+            expected[i, j] = 1.0 - cc.max() / (np.linalg.norm(a[:, i]) * np.linalg.norm(b[:, j]))
+
+    assert sc.distances.sbd(a, b).same_as(expected)
+    assert sc.distances.sbd(b, a).same_as(expected.T)
+    assert sc.distances.pdist(a, 'sbd').same_as(np.array(sc.distances.cdist(a, a, 'sbd')) * (1 - np.eye(5)))
+
+
 def test_dist_dtw():
     a = sc.array([[0, 0, 1],
                   [0, 1, 0],
@@ -215,6 +232,62 @@ def test_dist_dtw():
     ])
 
 
+def __erp_reference(a, b, g):
+    n, m = len(a), len(b)
+    d = np.zeros((n + 1, m + 1))
+    d[1:, 0] = np.cumsum(np.abs(a - g))
+    d[0, 1:] = np.cumsum(np.abs(b - g))
+    for i in range(1, n + 1):
+        for j in range(1, m + 1):
+            d[i, j] = min(d[i - 1, j - 1] + abs(a[i - 1] - b[j - 1]),
+                          d[i - 1, j] + abs(a[i - 1] - g),
+                          d[i, j - 1] + abs(b[j - 1] - g))
+    return d[n, m]
+
+
+def __lcss_reference(a, b, epsilon):
+    n, m = len(a), len(b)
+    d = np.zeros((n + 1, m + 1))
+    for i in range(1, n + 1):
+        for j in range(1, m + 1):
+            if abs(a[i - 1] - b[j - 1]) <= epsilon:
+                d[i, j] = d[i - 1, j - 1] + 1
+            else:
+                d[i, j] = max(d[i - 1, j], d[i, j - 1])
+    return 1.0 - d[n, m] / min(n, m)
+
+
+def test_dist_elastic():
+    a = np.random.randn(12, 3)
+    b = np.random.randn(12, 5)
+
+    erp = np.array(sc.distances.erp(a, b, g=0.5))
+    lcss = np.array(sc.distances.lcss(a, b, epsilon=0.5))
+    for i in range(3):
+        for j in range(5):
+            assert np.isclose(erp[i, j], __erp_reference(a[:, i], b[:, j], 0.5))
+            assert np.isclose(lcss[i, j], __lcss_reference(a[:, i], b[:, j], 0.5))
+
+    # banded versions can only be greater or equal than the unconstrained ones
+    for fn in [sc.distances.dtw, sc.distances.ddtw, sc.distances.wdtw, sc.distances.msm, sc.distances.twe]:
+        full = np.array(fn(a, b))
+        banded = np.array(fn(a, b, window=0.1))
+        assert np.all(banded >= full - 1e-9)
+        assert np.allclose(np.diag(np.array(fn(a, a))), 0.0)
+
+    # abandoned pairs are reported as infinity, the rest are untouched
+    for fn in [sc.distances.dtw, sc.distances.ddtw, sc.distances.wdtw, sc.distances.erp, sc.distances.msm,
+               sc.distances.twe]:
+        full = np.array(fn(a, b))
+        for cutoff in np.quantile(full, [0.1, 0.5, 0.9]):
+            abandoned = np.array(fn(a, b, cutoff=float(cutoff)))
+            assert np.all(np.isinf(abandoned[full > cutoff]))
+            assert np.allclose(abandoned[full <= cutoff], full[full <= cutoff])
+
+    # the optimal path of ERP may run through the first column while the rest of the row exceeds the cutoff
+    assert np.isclose(np.array(sc.distances.erp(np.array([[0.0], [5.0]]), np.array([[5.0]]), cutoff=1.0))[0, 0], 0.0)
+
+
 def test_dist_mpdist():
     ts = sc.array([1., 2, 3, 1, 2, 3, 4, 5, 6, 0, 0, 1, 1, 2, 2, 4, 5, 1, 1, 9], dtype="float64")
     query = sc.array([0.23595094, 0.9865171, 0.1934413, 0.60880883, 0.55174926, 0.77139988, 0.33529215, 0.63215848],
@@ -234,6 +307,92 @@ def test_dist_mpdist_against_data():
     assert sc.distances.mpdist(ts, tsb, w).same_as([0.])
 
 
+def __mpdist_reference(a, b, w, threshold):
+    def windows(x):
+        z = np.lib.stride_tricks.sliding_window_view(x, w)
+        return (z - z.mean(axis=1, keepdims=True)) / z.std(axis=1, keepdims=True)
+
+    za, zb = windows(a), windows(b)
+    d = np.sqrt(np.maximum(2.0 * (w - za @ zb.T), 0.0))
+    profiles = np.sort(np.concatenate([d.min(axis=1), d.min(axis=0)]))
+    k = min(len(profiles) - 1, max(0, int(np.ceil(threshold * (len(a) + len(b)))) - 1))
+    return profiles[k]
+
+
+def test_dist_mpdist_batched():
+    rng = np.random.default_rng(3)
+    a = np.cumsum(rng.normal(size=(150, 4)), axis=0)
+    b = np.cumsum(rng.normal(size=(120, 6)), axis=0)
+
+    # small thresholds select on the device, large ones on the host
+    for threshold in [0.05, 1.0]:
+        expected = np.array([[__mpdist_reference(a[:, i], b[:, j], 16, threshold) for j in range(6)]
+                             for i in range(4)])
+        assert sc.distances.cdist(a, b, 'mpdist', w=16, threshold=threshold).same_as(expected)
+
+    pd = np.array(sc.distances.pdist(b, 'mpdist', w=16))
+    assert np.allclose(pd, pd.T)
+    assert np.allclose(np.diag(pd), 0.0)
+
+
+def test_dist_mpdist_tiled():
+    # more pairs of subsequences than evaluated at once, so the profiles are reduced over several tiles
+    rng = np.random.default_rng(4)
+    a = np.cumsum(rng.normal(size=4500))
+    b = np.cumsum(rng.normal(size=4200))
+    expected = __mpdist_reference(a, b, 16, 0.05)
+    assert np.allclose(np.array(sc.distances.mpdist(a, b, 16)).item(), expected)
+
+
+def test_dist_knn():
+    a = sc.array([[0, 0, 1],
+                  [0, 1, 0],
+                  [1, 0, 0]], dtype="float32")
+
+    b = sc.array([
+        [0, 0, 0.0, 0, 1, 1, 1, 1],
+        [0, 0, 1.3, 1, 0, 0, 1, 1],
+        [0, 1, 0.0, 1, 0, 1, 0, 1]
+    ], dtype="float32")
+
+    full = np.array(sc.distances.manhattan(a, b))
+    for block_size in [1, 3, 8, 16]:
+        d, i = sc.distances.knn(a, b, 3, 'manhattan', block_size=block_size)
+        assert d.same_as(np.sort(full, axis=1)[:, :3])
+        assert np.allclose(np.take_along_axis(full, np.array(i).astype(np.int64), axis=1), np.array(d))
+
+
+def test_dist_metric_index():
+    data = sc.random.randn((16, 500), dtype="float64")
+    queries = sc.random.randn((16, 7), dtype="float64")
+    full = np.array(sc.distances.euclidean(queries, data))
+
+    index = sc.distances.MetricIndex(data, 'euclidean', leaf_size=8)
+    assert index.size == 500
+
+    d, i = index.knn(queries, 5)
+    assert d.same_as(np.sort(full, axis=1)[:, :5])
+    assert np.allclose(np.take_along_axis(full, np.array(i).astype(np.int64), axis=1), np.array(d))
+
+    radius = float(np.median(full))
+    rd, ri, offsets = index.range(queries, radius)
+    offsets = np.array(offsets).ravel()
+    for q in range(7):
+        assert offsets[q + 1] - offsets[q] == np.count_nonzero(full[q] <= radius)
+
+    restored = sc.distances.MetricIndex.from_bytes(index.to_bytes(), data, 'euclidean')
+    d2, i2 = restored.knn(queries, 5)
+    assert d2.same_as(d)
+
+    # truncated or corrupt streams are rejected before any search takes place
+    raw = bytes(index.to_bytes())
+    corrupt = bytearray(raw)
+    corrupt[40:48] = (10 ** 9).to_bytes(8, 'little')
+    for stream in [raw[:-1], raw[:20], bytes(corrupt)]:
+        with pytest.raises(RuntimeError):
+            sc.distances.MetricIndex.from_bytes(stream, data, 'euclidean')
+
+
 def test_dist_should_not_throw():
     a = sc.array([[0, 0, 1], [0, 1, 0], [1, 0, 0]], dtype="float32")
     b = sc.array([[0, 0, 0, 0, 1, 1, 1, 1], [0, 0, 1, 1, 0, 0, 1, 1], [0, 1, 0, 1, 0, 1, 0, 1]], dtype="float32")
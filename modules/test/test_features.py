@@ -0,0 +1,170 @@
+# Copyright (c) 2021 Grumpy Cat Software S.L.
+#
+# This Source Code is licensed under the MIT 2.0 license.
+# the terms can be found in  LICENSE.md at the root of
+# this project, or at http://mozilla.org/MPL/2.0/.
+
+import shapelets.compute as sc
+import numpy as np
+import pytest
+
+Feature = sc.features.Feature
+
+__params = {
+    Feature.ApproximateEntropy: (2, 0.5),
+    Feature.BinnedEntropy: (10,),
+    Feature.C3: (2,),
+    Feature.CidCe: (1,),
+    Feature.EnergyRatioByChunks: (4, 1),
+    Feature.FftCoefficientReal: (3,),
+    Feature.FftCoefficientImag: (3,),
+    Feature.FftCoefficientAbs: (3,),
+    Feature.FftCoefficientAngle: (3,),
+    Feature.IndexMassQuantile: (0.5,),
+    Feature.LargeStandardDeviation: (0.2,),
+    Feature.NumberCrossingM: (0,),
+    Feature.NumberCwtPeaks: (5,),
+    Feature.NumberPeaks: (2,),
+    Feature.RangeCount: (-1, 1),
+    Feature.RatioBeyondRSigma: (1,),
+    Feature.SpktWelchDensity: (2,),
+    Feature.SymmetryLooking: (0.2,),
+    Feature.TimeReversalAsymmetryStatistic: (2,),
+    Feature.ValueCount: (0,),
+}
+
+
+def __data(rows=64, cols=10):
+    # half integers keep duplicated values around, so the reoccurring features are exercised
+    rng = np.random.default_rng(0)
+    return rng.integers(-8, 8, size=(rows, cols)).astype(np.float64) / 2.0
+
+
+def test_feature_set_matches_every_feature():
+    data = __data()
+    specs = [(f, __params.get(f, ())) for f in Feature.__members__.values()]
+    values = np.array(sc.features.FeatureSet(specs).compute(data, block_size=4))
+
+    assert values.shape == (len(specs), data.shape[1])
+    for row, (f, params) in enumerate(specs):
+        expected = np.array(sc.features.feature(data, f, params)).ravel()
+        assert np.allclose(values[row], expected, equal_nan=True), f
+
+
+def test_feature_names():
+    data = __data()
+    fs = sc.features.FeatureSet(['abs_energy', ('energy_ratio_by_chunks', (4, 1))])
+    values = np.array(fs.compute(data))
+
+    assert len(fs) == 2
+    assert np.allclose(values[0], (data ** 2).sum(axis=0))
+    energy = (data ** 2).sum(axis=0)
+    assert np.allclose(values[1], (data[16:32] ** 2).sum(axis=0) / energy)
+
+
+def test_energy_ratio_by_chunks_is_validated():
+    data = __data()
+    with pytest.raises(ValueError):
+        sc.features.FeatureSet([(Feature.EnergyRatioByChunks, (4, 4))]).compute(data)
+    with pytest.raises(ValueError):
+        sc.features.FeatureSet([(Feature.EnergyRatioByChunks, (0, 0))]).compute(data)
+    with pytest.raises(ValueError):
+        sc.features.feature(data, Feature.EnergyRatioByChunks, (4,))
+
+
+def __rolling_reference(x, window, step):
+    # one row per window, straight from numpy
+    w = np.stack([x[s:s + window] for s in range(0, len(x) - window + 1, step)])
+    n = float(window)
+    mean = w.mean(axis=1)
+    c = w - mean[:, None]
+    m2 = (c ** 2).mean(axis=1)
+    m3 = (c ** 3).mean(axis=1)
+    m4 = (c ** 4).mean(axis=1)
+    skew = n * n / ((n - 1) * (n - 2)) * m3 / m2 ** 1.5
+    kurt = (n * (n + 1)) / ((n - 1) * (n - 2) * (n - 3)) * n * m4 / m2 ** 2 - \
+        3 * (n - 1) ** 2 / ((n - 2) * (n - 3))
+    return {
+        'mean': mean,
+        'variance': m2,
+        'standard_deviation': np.sqrt(m2),
+        'skewness': skew,
+        'kurtosis': kurt,
+        'sum_values': w.sum(axis=1),
+        'abs_energy': (w ** 2).sum(axis=1),
+        'maximum': w.max(axis=1),
+        'minimum': w.min(axis=1),
+        'first_location_of_maximum': w.argmax(axis=1) / n,
+        'first_location_of_minimum': w.argmin(axis=1) / n,
+        'last_location_of_maximum': 1.0 - w[:, ::-1].argmax(axis=1) / n,
+        'last_location_of_minimum': 1.0 - w[:, ::-1].argmin(axis=1) / n,
+        'count_above_mean': (w > mean[:, None]).sum(axis=1),
+        'count_below_mean': (w < mean[:, None]).sum(axis=1),
+    }
+
+
+def test_rolling_features():
+    # continuous values, so no value of a window lands exactly on its mean
+    data = np.random.default_rng(1).normal(size=(200, 3))
+    for window, step in ((16, 1), (25, 7), (200, 1)):
+        names = list(__rolling_reference(data[:, 0], window, step).keys())
+        values = np.array(sc.features.rolling(data, window, names, step=step))
+        for col in range(data.shape[1]):
+            expected = __rolling_reference(data[:, col], window, step)
+            for f, name in enumerate(names):
+                assert np.allclose(values[:, f, col], expected[name], equal_nan=True), (name, window, step)
+
+
+def test_rolling_features_on_trending_series():
+    # a ramp far away from zero: every window has the same central moments, which a single shift for the
+    # whole series cannot recover once the power sums are dominated by the trend
+    n, window = 200000, 64
+    data = 1e6 + 0.25 * np.arange(n, dtype=np.float64) + np.tile([0.0, 1.0, 0.0, -1.0], n // 4)
+    names = ['mean', 'variance', 'skewness', 'kurtosis']
+    values = np.array(sc.features.rolling(data[:, None], window, names, step=3))
+    expected = __rolling_reference(data, window, 3)
+    values = values.reshape(len(expected['mean']), len(names))
+    for f, name in enumerate(names):
+        assert np.allclose(values[:, f], expected[name], rtol=1e-7, atol=1e-7), name
+
+
+def test_energy_ratio_by_chunks_with_trailing_values():
+    # 66 values in 4 segments of 16: the last two values only count towards the total energy
+    data = np.random.default_rng(2).normal(size=(66, 3))
+    energy = (data ** 2).sum(axis=0)
+    for focus in range(4):
+        expected = (data[16 * focus:16 * (focus + 1)] ** 2).sum(axis=0) / energy
+        actual = np.array(sc.features.feature(data, 'energy_ratio_by_chunks', (4, focus))).ravel()
+        assert np.allclose(actual, expected)
+
+
+def __entropy_data():
+    t = np.arange(200, dtype=np.float64)
+    first = np.sin(0.7 * t) + 0.5 * np.cos(2.3 * t) + 0.1 * ((t * 37) % 11)
+    second = np.cumsum(np.sin(1.3 * t) * np.cos(0.11 * t * t))
+    return np.stack([first, second], axis=1)
+
+
+# values computed by the former brute force implementation, comparing every pair of templates
+__approximate_entropy_baseline = {
+    (1, 0.1): [2.072930244771, 1.069570225831],
+    (1, 0.3): [1.728677111368, 0.325623283300],
+    (1, 0.6): [1.133780834230, 0.126609244040],
+    (2, 0.1): [0.259122769958, 0.763345223049],
+    (2, 0.3): [1.132916002436, 0.312927150567],
+    (2, 0.6): [0.997704084708, 0.108596678685],
+    (3, 0.1): [0.001938184716, 0.429077822939],
+    (3, 0.3): [0.251160716145, 0.295941463146],
+    (3, 0.6): [0.733538298571, 0.101783832063],
+}
+
+
+@pytest.mark.parametrize("m,r", sorted(__approximate_entropy_baseline.keys()))
+def test_approximate_entropy_baseline(m, r):
+    actual = np.array(sc.features.feature(__entropy_data(), 'approximate_entropy', (m, r))).ravel()
+    assert np.allclose(actual, __approximate_entropy_baseline[(m, r)], rtol=0, atol=1e-9)
+
+
+def test_sample_entropy_baseline():
+    actual = np.array(sc.features.feature(__entropy_data(), 'sample_entropy')).ravel()
+    assert np.allclose(actual, [2.255950876480, 2.024116185983], rtol=0, atol=1e-9)
@@ -0,0 +1,76 @@
+# Copyright (c) 2021 Grumpy Cat Software S.L.
+#
+# This Source Code is licensed under the MIT 2.0 license.
+# the terms can be found in  LICENSE.md at the root of
+# this project, or at http://mozilla.org/MPL/2.0/.
+
+import shapelets.compute as sc
+import numpy as np
+import pytest
+
+
+def __series(lengths, seed=0):
+    rng = np.random.default_rng(seed)
+    return [rng.normal(size=n) for n in lengths]
+
+
+__reference = {
+    'abs_energy': lambda x: (x ** 2).sum(),
+    'absolute_sum_of_changes': lambda x: np.abs(np.diff(x)).sum(),
+    'count_above_mean': lambda x: (x > x.mean()).sum(),
+    'count_below_mean': lambda x: (x < x.mean()).sum(),
+    'length': lambda x: len(x),
+    'maximum': lambda x: x.max(),
+    'mean': lambda x: x.mean(),
+    'mean_absolute_change': lambda x: np.abs(np.diff(x)).sum() / len(x),
+    'minimum': lambda x: x.min(),
+    'standard_deviation': lambda x: x.std(),
+    'sum_values': lambda x: x.sum(),
+    'variance': lambda x: x.var(),
+}
+
+
+def test_segmented_features():
+    series = __series([5, 8, 1, 13, 8, 5, 2])
+    ragged = sc.ragged.RaggedArray(series)
+    assert len(ragged) == len(series)
+
+    for name, reference in __reference.items():
+        actual = np.array(sc.ragged.feature(ragged, name)).ravel()
+        expected = np.array([reference(x) for x in series])
+        assert np.allclose(actual, expected), name
+
+    with pytest.raises(ValueError):
+        sc.ragged.feature(ragged, 'kurtosis')
+
+
+def test_values_and_offsets():
+    series = __series([3, 4, 2])
+    ragged = sc.ragged.RaggedArray(np.concatenate(series), np.array([0, 3, 7, 9], dtype=np.uint32))
+    assert np.allclose(np.array(sc.ragged.feature(ragged, 'sum_values')).ravel(), [x.sum() for x in series])
+
+    with pytest.raises(ValueError):
+        sc.ragged.RaggedArray(np.concatenate(series), np.array([0, 3, 3, 9], dtype=np.uint32))
+
+
+def test_segmented_znorm():
+    series = __series([6, 9, 4, 9])
+    normalized = sc.ragged.znorm(sc.ragged.RaggedArray(series))
+    for i, x in enumerate(series):
+        assert np.allclose(np.array(normalized.series(i)).ravel(), (x - x.mean()) / x.std())
+
+
+@pytest.mark.parametrize("metric", ['dtw', 'sbd'])
+def test_distances_match_pairs(metric):
+    # dtw runs on the host pair by pair, sbd groups the series by length and runs the dense kernel per group
+    xa = __series([7, 12, 7, 5, 12], seed=1)
+    xb = __series([12, 4, 7], seed=2)
+    pairs = lambda a, b: np.array(sc.distances.cdist(a[:, None], b[:, None], metric)).item()
+
+    actual = np.array(sc.ragged.pdist(sc.ragged.RaggedArray(xa), metric))
+    expected = np.array([[0.0 if i == j else pairs(a, b) for j, b in enumerate(xa)] for i, a in enumerate(xa)])
+    assert np.allclose(actual, expected)
+
+    actual = np.array(sc.ragged.cdist(sc.ragged.RaggedArray(xa), sc.ragged.RaggedArray(xb), metric))
+    expected = np.array([[pairs(a, b) for b in xb] for a in xa])
+    assert np.allclose(actual, expected)
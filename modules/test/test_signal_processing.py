@@ -51,3 +51,56 @@ def test_sp_convolve():
         b64 = b.astype("float64")
         r64 = sc.convolve1(a64, b64, 'expand', 'frequency')
         assert r64.same_as(r.astype("float64"))
+
+
+def __reference_cwt(x, widths, wavelet):
+    out = np.zeros((len(widths), len(x)), dtype=complex)
+    for i, w in enumerate(widths):
+        n = min(10 * w, len(x))
+        t = (np.arange(n) - (n - 1) / 2.0) / w
+        if wavelet == 'ricker':
+            data = 2 / (np.sqrt(3 * w) * np.pi ** 0.25) * (1 - t ** 2) * np.exp(-t ** 2 / 2)
+        else:
+            data = np.exp(5j * t) * np.exp(-t ** 2 / 2) * np.pi ** -0.25 / np.sqrt(w)
+        out[i] = np.convolve(x, np.conj(data[::-1]), mode='same')
+    return out
+
+
+def test_sp_cwt_matches_direct_convolution():
+    x = np.random.randn(100, 3)
+    widths = np.array([1, 2, 5, 12], dtype="float64")
+    for wavelet in ['ricker', 'morlet']:
+        result = np.array(sc.fft.cwt(x, widths, wavelet))
+        assert result.shape == (4, 100, 3)
+        for c in range(3):
+            expected = __reference_cwt(x[:, c], widths, wavelet)
+            if wavelet == 'ricker':
+                expected = expected.real
+            assert np.allclose(result[:, :, c], expected, atol=1e-8)
+
+
+def __reference_welch(x, nperseg, noverlap, window):
+    k = np.arange(nperseg)
+    if window == 'hann':
+        win = 0.5 - 0.5 * np.cos(2 * np.pi * k / nperseg)
+    elif window == 'hamming':
+        win = 0.54 - 0.46 * np.cos(2 * np.pi * k / nperseg)
+    else:
+        win = np.ones(nperseg)
+    step = nperseg - noverlap
+    starts = range(0, len(x) - nperseg + 1, step)
+    periodograms = [np.abs(np.fft.rfft(win * (x[s:s + nperseg] - np.mean(x[s:s + nperseg])))) ** 2 for s in starts]
+    psd = np.mean(periodograms, axis=0) / np.sum(win * win)
+    last = -1 if nperseg % 2 == 0 else None
+    psd[1:last] *= 2
+    return psd
+
+
+def test_sp_welch_matches_segment_average():
+    x = np.random.randn(300, 4)
+    for nperseg, noverlap, window in [(64, None, 'hann'), (45, 20, 'hamming'), (300, 0, 'boxcar')]:
+        result = np.array(sc.fft.welch(x, nperseg, noverlap, window))
+        assert result.shape == (nperseg // 2 + 1, 4)
+        for c in range(4):
+            expected = __reference_welch(x[:, c], nperseg, nperseg // 2 if noverlap is None else noverlap, window)
+            assert np.allclose(result[:, c], expected, atol=1e-8)
@@ -33,6 +33,40 @@ def test_stats_skewness_kurtosis_moments():
     assert m4.same_as(24.0, eps=0.03)
 
 
+def test_stats_moments_match_numpy():
+    # longer than the 16384 values reduced together, so the partial moments of several chunks are merged
+    data = np.random.randn(200000, 3) * [1.0, 5.0, 0.1] + [0.0, 1e3, -2.0]
+    for dim in [0, 1]:
+        x = data if dim == 0 else data.T
+        centered = x - np.mean(x, axis=dim, keepdims=True)
+        n = x.shape[dim]
+        m2 = np.sum(centered ** 2, axis=dim, keepdims=True) / n
+        m3 = np.sum(centered ** 3, axis=dim, keepdims=True) / n
+        m4 = np.sum(centered ** 4, axis=dim, keepdims=True) / n
+        skew = n * n / ((n - 1) * (n - 2)) * m3 / m2 ** 1.5
+        kurt = n * (n + 1) / ((n - 1) * (n - 2) * (n - 3)) * n * m4 / m2 ** 2 - 3 * (n - 1) ** 2 / ((n - 2) * (n - 3))
+        assert sc.var(x, 1, dim).same_as(np.var(x, axis=dim, ddof=1, keepdims=True))
+        assert sc.std(x, 0, dim).same_as(np.std(x, axis=dim, keepdims=True))
+        assert sc.skewness(x, dim).same_as(skew)
+        assert sc.kurtosis(x, dim).same_as(kurt)
+
+
+def test_stats_merge_moments():
+    data = np.random.randn(1000, 3) * [1.0, 5.0, 0.1] + [0.0, 1e3, -2.0]
+    whole = sc.moments(data)
+    for split in [1, 300, 999]:
+        merged = sc.merge_moments(sc.moments(data[:split]), sc.moments(data[split:]))
+        for expected, actual in zip(whole, merged):
+            assert np.allclose(np.array(actual), np.array(expected))
+
+    centered = data - data.mean(axis=0)
+    assert np.allclose(np.array(whole.count).ravel(), 1000)
+    assert np.allclose(np.array(whole.mean).ravel(), data.mean(axis=0))
+    assert np.allclose(np.array(whole.m2).ravel(), (centered ** 2).sum(axis=0))
+    assert np.allclose(np.array(whole.m3).ravel(), (centered ** 3).sum(axis=0))
+    assert np.allclose(np.array(whole.m4).ravel(), (centered ** 4).sum(axis=0))
+
+
 def test_stats_correlation():
     data = [[1., 2, 3, 4], [2., 3, 4, 5], [3., 4, 5, 6], [7., 8, 9, 0]]
     npr = np.corrcoef(data, rowvar=False)